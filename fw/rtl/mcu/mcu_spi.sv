@@ -2,7 +2,10 @@ module mcu_spi (
     input clk,
     input reset,
 
+    input [1:0] sample_delay,
+
     output logic frame_start,
+    output logic data_request,
     output logic data_ready,
     output logic [7:0] rx_data,
     input [7:0] tx_data,
@@ -15,52 +18,56 @@ module mcu_spi (
 
     logic [2:0] mcu_clk_ff;
     logic [2:0] mcu_cs_ff;
+    logic [3:0] mcu_mosi_ff;
 
     always_ff @(posedge clk) begin
         mcu_clk_ff <= {mcu_clk_ff[1:0], mcu_clk};
         mcu_cs_ff <= {mcu_cs_ff[1:0], mcu_cs};
+        mcu_mosi_ff <= {mcu_mosi_ff[2:0], mcu_mosi};
     end
 
     logic mcu_clk_falling;
-    logic mcu_clk_rising;
     logic mcu_cs_falling;
     logic mcu_cs_rising;
 
     always_comb begin
         mcu_clk_falling = mcu_clk_ff[2] && !mcu_clk_ff[1];
-        mcu_clk_rising = !mcu_clk_ff[2] && mcu_clk_ff[1];
         mcu_cs_falling = mcu_cs_ff[2] && !mcu_cs_ff[1];
         mcu_cs_rising = !mcu_cs_ff[2] && mcu_cs_ff[1];
     end
 
     logic mcu_dq_in;
-    logic mcu_dq_out;
-    logic mcu_miso_out;
-
-    assign mcu_miso = mcu_cs_ff[1] ? 1'bZ : mcu_miso_out;
 
-    always_ff @(posedge clk) begin
-        mcu_dq_in <= mcu_mosi;
-        mcu_miso_out <= mcu_dq_out;
+    always_comb begin
+        case (sample_delay)
+            2'd0: mcu_dq_in = mcu_mosi_ff[3];
+            2'd1: mcu_dq_in = mcu_mosi_ff[2];
+            2'd2: mcu_dq_in = mcu_mosi_ff[1];
+            2'd3: mcu_dq_in = mcu_mosi_ff[0];
+        endcase
     end
 
     logic [7:0] spi_tx_shift;
 
-    assign mcu_dq_out = spi_tx_shift[7];
+    assign mcu_miso = mcu_cs_ff[1] ? 1'bZ : spi_tx_shift[7];
 
     logic spi_enabled;
+    logic spi_byte_started;
     logic [2:0] spi_bit_counter;
 
     always_ff @(posedge clk) begin
         frame_start <= 1'b0;
+        data_request <= 1'b0;
         data_ready <= 1'b0;
 
         if (reset) begin
             spi_enabled <= 1'b0;
+            spi_byte_started <= 1'b0;
             spi_bit_counter <= 3'd0;
         end else begin
             if (mcu_cs_falling) begin
                 spi_enabled <= 1'b1;
+                spi_byte_started <= 1'b0;
                 spi_bit_counter <= 3'd0;
                 frame_start <= 1'b1;
             end
@@ -69,21 +76,27 @@ module mcu_spi (
                 spi_enabled <= 1'b0;
             end
 
-            if (spi_enabled) begin
-                if (mcu_clk_rising) begin
-                    if (spi_bit_counter == 3'd0) begin
-                        spi_tx_shift <= tx_data;
-                    end else begin
-                        spi_tx_shift <= {spi_tx_shift[6:0], 1'b0};
-                    end
-                end
+            // MISO is launched right after MCU sampled previous bit on SCK falling edge,
+            // this gives full SCK period of setup time instead of half. First bit of
+            // each byte follows transmit data until byte starts to pick up late updates
+            // when MCU pauses between transfers, during back-to-back transfers transmit
+            // data is requested one bit ahead so it's ready before byte boundary.
+
+            if (!spi_byte_started) begin
+                spi_tx_shift <= tx_data;
+            end
 
-                if (mcu_clk_falling) begin
-                    spi_bit_counter <= spi_bit_counter + 1'd1;
-                    rx_data <= {rx_data[6:0], mcu_dq_in};
-                    if (spi_bit_counter == 3'd7) begin
-                        data_ready <= 1'b1;
-                    end
+            if (spi_enabled && mcu_clk_falling) begin
+                spi_byte_started <= (spi_bit_counter != 3'd7);
+                spi_bit_counter <= spi_bit_counter + 1'd1;
+                rx_data <= {rx_data[6:0], mcu_dq_in};
+                spi_tx_shift <= {spi_tx_shift[6:0], 1'b0};
+                if (spi_bit_counter == 3'd6) begin
+                    data_request <= 1'b1;
+                end
+                if (spi_bit_counter == 3'd7) begin
+                    data_ready <= 1'b1;
+                    spi_tx_shift <= tx_data;
                 end
             end
         end
@@ -10,6 +10,7 @@ module mcu_top (
     dma_scb.controller sd_dma_scb,
     flash_scb.controller flash_scb,
     vendor_scb.controller vendor_scb,
+    bist_scb.controller bist_scb,
 
     fifo_bus.controller fifo_bus,
     mem_bus.controller mem_bus,
@@ -37,7 +38,10 @@ module mcu_top (
 
     // MCU <-> FPGA transport
 
+    logic [1:0] spi_sample_delay;
+
     logic frame_start;
+    logic data_request;
     logic data_ready;
     logic [7:0] rdata;
     logic [7:0] wdata;
@@ -46,7 +50,10 @@ module mcu_top (
         .clk(clk),
         .reset(reset),
 
+        .sample_delay(spi_sample_delay),
+
         .frame_start(frame_start),
+        .data_request(data_request),
         .data_ready(data_ready),
         .rx_data(rdata),
         .tx_data(wdata),
@@ -62,11 +69,13 @@ module mcu_top (
 
     const bit [7:0] FPGA_ID = 8'h64;
 
-    typedef enum bit [1:0] {
+    typedef enum bit [2:0] {
         PHASE_CMD,
         PHASE_ADDRESS,
         PHASE_DATA,
-        PHASE_NOP
+        PHASE_NOP,
+        PHASE_HEADER,
+        PHASE_STATUS
     } phase_e;
 
     typedef enum bit [7:0] {
@@ -77,16 +86,20 @@ module mcu_top (
         CMD_MEM_WRITE,
         CMD_USB_STATUS,
         CMD_USB_READ,
-        CMD_USB_WRITE
+        CMD_USB_WRITE,
+        CMD_MEM_STREAM_READ,
+        CMD_MEM_STREAM_WRITE
     } cmd_e;
 
     phase_e phase;
     cmd_e cmd;
 
     logic [1:0] counter;
+    logic [1:0] tx_counter;
     logic [7:0] address;
 
     logic reg_read;
+    logic reg_read_start;
     logic reg_write;
     logic [31:0] reg_rdata;
     logic [31:0] reg_wdata;
@@ -96,28 +109,87 @@ module mcu_top (
     logic [15:0] mem_rdata;
     logic [15:0] mem_wdata;
     logic mem_word_select;
+    logic mem_busy;
+
+    logic [2:0] header_counter;
+    logic stream_selected;
+    logic stream_start;
+    logic stream_ready;
+    logic [31:0] stream_address;
+    logic [15:0] stream_length;
+    logic [15:0] stream_count;
+    logic [10:0] stream_index;
+
+    always_comb begin
+        stream_selected = (cmd == CMD_MEM_STREAM_READ) || (cmd == CMD_MEM_STREAM_WRITE);
+    end
 
     always_ff @(posedge clk) begin
         fifo_bus.rx_read <= 1'b0;
         fifo_bus.tx_write <= 1'b0;
 
         reg_read <= 1'b0;
+        reg_read_start <= 1'b0;
         reg_write <= 1'b0;
 
         mem_read <= 1'b0;
         mem_write <= 1'b0;
 
+        stream_start <= 1'b0;
+
         if (reset) begin
         end else begin
             if (frame_start) begin
                 counter <= 2'd0;
+                tx_counter <= 2'd0;
                 phase <= PHASE_CMD;
             end
 
+            // Data for next transmitted byte is prepared while current one is still being shifted
+
+            if (data_request && (phase == PHASE_DATA)) begin
+                tx_counter <= tx_counter + 1'd1;
+
+                if (cmd == CMD_REG_READ) begin
+                    if (tx_counter == 2'd3) begin
+                        reg_read <= 1'd1;
+                    end
+                end
+
+                if (cmd == CMD_MEM_READ) begin
+                    if (tx_counter[0]) begin
+                        mem_read <= 1'b1;
+                        mem_word_select <= ~mem_word_select;
+                    end
+                end
+
+                if (cmd == CMD_MEM_STREAM_READ) begin
+                    if (tx_counter[0]) begin
+                        mem_read <= 1'b1;
+                    end
+                end
+            end
+
+            // Status byte is decided one byte ahead, after MCU received ready status stream switches to data
+
+            if (data_request && (phase == PHASE_STATUS)) begin
+                if (stream_ready && (cmd == CMD_MEM_STREAM_READ)) begin
+                    tx_counter <= 2'd0;
+                    mem_read <= 1'b1;
+                    phase <= PHASE_DATA;
+                end else begin
+                    stream_ready <= !mem_busy;
+                end
+            end
+
             if (reg_read || reg_write || (mem_word_select && (mem_read || mem_write))) begin
                 address <= address + 1'd1;
             end
 
+            if (stream_selected && (mem_read || mem_write)) begin
+                stream_index <= stream_index + 1'd1;
+            end
+
             if (data_ready) begin
                 case (phase)
                     PHASE_CMD: begin
@@ -136,14 +208,42 @@ module mcu_top (
                         if (rdata == CMD_USB_WRITE) begin
                             phase <= PHASE_DATA;
                         end
+
+                        if ((rdata == CMD_MEM_STREAM_READ) || (rdata == CMD_MEM_STREAM_WRITE)) begin
+                            header_counter <= 3'd0;
+                            phase <= PHASE_HEADER;
+                        end
+                    end
+
+                    PHASE_HEADER: begin
+                        header_counter <= header_counter + 1'd1;
+
+                        case (header_counter)
+                            3'd0: stream_address[7:0] <= rdata;
+                            3'd1: stream_address[15:8] <= rdata;
+                            3'd2: stream_address[23:16] <= rdata;
+                            3'd3: stream_address[31:24] <= rdata;
+                            3'd4: stream_length[7:0] <= rdata;
+                            3'd5: stream_length[15:8] <= rdata;
+                        endcase
+
+                        if (header_counter == 3'd5) begin
+                            stream_start <= 1'b1;
+                            stream_ready <= 1'b0;
+                            stream_count <= 16'd0;
+                            stream_index <= 11'd0;
+                            phase <= (cmd == CMD_MEM_STREAM_READ) ? PHASE_STATUS : PHASE_DATA;
+                        end
                     end
 
                     PHASE_ADDRESS: begin
                         address <= rdata;
+                        tx_counter <= 2'd0;
                         phase <= PHASE_DATA;
 
                         if (cmd == CMD_REG_READ) begin
                             reg_read <= 1'b1;
+                            reg_read_start <= 1'b1;
                         end
 
                         if (cmd == CMD_MEM_READ) begin
@@ -155,12 +255,6 @@ module mcu_top (
                     PHASE_DATA: begin
                         counter <= counter + 1'd1;
 
-                        if (cmd == CMD_REG_READ) begin
-                            if (counter == 2'd3) begin
-                                reg_read <= 1'd1;
-                            end
-                        end
-
                         if (cmd == CMD_REG_WRITE) begin
                             case (counter)
                                 2'd0: reg_wdata[7:0] <= rdata;
@@ -173,13 +267,6 @@ module mcu_top (
                             end
                         end
 
-                        if (cmd == CMD_MEM_READ) begin
-                            if (counter[0]) begin
-                                mem_read <= 1'b1;
-                                mem_word_select <= ~mem_word_select;
-                            end
-                        end
-
                         if (cmd == CMD_MEM_WRITE) begin
                             case (counter[0])
                                 1'd0: mem_wdata[15:8] <= rdata;
@@ -191,6 +278,20 @@ module mcu_top (
                             end
                         end
 
+                        if (cmd == CMD_MEM_STREAM_WRITE) begin
+                            stream_count <= stream_count + 1'd1;
+                            case (stream_count[0])
+                                1'd0: mem_wdata[15:8] <= rdata;
+                                1'd1: mem_wdata[7:0] <= rdata;
+                            endcase
+                            if (stream_count[0] || (stream_count == (stream_length - 1'd1))) begin
+                                mem_write <= 1'b1;
+                            end
+                            if (stream_count == (stream_length - 1'd1)) begin
+                                phase <= PHASE_STATUS;
+                            end
+                        end
+
                         if (cmd == CMD_USB_READ) begin
                             phase <= PHASE_NOP;
                         end
@@ -203,6 +304,8 @@ module mcu_top (
                     end
 
                     PHASE_NOP: begin end
+
+                    default: begin end
                 endcase
             end
         end
@@ -217,7 +320,7 @@ module mcu_top (
             end
 
             CMD_REG_READ: begin
-                case (counter)
+                case (tx_counter)
                     2'd0: wdata = reg_rdata[7:0];
                     2'd1: wdata = reg_rdata[15:8];
                     2'd2: wdata = reg_rdata[23:16];
@@ -230,7 +333,7 @@ module mcu_top (
             end
 
             CMD_MEM_READ: begin
-                case (counter[0])
+                case (tx_counter[0])
                     1'd0: wdata = mem_rdata[15:8];
                     1'd1: wdata = mem_rdata[7:0];
                 endcase
@@ -251,23 +354,44 @@ module mcu_top (
             CMD_USB_WRITE: begin
                 wdata = 8'h00;
             end
+
+            CMD_MEM_STREAM_READ: begin
+                if (phase == PHASE_STATUS) begin
+                    wdata = {7'd0, stream_ready};
+                end else begin
+                    case (tx_counter[0])
+                        1'd0: wdata = mem_rdata[15:8];
+                        1'd1: wdata = mem_rdata[7:0];
+                    endcase
+                end
+            end
+
+            CMD_MEM_STREAM_WRITE: begin
+                wdata = {7'd0, stream_ready};
+            end
         endcase
     end
 
 
     // Mem bus controller
 
-    logic [15:0] mem_buffer [0:511];
+    logic [15:0] mem_buffer [0:1023];
     
     logic mem_start;
     logic mem_stop;
     logic mem_direction;    
-    logic [8:0] mem_length;
+    logic [9:0] mem_length;
     logic [31:0] mem_address;
 
-    logic mem_busy;
     logic mem_stop_pending;
-    logic [8:0] mem_counter;
+    logic mem_flow_control;
+    logic [9:0] mem_counter;
+    logic [9:0] mem_end;
+    logic [9:0] mem_index;
+
+    always_comb begin
+        mem_index = stream_selected ? stream_index[9:0] : {1'b0, address, mem_word_select};
+    end
 
     always_ff @(posedge clk) begin
         if (reset) begin
@@ -276,11 +400,11 @@ module mcu_top (
             mem_bus.request <= 1'b0;
         end else begin
             if (mem_read) begin
-                mem_rdata <= mem_buffer[{address, mem_word_select}];
+                mem_rdata <= mem_buffer[mem_index];
             end
 
             if (mem_write) begin
-                mem_buffer[{address, mem_word_select}] <= mem_wdata;
+                mem_buffer[mem_index] <= mem_wdata;
             end
 
             if (mem_stop) begin
@@ -289,11 +413,22 @@ module mcu_top (
                 mem_bus.write <= mem_direction;
                 mem_bus.address <= mem_address;
                 mem_busy <= 1'b1;
-                mem_counter <= 9'd0;
+                mem_flow_control <= 1'b0;
+                mem_counter <= 10'd0;
+                mem_end <= mem_length;
+            end else if (stream_start && !mem_busy) begin
+                mem_bus.write <= (cmd == CMD_MEM_STREAM_WRITE);
+                mem_bus.address <= stream_address;
+                mem_busy <= 1'b1;
+                mem_flow_control <= (cmd == CMD_MEM_STREAM_WRITE);
+                mem_counter <= 10'd0;
+                mem_end <= 10'((stream_length - 1'd1) >> 1);
             end
 
+            // Streamed writes are flow controlled, words are sent to memory as soon as they arrive from MCU
+
             if (mem_busy) begin
-                if (!mem_bus.request) begin
+                if (!mem_bus.request && (!mem_flow_control || ({1'b0, mem_counter} < stream_index))) begin
                     mem_bus.request <= 1'b1;
                     mem_bus.wdata <= mem_buffer[mem_counter];
                 end
@@ -305,7 +440,7 @@ module mcu_top (
                     if (!mem_bus.write) begin
                         mem_buffer[mem_counter] <= mem_bus.rdata;
                     end
-                    if ((mem_counter == mem_length) || mem_stop_pending) begin
+                    if ((mem_counter == mem_end) || mem_stop_pending) begin
                         mem_busy <= 1'b0;
                         mem_stop_pending <= 1'b0;
                     end
@@ -361,7 +496,22 @@ module mcu_top (
         REG_DEBUG_1,
         REG_CIC_0,
         REG_CIC_1,
-        REG_AUX
+        REG_AUX,
+        REG_BIST_ADDRESS,
+        REG_BIST_LENGTH,
+        REG_BIST_DATA,
+        REG_BIST_SCR,
+        REG_BIST_ERROR_0,
+        REG_BIST_ERROR_1,
+        REG_BIST_CRC,
+        REG_USB_FIFO_COUNT,
+        REG_DD_SEQ_ADDRESS,
+        REG_DD_SEQ_SCR,
+        REG_SPI_SCR,
+        REG_CIC_2,
+        REG_CIC_3,
+        REG_CIC_4,
+        REG_CIC_MARGIN
     } reg_address_e;
 
     logic bootloader_skip;
@@ -381,6 +531,8 @@ module mcu_top (
     // Register read logic
 
     always_ff @(posedge clk) begin
+        vendor_scb.data_read <= 1'b0;
+
         if (reg_read) begin
             reg_rdata <= 32'd0;
 
@@ -403,8 +555,8 @@ module mcu_top (
                         usb_scb.fifo_flush_busy,
                         usb_scb.pwrsav,
                         usb_scb.reset_state,
-                        usb_scb.tx_count,
-                        usb_scb.rx_count,
+                        (usb_scb.tx_count > 16'd2047) ? 11'h7FF : usb_scb.tx_count[10:0],
+                        (usb_scb.rx_count > 16'd2047) ? 11'h7FF : usb_scb.rx_count[10:0],
                         3'b000,
                         ~fifo_bus.tx_full,
                         ~fifo_bus.rx_empty,
@@ -489,7 +641,8 @@ module mcu_top (
 
                 REG_FLASH_SCR: begin
                     reg_rdata <= {
-                        31'd0,
+                        30'd0,
+                        flash_scb.busy,
                         flash_scb.erase_pending
                     };
                 end
@@ -529,7 +682,8 @@ module mcu_top (
                         sd_scb.card_busy,
                         sd_scb.cmd_error,
                         sd_scb.cmd_busy,
-                        sd_scb.clock_mode
+                        1'b0,
+                        sd_scb.clock_enable
                     };
                 end
 
@@ -648,6 +802,7 @@ module mcu_top (
 
                 REG_VENDOR_DATA: begin
                     reg_rdata <= vendor_scb.data_rdata;
+                    vendor_scb.data_read <= reg_read_start;
                 end
 
                 REG_DEBUG_0: begin
@@ -684,6 +839,100 @@ module mcu_top (
                 REG_AUX: begin
                     reg_rdata <= n64_scb.aux_rdata;
                 end
+
+                REG_BIST_ADDRESS: begin
+                    reg_rdata <= {
+                        5'd0,
+                        bist_scb.starting_address
+                    };
+                end
+
+                REG_BIST_LENGTH: begin
+                    reg_rdata <= {
+                        5'd0,
+                        bist_scb.transfer_length
+                    };
+                end
+
+                REG_BIST_DATA: begin
+                    reg_rdata <= bist_scb.data;
+                end
+
+                REG_BIST_SCR: begin
+                    reg_rdata <= {
+                        bist_scb.error_count,
+                        bist_scb.pattern,
+                        bist_scb.invert,
+                        bist_scb.verify_pass,
+                        bist_scb.write_pass,
+                        bist_scb.busy,
+                        2'b00
+                    };
+                end
+
+                REG_BIST_ERROR_0: begin
+                    reg_rdata <= {
+                        3'd0,
+                        bist_scb.error_select,
+                        bist_scb.error_address
+                    };
+                end
+
+                REG_BIST_ERROR_1: begin
+                    reg_rdata <= {
+                        bist_scb.error_expected,
+                        bist_scb.error_read
+                    };
+                end
+
+                REG_BIST_CRC: begin
+                    reg_rdata <= bist_scb.crc;
+                end
+
+                REG_USB_FIFO_COUNT: begin
+                    reg_rdata <= {
+                        usb_scb.tx_count,
+                        usb_scb.rx_count
+                    };
+                end
+
+                REG_DD_SEQ_ADDRESS: begin
+                    reg_rdata <= {6'd0, dd_scb.seq_address};
+                end
+
+                REG_DD_SEQ_SCR: begin
+                    reg_rdata <= {
+                        16'd0,
+                        dd_scb.seq_sector,
+                        7'd0,
+                        dd_scb.seq_active
+                    };
+                end
+
+                REG_SPI_SCR: begin
+                    reg_rdata <= {30'd0, spi_sample_delay};
+                end
+
+                REG_CIC_2: begin
+                    reg_rdata <= {n64_scb.cic_stream_valid, 7'd0, n64_scb.cic_seed_stream};
+                end
+
+                REG_CIC_3: begin
+                    reg_rdata <= n64_scb.cic_checksum_stream[63:32];
+                end
+
+                REG_CIC_4: begin
+                    reg_rdata <= n64_scb.cic_checksum_stream[31:0];
+                end
+
+                REG_CIC_MARGIN: begin
+                    reg_rdata <= {
+                        11'd0,
+                        n64_scb.cic_margin_valid,
+                        n64_scb.cic_margin_step,
+                        n64_scb.cic_margin
+                    };
+                end
             endcase
         end
     end
@@ -729,8 +978,15 @@ module mcu_top (
         dd_scb.bm_stop_clear <= 1'b0;
         dd_scb.bm_clear <= 1'b0;
         dd_scb.bm_ready <= 1'b0;
+        dd_scb.seq_start <= 1'b0;
+        dd_scb.seq_stop <= 1'b0;
 
         vendor_scb.control_valid <= 1'b0;
+        vendor_scb.data_write <= 1'b0;
+
+        bist_scb.start <= 1'b0;
+        bist_scb.stop <= 1'b0;
+        bist_scb.crc_start <= 1'b0;
 
         if (n64_scb.n64_nmi) begin
             n64_scb.bootloader_enabled <= !bootloader_skip;
@@ -754,7 +1010,10 @@ module mcu_top (
 
         if (reset) begin
             mcu_int <= 1'b0;
-            sd_scb.clock_mode <= 2'd0;
+            sd_scb.clock_enable <= 1'b0;
+            sd_scb.clock_period <= 8'd249;
+            sd_scb.dat_sample_delay <= 2'd0;
+            spi_sample_delay <= 2'd0;
             n64_scb.rom_extended_enabled <= 1'b0;
             n64_scb.eeprom_16k_mode <= 1'b0;
             n64_scb.eeprom_enabled <= 1'b0;
@@ -776,7 +1035,9 @@ module mcu_top (
             n64_scb.cic_region <= 1'b0;
             n64_scb.cic_seed <= 8'h3F;
             n64_scb.cic_checksum <= 48'hA536C0F1D859;
+            n64_scb.cic_stream_valid <= 1'b0;
             aux_pending <= 1'b0;
+            bist_scb.error_select <= 2'd0;
         end else if (reg_write) begin
             case (address)
                 REG_MEM_ADDRESS: begin
@@ -789,7 +1050,7 @@ module mcu_top (
                         mem_direction,
                         mem_stop,
                         mem_start
-                    } <= {(reg_wdata[14:5] - 1'd1), reg_wdata[2:0]};
+                    } <= {(reg_wdata[15:5] - 1'd1), reg_wdata[2:0]};
                 end
 
                 REG_USB_SCR: begin
@@ -882,7 +1143,11 @@ module mcu_top (
                 end
 
                 REG_SD_SCR: begin
-                    sd_scb.clock_mode <= reg_wdata[1:0];
+                    sd_scb.clock_enable <= reg_wdata[0];
+                    if (reg_wdata[1]) begin
+                        sd_scb.clock_period <= reg_wdata[15:8];
+                        sd_scb.dat_sample_delay <= reg_wdata[17:16];
+                    end
                 end
 
                 REG_SD_ARG: begin
@@ -950,6 +1215,37 @@ module mcu_top (
                     dd_scb.drive_id <= reg_wdata[15:0];
                 end
 
+                REG_DD_SEQ_ADDRESS: begin
+                    dd_scb.seq_start_address <= reg_wdata[25:0];
+                end
+
+                REG_DD_SEQ_SCR: begin
+                    dd_scb.seq_count <= reg_wdata[15:8];
+                    dd_scb.seq_stop <= reg_wdata[1];
+                    dd_scb.seq_start <= reg_wdata[0];
+                end
+
+                REG_SPI_SCR: begin
+                    spi_sample_delay <= reg_wdata[1:0];
+                end
+
+                REG_CIC_2: begin
+                    n64_scb.cic_stream_valid <= reg_wdata[31];
+                    n64_scb.cic_seed_stream <= reg_wdata[23:0];
+                end
+
+                REG_CIC_3: begin
+                    n64_scb.cic_checksum_stream[63:32] <= reg_wdata;
+                end
+
+                REG_CIC_4: begin
+                    n64_scb.cic_checksum_stream[31:0] <= reg_wdata;
+                end
+
+                REG_CIC_MARGIN: begin
+                    n64_scb.cic_margin_step <= reg_wdata[19:16];
+                end
+
                 REG_VENDOR_SCR: begin
                     vendor_scb.control_valid <= 1'b1;
                     vendor_scb.control_wdata <= reg_wdata;
@@ -957,6 +1253,7 @@ module mcu_top (
 
                 REG_VENDOR_DATA: begin
                     vendor_scb.data_wdata <= reg_wdata;
+                    vendor_scb.data_write <= 1'b1;
                 end
 
                 REG_CIC_0: begin
@@ -978,6 +1275,38 @@ module mcu_top (
                     n64_scb.aux_irq <= 1'b1;
                     n64_scb.aux_wdata <= reg_wdata;
                 end
+
+                REG_BIST_ADDRESS: begin
+                    bist_scb.starting_address <= reg_wdata[26:0];
+                end
+
+                REG_BIST_LENGTH: begin
+                    bist_scb.transfer_length <= reg_wdata[26:0];
+                end
+
+                REG_BIST_DATA: begin
+                    bist_scb.data <= reg_wdata;
+                end
+
+                REG_BIST_SCR: begin
+                    {
+                        bist_scb.pattern,
+                        bist_scb.invert,
+                        bist_scb.verify_pass,
+                        bist_scb.write_pass
+                    } <= reg_wdata[7:3];
+                    bist_scb.stop <= reg_wdata[1];
+                    bist_scb.start <= reg_wdata[0];
+                end
+
+                REG_BIST_ERROR_0: begin
+                    bist_scb.error_select <= reg_wdata[28:27];
+                end
+
+                REG_BIST_CRC: begin
+                    bist_scb.crc_seed <= reg_wdata;
+                    bist_scb.crc_start <= 1'b1;
+                end
             endcase
         end
     end
@@ -0,0 +1,64 @@
+interface bist_scb ();
+
+    logic start;
+    logic stop;
+    logic busy;
+    logic write_pass;
+    logic verify_pass;
+    logic invert;
+    logic [1:0] pattern;
+    logic [26:0] starting_address;
+    logic [26:0] transfer_length;
+    logic [31:0] data;
+    logic [23:0] error_count;
+    logic [1:0] error_select;
+    logic [26:0] error_address;
+    logic [15:0] error_expected;
+    logic [15:0] error_read;
+    logic crc_start;
+    logic [31:0] crc_seed;
+    logic [31:0] crc;
+
+    modport controller (
+        output start,
+        output stop,
+        input busy,
+        output write_pass,
+        output verify_pass,
+        output invert,
+        output pattern,
+        output starting_address,
+        output transfer_length,
+        output data,
+        input error_count,
+        output error_select,
+        input error_address,
+        input error_expected,
+        input error_read,
+        output crc_start,
+        output crc_seed,
+        input crc
+    );
+
+    modport bist (
+        input start,
+        input stop,
+        output busy,
+        input write_pass,
+        input verify_pass,
+        input invert,
+        input pattern,
+        input starting_address,
+        input transfer_length,
+        input data,
+        output error_count,
+        input error_select,
+        output error_address,
+        output error_expected,
+        output error_read,
+        input crc_start,
+        input crc_seed,
+        output crc
+    );
+
+endinterface
@@ -0,0 +1,192 @@
+module memory_bist (
+    input clk,
+    input reset,
+
+    bist_scb.bist bist_scb,
+
+    mem_bus.memory dma_bus,
+    mem_bus.controller mem_bus
+);
+
+    typedef enum bit [1:0] {
+        PATTERN_CONSTANT,
+        PATTERN_OWN_ADDRESS,
+        PATTERN_WALKING,
+        PATTERN_LFSR
+    } e_pattern;
+
+    typedef enum bit [1:0] {
+        STATE_IDLE,
+        STATE_WRITE,
+        STATE_VERIFY,
+        STATE_CRC
+    } e_state;
+
+    const bit [15:0] LFSR_TAPS = 16'hB400;
+    const bit [31:0] CRC32_POLYNOMIAL = 32'hEDB88320;
+
+    e_state state;
+
+    logic bus_owner;
+    logic stop_pending;
+
+    logic bist_request;
+    logic bist_write;
+    logic [26:0] bist_address;
+    logic [15:0] bist_wdata;
+
+    logic [26:0] remaining_bytes;
+    logic [15:0] lfsr;
+    logic [15:0] lfsr_seed;
+    logic [15:0] expected;
+
+    logic [26:0] error_address [0:3];
+    logic [15:0] error_expected [0:3];
+    logic [15:0] error_read [0:3];
+
+    logic [31:0] crc;
+
+
+    // Pattern generator
+
+    always_comb begin
+        case (e_pattern'(bist_scb.pattern))
+            PATTERN_CONSTANT: expected = bist_address[1] ? bist_scb.data[15:0] : bist_scb.data[31:16];
+            PATTERN_OWN_ADDRESS: expected = bist_address[1] ? {bist_address[15:2], 2'b00} : {5'd0, bist_address[26:16]};
+            PATTERN_WALKING: expected = (16'd1 << bist_address[4:1]);
+            PATTERN_LFSR: expected = lfsr;
+        endcase
+        if (bist_scb.invert) begin
+            expected = ~expected;
+        end
+    end
+
+    assign lfsr_seed = (bist_scb.data[15:0] == 16'd0) ? 16'd1 : bist_scb.data[15:0];
+
+
+    // CRC32 calculator (same algorithm as STM32 CRC unit configured by the controller)
+
+    function automatic logic [31:0] crc32_byte (input logic [31:0] value, input logic [7:0] data);
+        logic [31:0] result;
+        result = value ^ {24'd0, data};
+        for (int i = 0; i < 8; i++) begin
+            result = {1'b0, result[31:1]} ^ (result[0] ? CRC32_POLYNOMIAL : 32'd0);
+        end
+        return result;
+    endfunction
+
+
+    // Memory bus ownership
+
+    always_comb begin
+        mem_bus.request = bus_owner ? bist_request : dma_bus.request;
+        mem_bus.write = bus_owner ? bist_write : dma_bus.write;
+        mem_bus.wmask = bus_owner ? 2'b11 : dma_bus.wmask;
+        mem_bus.address = bus_owner ? bist_address : dma_bus.address;
+        mem_bus.wdata = bus_owner ? bist_wdata : dma_bus.wdata;
+
+        dma_bus.ack = !bus_owner && mem_bus.ack;
+        dma_bus.rdata = mem_bus.rdata;
+    end
+
+
+    // Test sequencer
+
+    always_ff @(posedge clk) begin
+        if (reset) begin
+            state <= STATE_IDLE;
+            bus_owner <= 1'b0;
+            stop_pending <= 1'b0;
+            bist_request <= 1'b0;
+            bist_scb.error_count <= 24'd0;
+        end else begin
+            if (bist_scb.stop) begin
+                stop_pending <= (state != STATE_IDLE);
+            end
+
+            case (state)
+                STATE_IDLE: begin
+                    bus_owner <= 1'b0;
+                    stop_pending <= 1'b0;
+                    if (bist_scb.start && (bist_scb.write_pass || bist_scb.verify_pass)) begin
+                        state <= bist_scb.write_pass ? STATE_WRITE : STATE_VERIFY;
+                        bist_address <= {bist_scb.starting_address[26:1], 1'b0};
+                        remaining_bytes <= {bist_scb.transfer_length[26:1], 1'b0};
+                        lfsr <= lfsr_seed;
+                        bist_scb.error_count <= 24'd0;
+                    end else if (bist_scb.crc_start) begin
+                        state <= STATE_CRC;
+                        bist_address <= {bist_scb.starting_address[26:1], 1'b0};
+                        remaining_bytes <= bist_scb.transfer_length;
+                        crc <= ~bist_scb.crc_seed;
+                    end
+                end
+
+                STATE_WRITE, STATE_VERIFY, STATE_CRC: begin
+                    if (!bist_request && stop_pending) begin
+                        state <= STATE_IDLE;
+                    end else if (!bus_owner) begin
+                        bus_owner <= !dma_bus.request;
+                    end else if (!bist_request) begin
+                        if (remaining_bytes == 27'd0) begin
+                            state <= STATE_IDLE;
+                        end else begin
+                            bist_request <= 1'b1;
+                            bist_write <= (state == STATE_WRITE);
+                            bist_wdata <= expected;
+                        end
+                    end
+
+                    if (mem_bus.ack && bus_owner) begin
+                        bist_request <= 1'b0;
+                        bist_address <= bist_address + 27'd2;
+                        remaining_bytes <= remaining_bytes - ((remaining_bytes == 27'd1) ? 27'd1 : 27'd2);
+                        lfsr <= {1'b0, lfsr[15:1]} ^ (lfsr[0] ? LFSR_TAPS : 16'h0000);
+
+                        if (state == STATE_CRC) begin
+                            if (remaining_bytes == 27'd1) begin
+                                crc <= crc32_byte(crc, mem_bus.rdata[15:8]);
+                            end else begin
+                                crc <= crc32_byte(crc32_byte(crc, mem_bus.rdata[15:8]), mem_bus.rdata[7:0]);
+                            end
+                        end
+
+                        if ((state == STATE_VERIFY) && (mem_bus.rdata != expected)) begin
+                            if (bist_scb.error_count < 24'd4) begin
+                                error_address[bist_scb.error_count[1:0]] <= bist_address;
+                                error_expected[bist_scb.error_count[1:0]] <= expected;
+                                error_read[bist_scb.error_count[1:0]] <= mem_bus.rdata;
+                            end
+                            if (bist_scb.error_count != 24'hFFFFFF) begin
+                                bist_scb.error_count <= bist_scb.error_count + 1'd1;
+                            end
+                        end
+
+                        if ((state == STATE_WRITE) && bist_scb.verify_pass && !stop_pending && (remaining_bytes == 27'd2)) begin
+                            state <= STATE_VERIFY;
+                            bist_address <= {bist_scb.starting_address[26:1], 1'b0};
+                            remaining_bytes <= {bist_scb.transfer_length[26:1], 1'b0};
+                            lfsr <= lfsr_seed;
+                        end
+                    end
+                end
+
+                default: begin
+                    state <= STATE_IDLE;
+                end
+            endcase
+        end
+    end
+
+
+    // Status and error log readout
+
+    always_ff @(posedge clk) begin
+        bist_scb.busy <= (bist_scb.start || bist_scb.crc_start || (state != STATE_IDLE));
+        bist_scb.crc <= ~crc;
+        bist_scb.error_address <= error_address[bist_scb.error_select];
+        bist_scb.error_expected <= error_expected[bist_scb.error_select];
+        bist_scb.error_read <= error_read[bist_scb.error_select];
+    end
+
+endmodule
@@ -3,17 +3,20 @@ interface flash_scb ();
     logic erase_pending;
     logic erase_done;
     logic [7:0] erase_block;
+    logic busy;
 
     modport controller (
         output erase_pending,
         input erase_done,
-        output erase_block
+        output erase_block,
+        input busy
     );
 
     modport flash (
         input erase_pending,
         output erase_done,
-        input erase_block
+        input erase_block,
+        output busy
     );
 
 endinterface
@@ -225,6 +228,69 @@ module memory_flash (
     logic valid_counter;
     logic [23:0] current_address;
 
+
+    // Page buffer, consecutive writes are collected here and programmed with single page program command
+
+    logic [7:0] page_buffer_even [0:127];
+    logic [7:0] page_buffer_odd [0:127];
+    logic [7:0] page_buffer_even_rdata;
+    logic [7:0] page_buffer_odd_rdata;
+    logic [7:0] page_buffer_rdata;
+
+    logic page_pending;
+    logic [15:0] page_address;
+    logic [7:0] page_first;
+    logic [23:0] page_next;
+    logic [7:0] page_offset;
+    logic [11:0] page_idle_counter;
+
+    logic write_request;
+    logic write_accept;
+    logic page_flush_forced;
+    logic page_flush;
+    logic [23:0] write_first;
+    logic [23:0] write_next;
+
+    always_comb begin
+        write_request = mem_bus.request && !mem_bus.ack && mem_bus.write;
+        write_first = {mem_bus.address[23:1], !mem_bus.wmask[1]};
+        write_next = {mem_bus.address[23:1], 1'b0} + (mem_bus.wmask[0] ? 24'd2 : 24'd1);
+        page_flush_forced = page_pending && (
+            flash_scb.erase_pending ||
+            (page_next[7:0] == 8'h00) ||
+            (&page_idle_counter)
+        );
+        write_accept = (
+            (state == STATE_IDLE) &&
+            !flash_scb.erase_pending &&
+            !page_flush_forced &&
+            write_request &&
+            (!page_pending || (write_first == page_next))
+        );
+        page_flush = page_flush_forced || (page_pending && mem_bus.request && !mem_bus.ack && !write_accept);
+    end
+
+    always_ff @(posedge clk) begin
+        if (write_accept) begin
+            if (mem_bus.wmask[1]) begin
+                page_buffer_even[mem_bus.address[7:1]] <= mem_bus.wdata[15:8];
+            end
+            if (mem_bus.wmask[0]) begin
+                page_buffer_odd[mem_bus.address[7:1]] <= mem_bus.wdata[7:0];
+            end
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        page_buffer_even_rdata <= page_buffer_even[page_offset[7:1]];
+        page_buffer_odd_rdata <= page_buffer_odd[page_offset[7:1]];
+        page_buffer_rdata <= page_offset[0] ? page_buffer_odd_rdata : page_buffer_even_rdata;
+    end
+
+    always_ff @(posedge clk) begin
+        flash_scb.busy <= (state != STATE_IDLE) || page_pending;
+    end
+
     always_ff @(posedge clk) begin
         start <= 1'b0;
         finish <= 1'b0;
@@ -233,7 +299,11 @@ module memory_flash (
 
         if (reset) begin
             state <= STATE_IDLE;
+            page_pending <= 1'b0;
         end else begin
+            if (page_pending && (state == STATE_IDLE) && !mem_bus.request) begin
+                page_idle_counter <= page_idle_counter + 1'd1;
+            end
             if ((start || finish) && !busy) begin
                 counter <= counter + 1'd1;
             end
@@ -243,16 +313,23 @@ module memory_flash (
                     output_enable <= 1'b1;
                     quad_enable <= 1'b0;
                     counter <= 3'd0;
-                    if (flash_scb.erase_pending) begin
+                    if (page_flush) begin
+                        page_offset <= page_first;
                         state <= STATE_WRITE_ENABLE;
-                    end else if (mem_bus.request) begin
-                        current_address <= {mem_bus.address[23:1], 1'b0};
-                        if (mem_bus.write) begin
-                            current_address[0] <= (~mem_bus.wmask[1]);
-                            state <= STATE_WRITE_ENABLE;
-                        end else begin
-                            state <= STATE_READ_START;
+                    end else if (write_accept) begin
+                        mem_bus.ack <= 1'b1;
+                        page_idle_counter <= 12'd0;
+                        page_next <= write_next;
+                        if (!page_pending) begin
+                            page_pending <= 1'b1;
+                            page_address <= write_first[23:8];
+                            page_first <= write_first[7:0];
                         end
+                    end else if (flash_scb.erase_pending) begin
+                        state <= STATE_WRITE_ENABLE;
+                    end else if (mem_bus.request && !mem_bus.ack && !mem_bus.write) begin
+                        current_address <= {mem_bus.address[23:1], 1'b0};
+                        state <= STATE_READ_START;
                     end
                 end
 
@@ -267,10 +344,10 @@ module memory_flash (
                             wdata <= 8'd5;
                             if (!busy) begin
                                 counter <= 3'd0;
-                                if (flash_scb.erase_pending) begin
-                                    state <= STATE_ERASE;
-                                end else begin
+                                if (page_pending) begin
                                     state <= STATE_PROGRAM_START;
+                                end else begin
+                                    state <= STATE_ERASE;
                                 end
                             end
                         end
@@ -315,17 +392,16 @@ module memory_flash (
                         end
                         3'd1: begin
                             start <= 1'b1;
-                            wdata <= current_address[23:16];
+                            wdata <= page_address[15:8];
                         end
                         3'd2: begin
                             start <= 1'b1;
-                            wdata <= current_address[15:8];
+                            wdata <= page_address[7:0];
                         end
                         3'd3: begin
                             start <= 1'b1;
-                            wdata <= current_address[7:0];
+                            wdata <= page_first;
                             if (!busy) begin
-                                counter <= 3'd0 + current_address[0];
                                 state <= STATE_PROGRAM;
                             end
                         end
@@ -333,40 +409,14 @@ module memory_flash (
                 end
 
                 STATE_PROGRAM: begin
-                    case (counter)
-                        3'd0: begin
-                            start <= 1'b1;
-                            wdata <= mem_bus.wdata[15:8];
-                            if (start && !busy) begin
-                                current_address <= current_address + 1'd1;
-                                if (!mem_bus.wmask[0]) begin
-                                    counter <= 3'd2;
-                                    mem_bus.ack <= 1'b1;
-                                end
-                            end
+                    start <= 1'b1;
+                    wdata <= page_buffer_rdata;
+                    if (start && !busy) begin
+                        page_offset <= page_offset + 1'd1;
+                        if ((page_offset + 1'd1) == page_next[7:0]) begin
+                            state <= STATE_PROGRAM_END;
                         end
-                        3'd1: begin
-                            start <= 1'b1;
-                            wdata <= mem_bus.wdata[7:0];
-                            if (!busy) begin
-                                mem_bus.ack <= 1'b1;
-                                current_address <= current_address + 1'd1;
-                            end
-                        end
-                        3'd2: begin
-                            if (current_address[7:0] == 8'h00) begin
-                                state <= STATE_PROGRAM_END;
-                            end else if (mem_bus.request && !mem_bus.ack) begin
-                                if (mem_bus.write && mem_bus.wmask[1] && (mem_bus.address[23:0] == current_address)) begin
-                                    counter <= 3'd0;
-                                end else begin
-                                    state <= STATE_PROGRAM_END;
-                                end
-                            end else if (!busy) begin
-                                state <= STATE_PROGRAM_END;
-                            end
-                        end
-                    endcase
+                    end
                 end
 
                 STATE_PROGRAM_END: begin
@@ -374,6 +424,7 @@ module memory_flash (
                     wdata <= 8'd5;
                     if (finish && !busy) begin
                         counter <= 3'd0;
+                        page_pending <= 1'b0;
                         state <= STATE_WAIT;
                     end
                 end
@@ -94,6 +94,89 @@ module n64_cic (
     end
 
 
+    // Timing margin measurement (cycles between CPU starting to wait and CIC clock falling edge)
+    // First IO_MARGIN poll after a rising edge starts the measurement, later polls are ignored
+
+    logic last_cic_clk;
+
+    always_ff @(posedge clk) begin
+        last_cic_clk <= cic_clk;
+    end
+
+    logic cic_clk_falling_edge;
+    logic cic_clk_rising_edge;
+
+    always_comb begin
+        cic_clk_falling_edge = last_cic_clk && !cic_clk;
+        cic_clk_rising_edge = !last_cic_clk && cic_clk;
+    end
+
+    logic margin_start;
+    logic margin_clear;
+    logic margin_armed;
+    logic margin_done;
+    logic margin_record;
+    logic [15:0] margin_counter;
+    logic [15:0] margin_value;
+    logic [15:0] margin_valid;
+    logic [15:0] margin_table [0:15];
+
+    always_ff @(posedge clk) begin
+        margin_record <= 1'b0;
+
+        if (margin_armed && (margin_counter != 16'hFFFF)) begin
+            margin_counter <= margin_counter + 1'd1;
+        end
+
+        if (cic_clk_rising_edge) begin
+            margin_done <= 1'b0;
+        end
+
+        if (margin_armed && cic_clk_falling_edge) begin
+            margin_armed <= 1'b0;
+            margin_done <= 1'b1;
+            margin_record <= 1'b1;
+            margin_value <= margin_counter;
+        end
+
+        if (margin_start && !margin_armed && !margin_done) begin
+            if (cic_clk) begin
+                margin_armed <= 1'b1;
+                margin_counter <= 16'd0;
+            end else begin
+                margin_done <= 1'b1;
+                margin_record <= 1'b1;
+                margin_value <= 16'd0;
+            end
+        end
+
+        if (margin_record) begin
+            if (!margin_valid[n64_scb.cic_debug_step] || (margin_value < margin_table[n64_scb.cic_debug_step])) begin
+                margin_valid[n64_scb.cic_debug_step] <= 1'b1;
+                margin_table[n64_scb.cic_debug_step] <= margin_value;
+            end
+        end
+
+        if (margin_clear) begin
+            margin_valid <= 16'd0;
+        end
+
+        if (reset || !cic_reset) begin
+            margin_armed <= 1'b0;
+            margin_done <= 1'b0;
+        end
+
+        if (reset) begin
+            margin_valid <= 16'd0;
+        end
+    end
+
+    always_comb begin
+        n64_scb.cic_margin_valid = margin_valid[n64_scb.cic_margin_step];
+        n64_scb.cic_margin = margin_table[n64_scb.cic_margin_step];
+    end
+
+
     // SERV RISC-V CPU
 
     logic [31:0] ibus_addr;
@@ -169,10 +252,16 @@ module n64_cic (
     always_ff @(posedge clk) begin
         timer_start <= 1'b0;
         timer_clear <= 1'b0;
+        margin_start <= 1'b0;
+        margin_clear <= 1'b0;
         n64_scb.cic_invalid_region <= 1'b0;
 
         dbus_ack <= dbus_cycle && !dbus_ack;
 
+        if (dbus_cycle && !dbus_write && !dbus_ack && (dbus_addr[31:30] == 2'b11) && (dbus_addr[4:2] == 3'b111)) begin
+            margin_start <= 1'b1;
+        end
+
         if (dbus_cycle && dbus_write) begin
             case (dbus_addr[31:30])
                 2'b10: begin
@@ -183,17 +272,20 @@ module n64_cic (
                 end
 
                 2'b11: begin
-                    case (dbus_addr[3:2])
-                        2'b10: begin
+                    case (dbus_addr[4:2])
+                        3'b010: begin
                             n64_scb.cic_invalid_region <= dbus_wdata[6];
                             timer_clear <= dbus_wdata[5];
                             timer_start <= dbus_wdata[4];
                             cic_dq_out <= dbus_wdata[0];
                         end
 
-                        2'b11: begin
+                        3'b011: begin
+                            margin_clear <= dbus_wdata[4];
                             n64_scb.cic_debug_step <= dbus_wdata[3:0];
                         end
+
+                        default: begin end
                     endcase
                 end
             endcase
@@ -217,8 +309,8 @@ module n64_cic (
             end
 
             2'b11: begin
-                case (dbus_addr[3:2])
-                    2'b00: dbus_rdata = {
+                case (dbus_addr[4:2])
+                    3'b000: dbus_rdata = {
                         n64_scb.cic_disabled,
                         n64_scb.cic_64dd_mode,
                         n64_scb.cic_region,
@@ -226,9 +318,9 @@ module n64_cic (
                         n64_scb.cic_checksum[47:32]
                     };
 
-                    2'b01: dbus_rdata = n64_scb.cic_checksum[31:0];
+                    3'b001: dbus_rdata = n64_scb.cic_checksum[31:0];
 
-                    2'b10: dbus_rdata = {
+                    3'b010, 3'b111: dbus_rdata = {
                         28'd0,
                         timer_elapsed,
                         cic_reset,
@@ -236,7 +328,15 @@ module n64_cic (
                         cic_dq
                     };
 
-                    2'b11: dbus_rdata = {28'd0, n64_scb.cic_debug_step};
+                    3'b011: dbus_rdata = {28'd0, n64_scb.cic_debug_step};
+
+                    3'b100: dbus_rdata = {n64_scb.cic_stream_valid, 7'd0, n64_scb.cic_seed_stream};
+
+                    3'b101: dbus_rdata = n64_scb.cic_checksum_stream[63:32];
+
+                    3'b110: dbus_rdata = n64_scb.cic_checksum_stream[31:0];
+
+                    default: dbus_rdata = 32'd0;
                 endcase
             end
         endcase
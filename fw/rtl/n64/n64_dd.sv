@@ -18,6 +18,9 @@ interface dd_scb ();
     logic [7:0] sector_size;
     logic [7:0] sector_size_full;
     logic [7:0] sectors_in_block;
+    logic seq_active;
+    logic [7:0] seq_sector;
+    logic [25:0] seq_address;
 
 
     // CPU controlled regs
@@ -37,6 +40,10 @@ interface dd_scb ();
     logic index_lock;
     logic [12:0] head_track;
     logic [15:0] drive_id;
+    logic seq_start;
+    logic seq_stop;
+    logic [25:0] seq_start_address;
+    logic [7:0] seq_count;
 
     modport controller (
         input hard_reset,
@@ -53,6 +60,9 @@ interface dd_scb ();
         input sector_size,
         input sector_size_full,
         input sectors_in_block,
+        input seq_active,
+        input seq_sector,
+        input seq_address,
 
         output hard_reset_clear,
         output cmd_data,
@@ -68,7 +78,11 @@ interface dd_scb ();
         output disk_changed,
         output index_lock,
         output head_track,
-        output drive_id
+        output drive_id,
+        output seq_start,
+        output seq_stop,
+        output seq_start_address,
+        output seq_count
     );
 
     modport dd (
@@ -88,6 +102,9 @@ interface dd_scb ();
         output sector_size,
         output sector_size_full,
         output sectors_in_block,
+        output seq_active,
+        output seq_sector,
+        output seq_address,
 
         input hard_reset_clear,
         input cmd_data,
@@ -103,7 +120,11 @@ interface dd_scb ();
         input disk_changed,
         input index_lock,
         input head_track,
-        input drive_id
+        input drive_id,
+        input seq_start,
+        input seq_stop,
+        input seq_start_address,
+        input seq_count
     );
 
 endinterface
@@ -175,6 +196,15 @@ module n64_dd (
         end
     end
 
+    logic sector_buffer_done;
+
+    always_comb begin
+        sector_buffer_done = (
+            (reg_bus.address[10:0] == (MEM_SECTOR_BUFFER + {dd_scb.sector_size[7:1], 1'b0})) &&
+            (reg_bus.read || reg_bus.write)
+        );
+    end
+
     always_ff @(posedge clk) begin
         dd_scb.bm_interrupt_ack <= 1'b0;
 
@@ -201,8 +231,23 @@ module n64_dd (
         if (reg_bus.address[10:0] == (MEM_C2_BUFFER + ({dd_scb.sector_size[7:1], 1'b0} * 3'd4)) && reg_bus.read) begin
             dd_scb.bm_pending <= 1'b1;
         end
-        if (reg_bus.address[10:0] == (MEM_SECTOR_BUFFER + {dd_scb.sector_size[7:1], 1'b0}) && (reg_bus.read || reg_bus.write)) begin
-            dd_scb.bm_pending <= 1'b1;
+        if (sector_buffer_done) begin
+            if (dd_scb.seq_active && ((dd_scb.seq_sector + 1'd1) < dd_scb.seq_count)) begin
+                dd_scb.seq_sector <= dd_scb.seq_sector + 1'd1;
+                dd_scb.seq_address <= dd_scb.seq_address + dd_scb.sector_size + 1'd1;
+                dd_scb.bm_interrupt <= 1'b1;
+            end else begin
+                dd_scb.seq_active <= 1'b0;
+                dd_scb.bm_pending <= 1'b1;
+            end
+        end
+        if (dd_scb.seq_stop) begin
+            dd_scb.seq_active <= 1'b0;
+        end
+        if (dd_scb.seq_start) begin
+            dd_scb.seq_active <= 1'b1;
+            dd_scb.seq_sector <= 8'd0;
+            dd_scb.seq_address <= dd_scb.seq_start_address;
         end
         if (reg_bus.address[10:0] == REG_CMD_SR && reg_bus.read) begin
             dd_scb.bm_interrupt <= 1'b0;
@@ -217,6 +262,7 @@ module n64_dd (
             dd_scb.bm_stop_pending <= 1'b0;
             dd_scb.bm_pending <= 1'b0;
             dd_scb.bm_interrupt <= 1'b0;
+            dd_scb.seq_active <= 1'b0;
         end else if (reg_bus.write) begin
             case (reg_bus.address[10:0])
                 REG_DATA: begin
@@ -243,6 +289,7 @@ module n64_dd (
                         dd_scb.bm_transfer_blocks <= 1'b0;
                         dd_scb.bm_pending <= 1'b0;
                         dd_scb.bm_interrupt <= 1'b0;
+                        dd_scb.seq_active <= 1'b0;
                     end
                     if (reg_bus.wdata[BM_CONTROL_MECHANIC_INTERRUPT_RESET]) begin
                         dd_scb.cmd_interrupt <= 1'b0;
@@ -258,6 +305,7 @@ module n64_dd (
                         dd_scb.bm_stop_pending <= 1'b0;
                         dd_scb.bm_pending <= 1'b0;
                         dd_scb.bm_interrupt <= 1'b0;
+                        dd_scb.seq_active <= 1'b0;
                     end
                 end
 
@@ -278,9 +326,11 @@ module n64_dd (
     end
 
     always_comb begin
-        n64_scb.dd_write = reg_bus.write && reg_bus.address[10:8] == MEM_SECTOR_BUFFER[10:8];
+        n64_scb.dd_write = reg_bus.write && reg_bus.address[10:8] == MEM_SECTOR_BUFFER[10:8] && !dd_scb.seq_active;
         n64_scb.dd_address = reg_bus.address[7:1];
         n64_scb.dd_wdata = reg_bus.wdata;
+        n64_scb.dd_sector_mapped = dd_scb.seq_active;
+        n64_scb.dd_sector_address = dd_scb.seq_address;
     end
 
 endmodule
@@ -157,6 +157,12 @@ module n64_pi (
 
     logic [31:0] mem_offset;
     logic sram_selected;
+    logic dd_sector_selected;
+    logic dd_sector_access;
+
+    always_comb begin
+        dd_sector_access = reg_bus.dd_select && n64_scb.dd_sector_mapped && (n64_pi_dq_in[15:8] == 8'h04);
+    end
 
     always_ff @(posedge clk) begin
         if (reset || !pi_reset || end_op) begin
@@ -168,14 +174,23 @@ module n64_pi (
             read_port <= PORT_NONE;
             write_port <= PORT_NONE;
             sram_selected <= 1'b0;
+            dd_sector_selected <= 1'b0;
             reg_bus.dd_select <= 1'b0;
             reg_bus.flashram_select <= 1'b0;
             reg_bus.cfg_select <= 1'b0;
+        end else if (alel_op) begin
+            if (dd_sector_access) begin
+                read_port <= PORT_MEM;
+                write_port <= PORT_MEM;
+                dd_sector_selected <= 1'b1;
+                n64_scb.pi_sdram_active <= 1'b1;
+            end
         end else if (aleh_op) begin
             read_port <= PORT_NONE;
             write_port <= PORT_NONE;
             mem_offset <= 32'd0;
             sram_selected <= 1'b0;
+            dd_sector_selected <= 1'b0;
             reg_bus.dd_select <= 1'b0;
             reg_bus.flashram_select <= 1'b0;
             reg_bus.cfg_select <= 1'b0;
@@ -438,6 +453,9 @@ module n64_pi (
 
             if (alel_op) begin
                 starting_address <= {starting_address[31:16], n64_pi_dq_in} + mem_offset;
+                if (dd_sector_access) begin
+                    starting_address <= {6'd0, n64_scb.dd_sector_address} + n64_pi_dq_in[7:0];
+                end
                 load_starting_address <= 1'b1;
                 read_enabled <= 1'b1;
                 first_write_op <= 1'b1;
@@ -502,8 +520,8 @@ module n64_pi (
             reg_bus.address <= reg_bus.address + 2'd2;
         end
 
-        reg_bus.read <= read_op && (read_port == PORT_REG);
-        reg_bus.write <= write_op && (write_port == PORT_REG);
+        reg_bus.read <= read_op && ((read_port == PORT_REG) || dd_sector_selected);
+        reg_bus.write <= write_op && ((write_port == PORT_REG) || dd_sector_selected);
         reg_bus.wdata <= n64_pi_dq_in;
     end
 
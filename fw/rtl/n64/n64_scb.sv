@@ -19,6 +19,8 @@ interface n64_scb ();
     logic [6:0] dd_address;
     logic [15:0] dd_rdata;
     logic [15:0] dd_wdata;
+    logic dd_sector_mapped;
+    logic [25:0] dd_sector_address;
 
     logic flashram_pending;
     logic flashram_done;
@@ -68,7 +70,13 @@ interface n64_scb ();
     logic cic_region;
     logic [7:0] cic_seed;
     logic [47:0] cic_checksum;
+    logic cic_stream_valid;
+    logic [23:0] cic_seed_stream;
+    logic [63:0] cic_checksum_stream;
     logic [3:0] cic_debug_step;
+    logic [3:0] cic_margin_step;
+    logic cic_margin_valid;
+    logic [15:0] cic_margin;
 
     logic pi_sdram_active;
     logic pi_flash_active;
@@ -129,7 +137,13 @@ interface n64_scb ();
         output cic_region,
         output cic_seed,
         output cic_checksum,
+        output cic_stream_valid,
+        output cic_seed_stream,
+        output cic_checksum_stream,
         input cic_debug_step,
+        output cic_margin_step,
+        input cic_margin_valid,
+        input cic_margin,
 
         input pi_debug_address,
         input pi_debug_rw_count,
@@ -150,6 +164,8 @@ interface n64_scb ();
         input flashram_enabled,
         input dd_enabled,
         input ddipl_enabled,
+        input dd_sector_mapped,
+        input dd_sector_address,
 
         output sram_done,
 
@@ -203,7 +219,9 @@ interface n64_scb ();
         output dd_write,
         output dd_address,
         input dd_rdata,
-        output dd_wdata
+        output dd_wdata,
+        output dd_sector_mapped,
+        output dd_sector_address
     );
 
     modport bram (
@@ -259,7 +277,13 @@ interface n64_scb ();
         input cic_region,
         input cic_seed,
         input cic_checksum,
-        output cic_debug_step
+        input cic_stream_valid,
+        input cic_seed_stream,
+        input cic_checksum_stream,
+        output cic_debug_step,
+        input cic_margin_step,
+        output cic_margin_valid,
+        output cic_margin
     );
 
     modport arbiter (
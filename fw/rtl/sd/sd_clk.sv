@@ -10,24 +10,26 @@ module sd_clk (
     output logic sd_clk
 );
 
-    logic [7:0] clock_divider;
+    logic [7:0] clock_counter;
 
     always_ff @(posedge clk) begin
-        if (!sd_scb.clock_stop) begin
-            clock_divider <= clock_divider + 1'd1;
+        if (reset || !sd_scb.clock_enable) begin
+            clock_counter <= 8'd0;
+        end else if (!sd_scb.clock_stop) begin
+            if (clock_counter >= sd_scb.clock_period) begin
+                clock_counter <= 8'd0;
+            end else begin
+                clock_counter <= clock_counter + 1'd1;
+            end
         end
     end
 
+    logic [8:0] clock_half_period;
     logic selected_clock;
 
     always_comb begin
-        selected_clock = 1'b0;
-        case (sd_scb.clock_mode)
-            2'd0: selected_clock = 1'b0;
-            2'd1: selected_clock = clock_divider[7];
-            2'd2: selected_clock = clock_divider[1];
-            2'd3: selected_clock = clock_divider[0];
-        endcase
+        clock_half_period = ({1'b0, sd_scb.clock_period} + 1'd1) >> 1;
+        selected_clock = sd_scb.clock_enable && ({1'b0, clock_counter} >= clock_half_period);
     end
 
     logic last_selected_clock;
@@ -32,6 +32,22 @@ module sd_dat (
         sd_scb.card_busy <= !sd_dat_in[0];
     end
 
+    logic [2:0] sd_clk_rising_delayed;
+    logic rx_strobe;
+
+    always_ff @(posedge clk) begin
+        sd_clk_rising_delayed <= {sd_clk_rising_delayed[1:0], sd_clk_rising};
+    end
+
+    always_comb begin
+        case (sd_scb.dat_sample_delay)
+            2'd0: rx_strobe = sd_clk_rising;
+            2'd1: rx_strobe = sd_clk_rising_delayed[0];
+            2'd2: rx_strobe = sd_clk_rising_delayed[1];
+            2'd3: rx_strobe = sd_clk_rising_delayed[2];
+        endcase
+    end
+
 
     // FIFO
 
@@ -116,7 +132,7 @@ module sd_dat (
             end
 
             STATE_RX_WAIT: begin
-                if (sd_clk_rising) begin
+                if (rx_strobe) begin
                     if (!sd_dat_in[0]) begin
                         next_state = STATE_RX;
                     end
@@ -124,7 +140,7 @@ module sd_dat (
             end
 
             STATE_RX: begin
-                if (sd_clk_rising) begin
+                if (rx_strobe) begin
                     if (counter == 11'd1041) begin
                         if (blocks_remaining == 8'd0) begin
                             next_state = STATE_IDLE;
@@ -152,7 +168,7 @@ module sd_dat (
             end
 
             STATE_TX_STATUS_WAIT: begin
-                if (sd_clk_rising) begin
+                if (rx_strobe) begin
                     if (counter == 11'd8) begin
                         next_state = STATE_IDLE;
                     end else if (!sd_dat_in[0]) begin
@@ -162,7 +178,7 @@ module sd_dat (
             end
 
             STATE_TX_STATUS: begin
-                if (sd_clk_rising) begin
+                if (rx_strobe) begin
                     if (counter == 11'd5) begin
                         if (sd_dat_in[0]) begin
                             if (blocks_remaining == 8'd0) begin
@@ -258,7 +274,7 @@ module sd_dat (
                     if (sd_scb.rx_count <= 11'd512) begin
                         sd_scb.clock_stop <= 1'b0;
                     end
-                    if (sd_clk_rising) begin
+                    if (rx_strobe) begin
                         if (!sd_dat_in[0]) begin
                             counter <= 11'd1;
                             crc_reset <= 1'b1;
@@ -267,7 +283,7 @@ module sd_dat (
                 end
 
                 STATE_RX: begin
-                    if (sd_clk_rising) begin
+                    if (rx_strobe) begin
                         counter <= counter + 1'd1;
                         rx_wdata <= {rx_wdata[3:0], sd_dat_in};
                         if (counter <= 11'd1024) begin
@@ -324,7 +340,7 @@ module sd_dat (
                 end
 
                 STATE_TX_STATUS_WAIT: begin
-                    if (sd_clk_rising) begin
+                    if (rx_strobe) begin
                         counter <= counter + 1'd1;
                         if (counter == 11'd8) begin
                             sd_scb.dat_error <= 1'b1;
@@ -335,7 +351,7 @@ module sd_dat (
                 end
 
                 STATE_TX_STATUS: begin
-                    if (sd_clk_rising) begin
+                    if (rx_strobe) begin
                         if (counter < 11'd5) begin
                             counter <= counter + 1'd1;
                         end
@@ -1,6 +1,7 @@
 interface sd_scb ();
 
-    logic [1:0] clock_mode;
+    logic clock_enable;
+    logic [7:0] clock_period;
     logic clock_stop;
 
     logic card_busy;
@@ -24,11 +25,13 @@ interface sd_scb ();
     logic dat_start_read;
     logic dat_stop;
     logic [7:0] dat_blocks;
+    logic [1:0] dat_sample_delay;
     logic dat_busy;
     logic dat_error;
 
     modport controller (
-        output clock_mode,
+        output clock_enable,
+        output clock_period,
 
         input card_busy,
 
@@ -51,12 +54,14 @@ interface sd_scb ();
         output dat_start_read,
         output dat_stop,
         output dat_blocks,
+        output dat_sample_delay,
         input dat_busy,
         input dat_error
     );
 
     modport clk (
-        input clock_mode,
+        input clock_enable,
+        input clock_period,
         input clock_stop
     );
 
@@ -86,6 +91,7 @@ interface sd_scb ();
         input dat_start_read,
         input dat_stop,
         input dat_blocks,
+        input dat_sample_delay,
         output dat_busy,
         output dat_error
     );
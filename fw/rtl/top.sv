@@ -68,6 +68,7 @@ module top (
     dma_scb sd_dma_scb ();
     flash_scb flash_scb ();
     vendor_scb vendor_scb ();
+    bist_scb bist_scb ();
 
     fifo_bus usb_cfg_fifo_bus ();
     fifo_bus usb_dma_fifo_bus ();
@@ -77,6 +78,7 @@ module top (
     mem_bus n64_mem_bus ();
     mem_bus cfg_mem_bus ();
     mem_bus usb_dma_mem_bus ();
+    mem_bus bist_mem_bus ();
     mem_bus sd_dma_mem_bus ();
     mem_bus sdram_mem_bus ();
     mem_bus flash_mem_bus ();
@@ -104,6 +106,7 @@ module top (
         .sd_dma_scb(sd_dma_scb),
         .flash_scb(flash_scb),
         .vendor_scb(vendor_scb),
+        .bist_scb(bist_scb),
 
         .fifo_bus(usb_cfg_fifo_bus),
         .mem_bus(cfg_mem_bus),
@@ -208,6 +211,19 @@ module top (
     );
 
 
+    // Memory self test
+
+    memory_bist memory_bist_inst (
+        .clk(clk),
+        .reset(reset),
+
+        .bist_scb(bist_scb),
+
+        .dma_bus(usb_dma_mem_bus),
+        .mem_bus(bist_mem_bus)
+    );
+
+
     // Memory bus arbiter
 
     memory_arbiter memory_arbiter_inst (
@@ -218,7 +234,7 @@ module top (
 
         .n64_bus(n64_mem_bus),
         .cfg_bus(cfg_mem_bus),
-        .usb_dma_bus(usb_dma_mem_bus),
+        .usb_dma_bus(bist_mem_bus),
         .sd_dma_bus(sd_dma_mem_bus),
 
         .sdram_mem_bus(sdram_mem_bus),
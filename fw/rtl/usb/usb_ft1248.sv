@@ -1,4 +1,8 @@
-module usb_ft1248 (
+module usb_ft1248 #(
+    parameter int RX_DEPTH = 2048,
+    parameter int TX_DEPTH = 2048,
+    parameter int BURST_WAIT_CYCLES = 255
+) (
     input clk,
     input reset,
 
@@ -23,7 +27,12 @@ module usb_ft1248 (
 
     logic fifo_flush;
 
-    fifo_8kb fifo_8kb_rx_inst (
+    logic [$clog2(RX_DEPTH):0] rx_count;
+    logic [$clog2(TX_DEPTH):0] tx_count;
+
+    fifo_bram #(
+        .DEPTH(RX_DEPTH)
+    ) fifo_bram_rx_inst (
         .clk(clk),
         .reset(fifo_flush),
 
@@ -35,10 +44,12 @@ module usb_ft1248 (
         .write(rx_write_delayed),
         .wdata(rx_wdata),
 
-        .count(usb_scb.rx_count)
+        .count(rx_count)
     );
 
-    fifo_8kb fifo_8kb_tx_inst (
+    fifo_bram #(
+        .DEPTH(TX_DEPTH)
+    ) fifo_bram_tx_inst (
         .clk(clk),
         .reset(fifo_flush),
 
@@ -50,9 +61,14 @@ module usb_ft1248 (
         .write(fifo_bus.tx_write),
         .wdata(fifo_bus.tx_wdata),
 
-        .count(usb_scb.tx_count)
+        .count(tx_count)
     );
 
+    always_comb begin
+        usb_scb.rx_count = 16'(rx_count);
+        usb_scb.tx_count = 16'(tx_count);
+    end
+
     logic [1:0] usb_pwrsav_ff;
     logic [7:0] usb_miosi_out;
     logic usb_oe;
@@ -84,6 +100,7 @@ module usb_ft1248 (
         STATE_COMMAND,
         STATE_STATUS,
         STATE_DATA,
+        STATE_WAIT,
         STATE_DESELECT
     } e_state;
 
@@ -107,6 +124,27 @@ module usb_ft1248 (
     logic [4:0] modem_status_counter;
     logic write_modem_status_pending;
     logic write_buffer_flush_pending;
+    logic [7:0] wait_counter;
+    logic wait_resume;
+    logic wait_abort;
+
+    always_comb begin
+        wait_resume = 1'b0;
+        if (cmd == CMD_WRITE) begin
+            wait_resume = !tx_empty;
+        end
+        if (cmd == CMD_READ) begin
+            wait_resume = tx_empty && !last_rx_failed && !rx_full && !rx_write_delayed;
+        end
+        wait_abort = (
+            (wait_counter >= 8'(BURST_WAIT_CYCLES)) ||
+            usb_scb.fifo_flush ||
+            usb_scb.fifo_flush_busy ||
+            write_modem_status_pending ||
+            write_buffer_flush_pending ||
+            ((cmd == CMD_READ) && !tx_empty)
+        );
+    end
 
     always_ff @(posedge clk) begin
         state <= next_state;
@@ -122,6 +160,11 @@ module usb_ft1248 (
             phase <= 4'b0100;
         end
 
+        wait_counter <= 8'd0;
+        if ((state == STATE_WAIT) && (wait_counter < 8'(BURST_WAIT_CYCLES))) begin
+            wait_counter <= wait_counter + 1'd1;
+        end
+
         if (reset) begin
             usb_scb.fifo_flush_busy <= 1'b0;
             usb_scb.reset_state <= 1'b0;
@@ -163,6 +206,11 @@ module usb_ft1248 (
                 end
             end
 
+            if ((state == STATE_WAIT) && last_rx_failed && !rx_full) begin
+                last_rx_failed <= 1'b0;
+                rx_write_delayed <= 1'b1;
+            end
+
             if ((state == STATE_DATA) && (cmd == CMD_READ) && phase[3]) begin
                 rx_wdata <= ft_miosi_in;
                 last_rx_failed <= !ft_miso && rx_full;
@@ -196,6 +244,10 @@ module usb_ft1248 (
             ft_cs = 1'b0;
         end
 
+        if (state == STATE_WAIT) begin
+            ft_cs = 1'b0;
+        end
+
         if (state == STATE_COMMAND) begin
             if (phase[0] || phase[1]) begin
                 ft_clk = 1'b1;
@@ -252,6 +304,10 @@ module usb_ft1248 (
                 default: begin end
             endcase
         end
+
+        if ((state == STATE_WAIT) && phase[3] && (cmd == CMD_WRITE) && wait_resume) begin
+            tx_read = 1'b1;
+        end
     end
 
     always_comb begin
@@ -311,11 +367,11 @@ module usb_ft1248 (
                             next_state = STATE_DESELECT;
                         end else if (cmd == CMD_READ) begin
                             if (rx_full) begin
-                                next_state = STATE_DESELECT;
+                                next_state = STATE_WAIT;
                             end
                         end else if (cmd == CMD_WRITE) begin
                             if (tx_empty) begin
-                                next_state = STATE_DESELECT;
+                                next_state = STATE_WAIT;
                             end
                         end else begin
                             next_state = STATE_DESELECT;
@@ -323,6 +379,16 @@ module usb_ft1248 (
                     end
                 end
 
+                STATE_WAIT: begin
+                    if (phase[3]) begin
+                        if (wait_resume) begin
+                            next_state = STATE_DATA;
+                        end else if (wait_abort) begin
+                            next_state = STATE_DESELECT;
+                        end
+                    end
+                end
+
                 STATE_DESELECT: begin
                     if (phase[1]) begin
                         next_state = STATE_IDLE;
@@ -3,8 +3,8 @@ interface usb_scb ();
     logic fifo_flush;
     logic fifo_flush_busy;
     logic write_buffer_flush;
-    logic [10:0] rx_count;
-    logic [10:0] tx_count;
+    logic [15:0] rx_count;
+    logic [15:0] tx_count;
     logic pwrsav;
     logic reset_state;
     logic reset_on_ack;
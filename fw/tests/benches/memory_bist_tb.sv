@@ -0,0 +1,108 @@
+module memory_bist_tb;
+
+    logic clk;
+    logic reset;
+
+    bist_scb bist_scb ();
+    mem_bus dma_bus ();
+    mem_bus mem_bus ();
+
+    memory_bist memory_bist (
+        .clk(clk),
+        .reset(reset),
+
+        .bist_scb(bist_scb),
+
+        .dma_bus(dma_bus),
+        .mem_bus(mem_bus)
+    );
+
+    memory_sdram_mock memory_sdram_mock (
+        .clk(clk),
+        .reset(reset),
+
+        .mem_bus(mem_bus)
+    );
+
+    initial begin
+        clk = 1'b0;
+        forever begin
+            clk = ~clk; #0.5;
+        end
+    end
+
+    initial begin
+        reset = 1'b0;
+        #10;
+        reset = 1'b1;
+        #10;
+        reset = 1'b0;
+    end
+
+    initial begin
+        dma_bus.request = 1'b0;
+        dma_bus.write = 1'b0;
+        dma_bus.wmask = 2'b11;
+        dma_bus.address = 27'd0;
+        dma_bus.wdata = 16'd0;
+
+        bist_scb.start = 1'b0;
+        bist_scb.stop = 1'b0;
+        bist_scb.write_pass = 1'b0;
+        bist_scb.verify_pass = 1'b0;
+        bist_scb.invert = 1'b0;
+        bist_scb.pattern = 2'd0;
+        bist_scb.starting_address = 27'd0;
+        bist_scb.transfer_length = 27'd0;
+        bist_scb.data = 32'd0;
+        bist_scb.error_select = 2'd0;
+        bist_scb.crc_start = 1'b0;
+        bist_scb.crc_seed = 32'd0;
+    end
+
+    initial begin
+        $dumpfile("traces/memory_bist_tb.vcd");
+
+        #10000;
+
+        $dumpvars();
+
+        #100;
+        bist_scb.write_pass = 1'b1;
+        bist_scb.verify_pass = 1'b1;
+        bist_scb.pattern = 2'd3;
+        bist_scb.starting_address = 27'h1000;
+        bist_scb.transfer_length = 27'd64;
+        bist_scb.data = 32'h0000ACE1;
+        bist_scb.start = 1'b1;
+        #1;
+        bist_scb.start = 1'b0;
+
+        #1000;
+
+        bist_scb.write_pass = 1'b0;
+        bist_scb.pattern = 2'd2;
+        bist_scb.start = 1'b1;
+        #1;
+        bist_scb.start = 1'b0;
+
+        #200;
+        bist_scb.stop = 1'b1;
+        #1;
+        bist_scb.stop = 1'b0;
+
+        #50;
+        bist_scb.error_select = 2'd1;
+
+        #49;
+        bist_scb.transfer_length = 27'd63;
+        bist_scb.crc_start = 1'b1;
+        #1;
+        bist_scb.crc_start = 1'b0;
+
+        #300;
+
+        $finish;
+    end
+
+endmodule
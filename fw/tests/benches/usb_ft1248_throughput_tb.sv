@@ -0,0 +1,191 @@
+module usb_ft1248_throughput_tb;
+
+    localparam int MEASURE_CYCLES = 200000;
+    localparam int PI_PERIOD = 128;
+    localparam int PI_BUSY = 96;
+
+    logic clk;
+    logic reset;
+
+    usb_scb usb_scb ();
+    fifo_bus fifo_bus ();
+
+    logic usb_pwrsav;
+    logic usb_clk;
+    logic usb_cs;
+    logic usb_miso;
+    wire [7:0] usb_miosi;
+
+    usb_ft1248 usb_ft1248 (
+        .clk(clk),
+        .reset(reset),
+        .usb_scb(usb_scb),
+        .fifo_bus(fifo_bus),
+        .usb_pwrsav(usb_pwrsav),
+        .usb_clk(usb_clk),
+        .usb_cs(usb_cs),
+        .usb_miso(usb_miso),
+        .usb_miosi(usb_miosi)
+    );
+
+    initial begin
+        clk = 1'b0;
+        forever begin
+            clk = ~clk; #0.5;
+        end
+    end
+
+    initial begin
+        reset = 1'b1;
+        #10;
+        reset = 1'b0;
+    end
+
+
+    // FT232H model, always ready to accept and provide data
+
+    logic [3:0] ft_edge;
+    logic [7:0] ft_cmd;
+    logic [7:0] ft_data;
+    logic ft_drive;
+    int ft_selects;
+    int ft_read_bytes;
+    int ft_write_bytes;
+
+    assign usb_miosi = ft_drive ? ft_data : 8'hZZ;
+
+    always @(negedge usb_cs) begin
+        ft_edge = 4'd0;
+        ft_selects += 1;
+    end
+
+    always @(posedge usb_cs) begin
+        ft_drive = 1'b0;
+    end
+
+    always @(posedge usb_clk) begin
+        if (!usb_cs) begin
+            if (ft_edge == 4'd0) begin
+                ft_cmd = usb_miosi;
+            end else if (ft_edge > 4'd1) begin
+                if (ft_cmd == 8'h40) begin
+                    ft_read_bytes += 1;
+                end
+                if (ft_cmd == 8'h00) begin
+                    ft_write_bytes += 1;
+                end
+            end
+            if (ft_edge < 4'd2) begin
+                ft_edge += 4'd1;
+            end
+        end
+    end
+
+    always @(negedge usb_clk) begin
+        if (!usb_cs && (ft_cmd == 8'h40) && (ft_edge >= 4'd1)) begin
+            ft_drive = 1'b1;
+            ft_data = ft_data + 8'd1;
+        end
+    end
+
+
+    // Memory side model, FIFOs are serviced only when PI doesn't occupy the memory bus
+
+    logic pi_active;
+    logic rx_enabled;
+    logic tx_enabled;
+    int pi_counter = 0;
+    int rx_bytes = 0;
+    int tx_bytes = 0;
+
+    always_ff @(posedge clk) begin
+        pi_counter <= (pi_counter + 1) % PI_PERIOD;
+    end
+
+    always_comb begin
+        fifo_bus.rx_read = 1'b0;
+        fifo_bus.tx_write = 1'b0;
+        fifo_bus.tx_wdata = 8'h00;
+        if (!(pi_active && (pi_counter < PI_BUSY))) begin
+            fifo_bus.rx_read = rx_enabled && !fifo_bus.rx_empty;
+            fifo_bus.tx_write = tx_enabled && !fifo_bus.tx_full;
+            fifo_bus.tx_wdata = tx_bytes[7:0];
+        end
+    end
+
+    always_ff @(posedge clk) begin
+        if (fifo_bus.rx_read) begin
+            rx_bytes <= rx_bytes + 1;
+        end
+        if (fifo_bus.tx_write) begin
+            tx_bytes <= tx_bytes + 1;
+        end
+    end
+
+    task automatic measure (input string name, input logic pi, input logic rx, input logic tx);
+        int selects;
+        int read_bytes;
+        int write_bytes;
+
+        pi_active = pi;
+        rx_enabled = rx;
+        tx_enabled = tx;
+
+        #1000;
+
+        selects = ft_selects;
+        read_bytes = ft_read_bytes;
+        write_bytes = ft_write_bytes;
+
+        #(MEASURE_CYCLES);
+
+        $display(
+            "[%s] RX %0d kB/s, TX %0d kB/s, %0d bus selects",
+            name,
+            ((ft_read_bytes - read_bytes) * 100000) / MEASURE_CYCLES,
+            ((ft_write_bytes - write_bytes) * 100000) / MEASURE_CYCLES,
+            ft_selects - selects
+        );
+
+        rx_enabled = 1'b0;
+        tx_enabled = 1'b0;
+
+        usb_scb.fifo_flush = 1'b1;
+        #1;
+        usb_scb.fifo_flush = 1'b0;
+
+        #1000;
+    endtask
+
+    initial begin
+        usb_pwrsav = 1'b1;
+        usb_miso = 1'b0;
+
+        ft_edge = 4'd0;
+        ft_cmd = 8'hFF;
+        ft_data = 8'h00;
+        ft_drive = 1'b0;
+        ft_selects = 0;
+        ft_read_bytes = 0;
+        ft_write_bytes = 0;
+
+        pi_active = 1'b0;
+        rx_enabled = 1'b0;
+        tx_enabled = 1'b0;
+
+        usb_scb.fifo_flush = 1'b0;
+        usb_scb.write_buffer_flush = 1'b0;
+        usb_scb.reset_on_ack = 1'b0;
+        usb_scb.reset_off_ack = 1'b0;
+
+        #100;
+
+        measure("RX, PI idle", 1'b0, 1'b1, 1'b0);
+        measure("RX, PI active", 1'b1, 1'b1, 1'b0);
+        measure("TX, PI idle", 1'b0, 1'b0, 1'b1);
+        measure("TX, PI active", 1'b1, 1'b0, 1'b1);
+
+        $finish;
+    end
+
+endmodule
@@ -163,6 +163,7 @@ typedef enum {
     SD_CARD_STATUS_TYPE_BLOCK = (1 << 2),
     SD_CARD_STATUS_50MHZ_MODE = (1 << 3),
     SD_CARD_STATUS_BYTE_SWAP = (1 << 4),
+    SD_CARD_STATUS_CLOCK_TUNED = (1 << 5),
 } sc64_sd_card_status_t;
 
 typedef enum {
@@ -205,7 +205,9 @@ static void test_sd_card_io (void) {
     if (card_status & SD_CARD_STATUS_TYPE_BLOCK) {
         display_printf("SD card type is block\n");
     }
-    if (card_status & SD_CARD_STATUS_50MHZ_MODE) {
+    if (card_status & SD_CARD_STATUS_CLOCK_TUNED) {
+        display_printf("SD card runs at %d kHz clock speed, sample delay %d\n", (int) (card_status >> 16), (int) ((card_status >> 6) & 0x03));
+    } else if (card_status & SD_CARD_STATUS_50MHZ_MODE) {
         display_printf("SD card runs at 50 MHz clock speed\n");
     }
     if (card_status & SD_CARD_STATUS_BYTE_SWAP) {
@@ -32,6 +32,8 @@ typedef struct {
     volatile uint32_t CIC_CONFIG[2];
     volatile uint32_t IO;
     volatile uint32_t DEBUG;
+    volatile uint32_t CIC_STREAM[3];
+    volatile uint32_t IO_MARGIN;
 } ext_regs_t;
 
 #define EXT ((ext_regs_t *) (0xC0000000UL))
@@ -44,9 +46,13 @@ typedef struct {
 #define CIC_TIMER_CLEAR             (1 << 5) // O
 #define CIC_INVALID_REGION          (1 << 6) // O
 
+#define CIC_DEBUG_MARGIN_CLEAR      (1 << 4)
+
+#define CIC_STREAM_VALID            (1UL << 31)
+
 #define CIC_INIT()                  { EXT->IO = (CIC_TIMER_CLEAR | CIC_DQ); }
 #define CIC_IS_RUNNING()            (EXT->IO & CIC_RESET)
-#define CIC_CLK_WAIT_LOW()          { while ((EXT->IO & (CIC_TIMER_ELAPSED | CIC_RESET | CIC_CLK)) == (CIC_RESET | CIC_CLK)); }
+#define CIC_CLK_WAIT_LOW()          { while ((EXT->IO_MARGIN & (CIC_TIMER_ELAPSED | CIC_RESET | CIC_CLK)) == (CIC_RESET | CIC_CLK)); }
 #define CIC_CLK_WAIT_HIGH()         { while ((EXT->IO & (CIC_TIMER_ELAPSED | CIC_RESET | CIC_CLK)) == CIC_RESET); }
 #define CIC_CLK_IS_LOW()            ((EXT->IO & (CIC_RESET | CIC_CLK)) == CIC_RESET)
 #define CIC_DQ_GET()                (EXT->IO & CIC_DQ)
@@ -82,6 +88,9 @@ typedef struct {
     bool cic_region;
     uint8_t cic_seed;
     uint8_t cic_checksum[6];
+    bool cic_stream_valid;
+    uint32_t cic_seed_stream;
+    uint32_t cic_checksum_stream[2];
 } cic_config_t;
 
 static cic_config_t config;
@@ -122,6 +131,11 @@ static void cic_load_config (void) {
     config.cic_checksum[4] = ((cic_config[1] >> 8) & 0xFF);
     config.cic_checksum[5] = (cic_config[1] & 0xFF);
 
+    config.cic_seed_stream = EXT->CIC_STREAM[0];
+    config.cic_stream_valid = (config.cic_seed_stream & CIC_STREAM_VALID);
+    config.cic_checksum_stream[0] = EXT->CIC_STREAM[1];
+    config.cic_checksum_stream[1] = EXT->CIC_STREAM[2];
+
     if (config.cic_disabled) {
         CIC_SET_STEP(CIC_STEP_DIE_DISABLED);
         cic_die();
@@ -158,6 +172,12 @@ static void cic_write_nibble (uint8_t data) {
     cic_write(data & 0x01);
 }
 
+static void cic_write_stream_nibbles (uint32_t stream, int count) {
+    for (int shift = ((count - 1) * 4); shift >= 0; shift -= 4) {
+        cic_write_nibble(stream >> shift);
+    }
+}
+
 static void cic_write_ram_nibbles (uint8_t index) {
     do {
         cic_write_nibble(cic_ram[index++]);
@@ -190,18 +210,24 @@ static void cic_write_id (void) {
 }
 
 static void cic_write_seed (void) {
-    cic_ram[0x0A] = 0x0B;
-    cic_ram[0x0B] = 0x05;
-    cic_ram[0x0C] = (config.cic_seed >> 4);
-    cic_ram[0x0D] = config.cic_seed;
-    cic_ram[0x0E] = (config.cic_seed >> 4);
-    cic_ram[0x0F] = config.cic_seed;
-    cic_encode_round(0x0A);
-    cic_encode_round(0x0A);
+    if (!config.cic_stream_valid) {
+        cic_ram[0x0A] = 0x0B;
+        cic_ram[0x0B] = 0x05;
+        cic_ram[0x0C] = (config.cic_seed >> 4);
+        cic_ram[0x0D] = config.cic_seed;
+        cic_ram[0x0E] = (config.cic_seed >> 4);
+        cic_ram[0x0F] = config.cic_seed;
+        cic_encode_round(0x0A);
+        cic_encode_round(0x0A);
+    }
 
     CIC_TIMEOUT_START();
 
-    cic_write_ram_nibbles(0x0A);
+    if (config.cic_stream_valid) {
+        cic_write_stream_nibbles(config.cic_seed_stream, 6);
+    } else {
+        cic_write_ram_nibbles(0x0A);
+    }
 
     if (CIC_TIMEOUT_ELAPSED()) {
         CIC_NOTIFY_INVALID_REGION();
@@ -213,6 +239,12 @@ static void cic_write_seed (void) {
 }
 
 static void cic_write_checksum (void) {
+    if (config.cic_stream_valid) {
+        cic_read();
+        cic_write_stream_nibbles(config.cic_checksum_stream[0], 8);
+        cic_write_stream_nibbles(config.cic_checksum_stream[1], 8);
+        return;
+    }
     for (int i = 0; i < 4; i++) {
         cic_ram[i] = 0x00;
     }
@@ -374,7 +406,7 @@ __attribute__((naked)) void cic_main (void) {
         CIC_SET_STEP(CIC_STEP_POWER_OFF);
         cic_wait_power_on();
 
-        CIC_SET_STEP(CIC_STEP_CONFIG_LOAD);
+        CIC_SET_STEP(CIC_STEP_CONFIG_LOAD | CIC_DEBUG_MARGIN_CLEAR);
         cic_load_config();
 
         CIC_SET_STEP(CIC_STEP_ID);
@@ -6,6 +6,7 @@ LD_SCRIPT = app.ld
 SRC_FILES = \
 	app.S \
 	app.c \
+	bist.c \
 	button.c \
 	cfg.c \
 	cic.c \
@@ -20,6 +21,7 @@ SRC_FILES = \
 	led.c \
 	rtc.c \
 	sd.c \
+	telemetry.c \
 	timer.c \
 	update.c \
 	usb.c \
@@ -3,6 +3,7 @@
 #include "cfg.h"
 #include "cic.h"
 #include "dd.h"
+#include "flash.h"
 #include "flashram.h"
 #include "fpga.h"
 #include "hw.h"
@@ -10,6 +11,7 @@
 #include "led.h"
 #include "rtc.h"
 #include "sd.h"
+#include "telemetry.h"
 #include "timer.h"
 #include "usb.h"
 #include "writeback.h"
@@ -22,16 +24,20 @@ void app (void) {
 
     while (fpga_id_get() != FPGA_ID);
 
+    fpga_spi_tune();
+
     rtc_init();
 
     button_init();
     cfg_init();
     cic_init();
     dd_init();
+    flash_init();
     flashram_init();
     isv_init();
     led_init();
     sd_init();
+    telemetry_init();
     usb_init();
     writeback_init();
 
@@ -40,11 +46,13 @@ void app (void) {
         cfg_process();
         cic_process();
         dd_process();
+        flash_process();
         flashram_process();
         isv_process();
         led_process();
         rtc_process();
         sd_process();
+        telemetry_process();
         usb_process();
         writeback_process();
     }
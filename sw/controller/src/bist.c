@@ -0,0 +1,52 @@
+#include "bist.h"
+#include "fpga.h"
+
+
+#define SDRAM_ADDRESS   (0x00000000UL)
+#define SDRAM_LENGTH    (64 * 1024 * 1024)
+
+
+bool bist_start (bool write_pass, bool verify_pass, bist_pattern_t pattern, bool invert, uint32_t data) {
+    if (bist_is_busy()) {
+        return true;
+    }
+    if (!(write_pass || verify_pass)) {
+        return true;
+    }
+    uint32_t scr = (
+        (invert ? BIST_SCR_INVERT : 0) |
+        (verify_pass ? BIST_SCR_VERIFY_PASS : 0) |
+        (write_pass ? BIST_SCR_WRITE_PASS : 0) |
+        ((pattern << BIST_SCR_PATTERN_BIT) & BIST_SCR_PATTERN_MASK) |
+        BIST_SCR_START
+    );
+    fpga_reg_set(REG_BIST_ADDRESS, SDRAM_ADDRESS);
+    fpga_reg_set(REG_BIST_LENGTH, SDRAM_LENGTH);
+    fpga_reg_set(REG_BIST_DATA, data);
+    fpga_reg_set(REG_BIST_SCR, scr);
+    return false;
+}
+
+void bist_stop (void) {
+    fpga_reg_set(REG_BIST_SCR, BIST_SCR_STOP);
+    while (bist_is_busy());
+}
+
+bool bist_is_busy (void) {
+    return (fpga_reg_get(REG_BIST_SCR) & BIST_SCR_BUSY);
+}
+
+uint32_t bist_get_error_count (void) {
+    return (fpga_reg_get(REG_BIST_SCR) >> BIST_SCR_ERROR_COUNT_BIT);
+}
+
+void bist_get_error (uint8_t index, uint32_t *address, uint32_t *data) {
+    if (index >= BIST_ERROR_LOG_LENGTH) {
+        *address = 0;
+        *data = 0;
+        return;
+    }
+    fpga_reg_set(REG_BIST_ERROR_0, (index << BIST_ERROR_SELECT_BIT));
+    *address = (fpga_reg_get(REG_BIST_ERROR_0) & BIST_ERROR_ADDRESS_MASK);
+    *data = fpga_reg_get(REG_BIST_ERROR_1);
+}
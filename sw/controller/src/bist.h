@@ -0,0 +1,27 @@
+#ifndef BIST_H__
+#define BIST_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define BIST_ERROR_LOG_LENGTH   (4)
+
+
+typedef enum {
+    BIST_PATTERN_CONSTANT = 0,
+    BIST_PATTERN_OWN_ADDRESS = 1,
+    BIST_PATTERN_WALKING = 2,
+    BIST_PATTERN_LFSR = 3,
+} bist_pattern_t;
+
+
+bool bist_start (bool write_pass, bool verify_pass, bist_pattern_t pattern, bool invert, uint32_t data);
+void bist_stop (void);
+bool bist_is_busy (void);
+uint32_t bist_get_error_count (void);
+void bist_get_error (uint8_t index, uint32_t *address, uint32_t *data);
+
+
+#endif
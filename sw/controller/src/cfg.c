@@ -99,6 +99,7 @@ typedef enum {
     SD_CARD_OP_GET_INFO = 3,
     SD_CARD_OP_BYTE_SWAP_ON = 4,
     SD_CARD_OP_BYTE_SWAP_OFF = 5,
+    SD_CARD_OP_GET_STATS = 6,
 } sd_card_op_t;
 
 typedef enum {
@@ -689,6 +690,13 @@ void cfg_process (void) {
                     }
                     break;
 
+                case SD_CARD_OP_GET_STATS:
+                    if (cfg_translate_address(&p.data[0], SD_CARD_STATS_SIZE, (SDRAM | BRAM))) {
+                        return cfg_cmd_reply_error(ERROR_TYPE_SD_CARD, SD_ERROR_INVALID_ADDRESS);
+                    }
+                    error = sd_card_get_stats(p.data[0]);
+                    break;
+
                 default:
                     error = SD_ERROR_INVALID_OPERATION;
                     break;
@@ -12,9 +12,76 @@ typedef enum {
 } cic_region_t;
 
 
+#define CIC_MARGIN_FIRST_STEP   (3)
+#define CIC_MARGIN_STEPS        (8)
+#define CIC_MARGIN_UNIT_CYCLES  (16)
+
+
 static bool cic_error_active = false;
 
 
+static void cic_encode_round (uint8_t *ram, int index) {
+    uint8_t data = ram[index++];
+    while (index < 16) {
+        data = ((((data + 1) & 0x0F) + ram[index]) & 0x0F);
+        ram[index++] = data;
+    }
+}
+
+static uint32_t cic_pack_nibbles (uint8_t *ram, int index, int count) {
+    uint32_t stream = 0;
+    for (int i = 0; i < count; i++) {
+        stream = ((stream << 4) | (ram[index + i] & 0x0F));
+    }
+    return stream;
+}
+
+static void cic_set_config (uint32_t *cfg) {
+    uint8_t seed = ((cfg[0] >> CIC_SEED_BIT) & 0xFF);
+    uint8_t checksum[6] = {
+        ((cfg[0] >> 8) & 0xFF),
+        (cfg[0] & 0xFF),
+        ((cfg[1] >> 24) & 0xFF),
+        ((cfg[1] >> 16) & 0xFF),
+        ((cfg[1] >> 8) & 0xFF),
+        (cfg[1] & 0xFF),
+    };
+    uint8_t ram[16];
+    uint32_t seed_stream;
+    uint32_t checksum_stream[2];
+
+    ram[0x0A] = 0x0B;
+    ram[0x0B] = 0x05;
+    ram[0x0C] = (seed >> 4);
+    ram[0x0D] = (seed & 0x0F);
+    ram[0x0E] = (seed >> 4);
+    ram[0x0F] = (seed & 0x0F);
+    cic_encode_round(ram, 0x0A);
+    cic_encode_round(ram, 0x0A);
+    seed_stream = cic_pack_nibbles(ram, 0x0A, 6);
+
+    for (int i = 0; i < 4; i++) {
+        ram[i] = 0x00;
+    }
+    for (int i = 0; i < 6; i++) {
+        ram[(i * 2) + 4] = (checksum[i] >> 4);
+        ram[(i * 2) + 5] = (checksum[i] & 0x0F);
+    }
+    for (int i = 0; i < 4; i++) {
+        cic_encode_round(ram, 0x00);
+    }
+    checksum_stream[0] = cic_pack_nibbles(ram, 0x00, 8);
+    checksum_stream[1] = cic_pack_nibbles(ram, 0x08, 8);
+
+    fpga_reg_set(REG_CIC_2, 0);
+    fpga_reg_set(REG_CIC_0, cfg[0]);
+    fpga_reg_set(REG_CIC_1, cfg[1]);
+    fpga_reg_set(REG_CIC_3, checksum_stream[0]);
+    fpga_reg_set(REG_CIC_4, checksum_stream[1]);
+    fpga_reg_set(REG_CIC_2, CIC_STREAM_VALID | seed_stream);
+}
+
+
 void cic_reset_parameters (void) {
     cic_region_t region = rtc_get_region();
 
@@ -30,8 +97,7 @@ void cic_reset_parameters (void) {
         cfg[0] |= CIC_REGION;
     }
 
-    fpga_reg_set(REG_CIC_0, cfg[0]);
-    fpga_reg_set(REG_CIC_1, cfg[1]);
+    cic_set_config(cfg);
 }
 
 void cic_set_parameters (uint32_t *args) {
@@ -46,8 +112,7 @@ void cic_set_parameters (uint32_t *args) {
         cfg[0] |= CIC_DISABLED;
     }
 
-    fpga_reg_set(REG_CIC_0, cfg[0]);
-    fpga_reg_set(REG_CIC_1, cfg[1]);
+    cic_set_config(cfg);
 }
 
 void cic_set_dd_mode (bool enabled) {
@@ -62,6 +127,24 @@ void cic_set_dd_mode (bool enabled) {
     fpga_reg_set(REG_CIC_0, cfg);
 }
 
+void cic_get_margins (uint32_t *margins) {
+    margins[0] = 0;
+    margins[1] = 0;
+
+    for (int i = 0; i < CIC_MARGIN_STEPS; i++) {
+        fpga_reg_set(REG_CIC_MARGIN, (CIC_MARGIN_FIRST_STEP + i) << CIC_MARGIN_STEP_BIT);
+        uint32_t value = fpga_reg_get(REG_CIC_MARGIN);
+        uint32_t margin = 0xFF;
+        if (value & CIC_MARGIN_VALID) {
+            margin = ((value & CIC_MARGIN_MASK) / CIC_MARGIN_UNIT_CYCLES);
+            if (margin > 0xFE) {
+                margin = 0xFE;
+            }
+        }
+        margins[i / 4] |= (margin << (24 - ((i % 4) * 8)));
+    }
+}
+
 
 void cic_init (void) {
     cic_reset_parameters();
@@ -9,6 +9,7 @@
 void cic_reset_parameters (void);
 void cic_set_parameters (uint32_t *args);
 void cic_set_dd_mode (bool enabled);
+void cic_get_margins (uint32_t *margins);
 
 void cic_init (void);
 
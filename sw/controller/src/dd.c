@@ -3,6 +3,7 @@
 #include "led.h"
 #include "rtc.h"
 #include "sd.h"
+#include "telemetry.h"
 #include "timer.h"
 #include "usb.h"
 
@@ -81,9 +82,11 @@ struct process {
     uint16_t head_track;
     uint8_t current_sector;
     sector_info_t sector_info;
+    bool sector_mapped;
     bool block_ready;
     bool block_valid;
     uint32_t block_offset;
+    uint32_t block_start_us;
     dd_drive_type_t drive_type;
     bool sd_mode;
     uint8_t sd_current_disk;
@@ -133,6 +136,7 @@ static uint32_t dd_fill_sd_sector_table (uint32_t index, uint32_t *sector_table,
 static bool dd_block_read_request (void) {
     uint16_t index = dd_track_head_block();
     uint32_t buffer_address = DD_BLOCK_BUFFER_ADDRESS;
+    p.block_start_us = telemetry_op_start();
     if (p.sd_mode) {
         sd_error_t error = sd_get_lock(SD_LOCK_N64);
         if (error == SD_OK) {
@@ -160,6 +164,7 @@ static bool dd_block_read_request (void) {
 static bool dd_block_write_request (void) {
     uint32_t index = dd_track_head_block();
     uint32_t buffer_address = DD_BLOCK_BUFFER_ADDRESS;
+    p.block_start_us = telemetry_op_start();
     if (p.sd_mode) {
         sd_error_t error = sd_get_lock(SD_LOCK_N64);
         if (error == SD_OK) {
@@ -186,6 +191,25 @@ static bool dd_block_write_request (void) {
     return true;
 }
 
+static bool dd_sector_sequencer_start (uint8_t sectors) {
+    uint32_t address = (DD_BLOCK_BUFFER_ADDRESS + p.block_offset);
+    uint32_t sector_length = (p.sector_info.sector_size + 1);
+    if (((address % 2) != 0) || ((sector_length % 2) != 0)) {
+        return false;
+    }
+    fpga_reg_set(REG_DD_SEQ_ADDRESS, address);
+    fpga_reg_set(REG_DD_SEQ_SCR, (sectors << DD_SEQ_SCR_COUNT_BIT) | DD_SEQ_SCR_START);
+    p.sector_mapped = true;
+    return true;
+}
+
+static void dd_sector_sequencer_stop (void) {
+    if (p.sector_mapped) {
+        fpga_reg_set(REG_DD_SEQ_SCR, DD_SEQ_SCR_STOP);
+        p.sector_mapped = false;
+    }
+}
+
 
 void dd_set_block_ready (bool valid) {
     p.block_ready = true;
@@ -293,7 +317,9 @@ void dd_init (void) {
     fpga_reg_set(REG_DD_SCR, 0);
     fpga_reg_set(REG_DD_HEAD_TRACK, 0);
     fpga_reg_set(REG_DD_DRIVE_ID, DD_DRIVE_ID_RETAIL);
+    fpga_reg_set(REG_DD_SEQ_SCR, DD_SEQ_SCR_STOP);
     p.state = STATE_IDLE;
+    p.sector_mapped = false;
     p.cmd_response_delayed = false;
     p.disk_spinning = false;
     p.bm_running = false;
@@ -314,6 +340,7 @@ void dd_process (void) {
         p.disk_spinning = false;
         p.bm_running = false;
         p.head_track = 0;
+        p.sector_mapped = false;
         scr &= ~(DD_SCR_DISK_CHANGED);
     }
 
@@ -405,7 +432,9 @@ void dd_process (void) {
         scr |= DD_SCR_BM_STOP_CLEAR;
         scr &= ~(DD_SCR_BM_MICRO_ERROR | DD_SCR_BM_TRANSFER_C2 | DD_SCR_BM_TRANSFER_DATA);
         p.bm_running = false;
+        dd_sector_sequencer_stop();
     } else if (scr & DD_SCR_BM_START) {
+        dd_sector_sequencer_stop();
         scr |= DD_SCR_BM_CLEAR | DD_SCR_BM_ACK_CLEAR | DD_SCR_BM_START_CLEAR;
         scr &= ~(DD_SCR_BM_MICRO_ERROR | DD_SCR_BM_TRANSFER_C2 | DD_SCR_BM_TRANSFER_DATA);
         p.state = STATE_START;
@@ -422,6 +451,7 @@ void dd_process (void) {
                     p.state = STATE_SECTOR_READ;
                 } else if (p.current_sector == (p.sector_info.sectors_in_block - 4)) {
                     p.current_sector += 1;
+                    p.sector_mapped = false;
                     scr &= ~(DD_SCR_BM_TRANSFER_DATA);
                     scr |= DD_SCR_BM_READY;
                 } else if (p.current_sector >= p.sector_info.sectors_in_block) {
@@ -465,8 +495,14 @@ void dd_process (void) {
 
             case STATE_BLOCK_READ_WAIT:
                 if (p.block_ready) {
+                    telemetry_op_done(TELEMETRY_OP_DD, p.block_start_us);
+                    uint8_t data_sectors = (p.sector_info.sectors_in_block - 4);
                     if (p.transfer_mode) {
-                        if (p.block_valid) {
+                        if (p.block_valid && dd_sector_sequencer_start(data_sectors)) {
+                            p.state = STATE_IDLE;
+                            p.current_sector = data_sectors;
+                            scr |= DD_SCR_BM_TRANSFER_DATA | DD_SCR_BM_READY;
+                        } else if (p.block_valid) {
                             p.state = STATE_SECTOR_READ;
                             scr |= DD_SCR_BM_TRANSFER_DATA;
                         } else {
@@ -476,6 +512,9 @@ void dd_process (void) {
                     } else {
                         p.state = STATE_IDLE;
                         if (p.block_valid) {
+                            if (dd_sector_sequencer_start(data_sectors)) {
+                                p.current_sector = (data_sectors - 1);
+                            }
                             scr |= DD_SCR_BM_TRANSFER_DATA | DD_SCR_BM_READY;
                         } else {
                             scr |= DD_SCR_BM_MICRO_ERROR | DD_SCR_BM_READY;
@@ -496,11 +535,15 @@ void dd_process (void) {
                 break;
 
             case STATE_SECTOR_WRITE:
-                fpga_mem_copy(
-                    DD_SECTOR_BUFFER_ADDRESS,
-                    DD_BLOCK_BUFFER_ADDRESS + p.block_offset + (p.current_sector * (p.sector_info.sector_size + 1)),
-                    p.sector_info.sector_size + 1
-                );
+                if (p.sector_mapped) {
+                    p.sector_mapped = false;
+                } else {
+                    fpga_mem_copy(
+                        DD_SECTOR_BUFFER_ADDRESS,
+                        DD_BLOCK_BUFFER_ADDRESS + p.block_offset + (p.current_sector * (p.sector_info.sector_size + 1)),
+                        p.sector_info.sector_size + 1
+                    );
+                }
                 p.current_sector += 1;
                 if (p.current_sector < (p.sector_info.sectors_in_block - 4)) {
                     p.state = STATE_IDLE;
@@ -518,6 +561,7 @@ void dd_process (void) {
 
             case STATE_BLOCK_WRITE_WAIT:
                 if (p.block_ready) {
+                    telemetry_op_done(TELEMETRY_OP_DD, p.block_start_us);
                     p.state = STATE_NEXT_BLOCK;
                 }
                 break;
@@ -5,6 +5,34 @@
 #define FLASH_ADDRESS       (0x04000000UL)
 #define FLASH_SIZE          (16 * 1024 * 1024)
 #define ERASE_BLOCK_SIZE    (64 * 1024)
+#define ERASE_RANGES        (8)
+
+
+typedef struct {
+    uint32_t address;
+    uint32_t length;
+} flash_erase_range_t;
+
+struct process {
+    flash_erase_range_t erase_ranges[ERASE_RANGES];
+    uint8_t erase_head;
+    uint8_t erase_count;
+    uint32_t erase_length;
+};
+
+
+static struct process p;
+
+
+static bool flash_is_busy (void) {
+    return (fpga_reg_get(REG_FLASH_SCR) & (FLASH_SCR_BUSY | FLASH_SCR_MEMORY_BUSY));
+}
+
+static void flash_erase_range_finish (void) {
+    while (p.erase_length > 0) {
+        flash_process();
+    }
+}
 
 
 bool flash_program (uint32_t src, uint32_t dst, uint32_t length) {
@@ -17,6 +45,7 @@ bool flash_program (uint32_t src, uint32_t dst, uint32_t length) {
     if ((dst <= src) && ((dst + length) > src)) {
         return true;
     }
+    flash_erase_range_finish();
     while (length > 0) {
         uint32_t block = (length > FPGA_MAX_MEM_TRANSFER) ? FPGA_MAX_MEM_TRANSFER : length;
         fpga_mem_copy(src, dst, block);
@@ -29,6 +58,7 @@ bool flash_program (uint32_t src, uint32_t dst, uint32_t length) {
 
 void flash_wait_busy (void) {
     uint8_t dummy[2];
+    flash_erase_range_finish();
     fpga_mem_read(FLASH_ADDRESS, 2, dummy);
 }
 
@@ -39,6 +69,7 @@ bool flash_erase_block (uint32_t address) {
     if ((address < FLASH_ADDRESS) || (address >= (FLASH_ADDRESS + FLASH_SIZE))) {
         return true;
     }
+    flash_erase_range_finish();
     address &= (FLASH_SIZE - 1);
     for (int i = 0; i < (FLASH_ERASE_BLOCK_SIZE / ERASE_BLOCK_SIZE); i++) {
         fpga_reg_set(REG_FLASH_SCR, address);
@@ -48,3 +79,48 @@ bool flash_erase_block (uint32_t address) {
     flash_wait_busy();
     return false;
 }
+
+bool flash_erase_range (uint32_t address, uint32_t length) {
+    if (p.erase_count >= ERASE_RANGES) {
+        return true;
+    }
+    if (((address % FLASH_ERASE_BLOCK_SIZE) != 0) || (length == 0)) {
+        return true;
+    }
+    if ((address < FLASH_ADDRESS) || ((address + length) > (FLASH_ADDRESS + FLASH_SIZE))) {
+        return true;
+    }
+    flash_erase_range_t *range = &p.erase_ranges[(p.erase_head + p.erase_count) % ERASE_RANGES];
+    range->address = address;
+    range->length = ((length + FLASH_ERASE_BLOCK_SIZE - 1) / FLASH_ERASE_BLOCK_SIZE) * FLASH_ERASE_BLOCK_SIZE;
+    p.erase_count += 1;
+    p.erase_length += range->length;
+    return false;
+}
+
+bool flash_erase_range_status (uint32_t *remaining) {
+    *remaining = p.erase_length;
+    return ((p.erase_length > 0) || flash_is_busy());
+}
+
+
+void flash_init (void) {
+    p.erase_head = 0;
+    p.erase_count = 0;
+    p.erase_length = 0;
+}
+
+
+void flash_process (void) {
+    if ((p.erase_length > 0) && !flash_is_busy()) {
+        flash_erase_range_t *range = &p.erase_ranges[p.erase_head];
+        fpga_reg_set(REG_FLASH_SCR, (range->address & (FLASH_SIZE - 1)));
+        range->address += ERASE_BLOCK_SIZE;
+        range->length -= ERASE_BLOCK_SIZE;
+        p.erase_length -= ERASE_BLOCK_SIZE;
+        if (range->length == 0) {
+            p.erase_head = ((p.erase_head + 1) % ERASE_RANGES);
+            p.erase_count -= 1;
+        }
+    }
+}
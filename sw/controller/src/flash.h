@@ -12,6 +12,11 @@
 bool flash_program (uint32_t src, uint32_t dst, uint32_t length);
 void flash_wait_busy (void);
 bool flash_erase_block (uint32_t address);
+bool flash_erase_range (uint32_t address, uint32_t length);
+bool flash_erase_range_status (uint32_t *remaining);
+
+void flash_init (void);
+void flash_process (void);
 
 
 #endif
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include "fpga.h"
+#include "telemetry.h"
 
 
 #define FLASHRAM_SIZE           (128 * 1024)
@@ -50,6 +51,8 @@ void flashram_process (void) {
         return;
     }
 
+    uint32_t start_us = telemetry_op_start();
+
     uint8_t write_buffer[FLASHRAM_PAGE_SIZE];
 
     uint32_t page = ((scr & FLASHRAM_SCR_PAGE_MASK) >> FLASHRAM_SCR_PAGE_BIT);
@@ -83,4 +86,6 @@ void flashram_process (void) {
     }
 
     fpga_reg_set(REG_FLASHRAM_SCR, FLASHRAM_SCR_DONE);
+
+    telemetry_op_done(TELEMETRY_OP_FLASHRAM, start_us);
 }
@@ -2,6 +2,79 @@
 #include "hw.h"
 
 
+// Zero length CRC calculation returns the seed, FPGA designs without CRC engine read back zero
+#define CRC32_PROBE_SEED    (0x53433634UL)
+
+// Read-only register with a fixed value, safe to read back while MOSI sampling is still untrusted
+#define CFG_IDENTIFIER      (0x53437632UL)
+
+#define SPI_TUNING_DELAYS   (4)
+#define SPI_TUNING_TESTS    (8)
+
+
+static const spi_divider_t spi_tuning_dividers[] = {
+    SPI_DIVIDER_4,
+    SPI_DIVIDER_8,
+};
+
+static uint8_t spi_tuning_pattern[] = {
+    0x00, 0xFF, 0x55, 0xAA, 0x33, 0xCC, 0x0F, 0xF0,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F,
+};
+
+
+static void fpga_buffer_read (size_t length, uint8_t *buffer) {
+    fpga_cmd_t cmd = CMD_MEM_READ;
+    uint8_t buffer_address = 0;
+
+    hw_spi_start();
+    hw_spi_tx((uint8_t *) (&cmd), 1);
+    hw_spi_tx(&buffer_address, 1);
+    hw_spi_rx(buffer, length);
+    hw_spi_stop();
+}
+
+static void fpga_buffer_write (size_t length, uint8_t *buffer) {
+    fpga_cmd_t cmd = CMD_MEM_WRITE;
+    uint8_t buffer_address = 0;
+
+    hw_spi_start();
+    hw_spi_tx((uint8_t *) (&cmd), 1);
+    hw_spi_tx(&buffer_address, 1);
+    hw_spi_tx(buffer, length);
+    hw_spi_stop();
+}
+
+static bool fpga_spi_test (spi_divider_t divider, uint8_t sample_delay) {
+    uint8_t buffer[sizeof(spi_tuning_pattern)];
+    bool passed = true;
+
+    hw_spi_set_divider(SPI_DIVIDER_8);
+    fpga_reg_set(REG_SPI_SCR, (sample_delay << SPI_SCR_SAMPLE_DELAY_BIT) & SPI_SCR_SAMPLE_DELAY_MASK);
+
+    hw_spi_set_divider(divider);
+    for (int test = 0; (test < SPI_TUNING_TESTS) && passed; test++) {
+        if ((fpga_id_get() != FPGA_ID) || (fpga_reg_get(REG_CFG_IDENTIFIER) != CFG_IDENTIFIER)) {
+            passed = false;
+        }
+    }
+    for (int test = 0; (test < SPI_TUNING_TESTS) && passed; test++) {
+        fpga_buffer_write(sizeof(spi_tuning_pattern), spi_tuning_pattern);
+        fpga_buffer_read(sizeof(buffer), buffer);
+        for (int i = 0; i < sizeof(spi_tuning_pattern); i++) {
+            if (buffer[i] != spi_tuning_pattern[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    hw_spi_set_divider(SPI_DIVIDER_8);
+
+    return passed;
+}
+
+
 uint8_t fpga_id_get (void) {
     fpga_cmd_t cmd = CMD_IDENTIFY;
     uint8_t id;
@@ -38,41 +111,51 @@ void fpga_reg_set (fpga_reg_t reg, uint32_t value) {
 }
 
 void fpga_mem_read (uint32_t address, size_t length, uint8_t *buffer) {
-    fpga_cmd_t cmd = CMD_MEM_READ;
-    uint8_t buffer_address = 0;
-    size_t dma_length = length;
-    if ((dma_length % 2) != 0) {
-        dma_length += 1;
-    }
+    fpga_cmd_t cmd = CMD_MEM_STREAM_READ;
+    uint8_t status;
 
-    fpga_reg_set(REG_MEM_ADDRESS, address);
-    fpga_reg_set(REG_MEM_SCR, (dma_length << MEM_SCR_LENGTH_BIT) | MEM_SCR_START);
-    while (fpga_reg_get(REG_MEM_SCR) & MEM_SCR_BUSY);
+    // Stream length counter in the FPGA covers one transfer buffer, longer requests are split
+    while (length > 0) {
+        uint16_t stream_length = (length > FPGA_MAX_MEM_TRANSFER) ? FPGA_MAX_MEM_TRANSFER : length;
 
-    hw_spi_start();
-    hw_spi_tx((uint8_t *) (&cmd), 1);
-    hw_spi_tx(&buffer_address, 1);
-    hw_spi_rx(buffer, length);
-    hw_spi_stop();
+        hw_spi_start();
+        hw_spi_tx((uint8_t *) (&cmd), 1);
+        hw_spi_tx((uint8_t *) (&address), 4);
+        hw_spi_tx((uint8_t *) (&stream_length), 2);
+        do {
+            hw_spi_rx(&status, 1);
+        } while (!(status & MEM_STREAM_STATUS_READY));
+        hw_spi_rx(buffer, stream_length);
+        hw_spi_stop();
+
+        address += stream_length;
+        length -= stream_length;
+        buffer += stream_length;
+    }
 }
 
 void fpga_mem_write (uint32_t address, size_t length, uint8_t *buffer) {
-    fpga_cmd_t cmd = CMD_MEM_WRITE;
-    uint8_t buffer_address = 0;
-    size_t dma_length = length;
-    if ((dma_length % 2) != 0) {
-        dma_length += 1;
-    }
+    fpga_cmd_t cmd = CMD_MEM_STREAM_WRITE;
+    uint8_t status;
 
-    hw_spi_start();
-    hw_spi_tx((uint8_t *) (&cmd), 1);
-    hw_spi_tx(&buffer_address, 1);
-    hw_spi_tx(buffer, length);
-    hw_spi_stop();
+    // Stream length counter in the FPGA covers one transfer buffer, longer requests are split
+    while (length > 0) {
+        uint16_t stream_length = (length > FPGA_MAX_MEM_TRANSFER) ? FPGA_MAX_MEM_TRANSFER : length;
 
-    fpga_reg_set(REG_MEM_ADDRESS, address);
-    fpga_reg_set(REG_MEM_SCR, (dma_length << MEM_SCR_LENGTH_BIT) | MEM_SCR_DIRECTION | MEM_SCR_START);
-    while (fpga_reg_get(REG_MEM_SCR) & MEM_SCR_BUSY);
+        hw_spi_start();
+        hw_spi_tx((uint8_t *) (&cmd), 1);
+        hw_spi_tx((uint8_t *) (&address), 4);
+        hw_spi_tx((uint8_t *) (&stream_length), 2);
+        hw_spi_tx(buffer, stream_length);
+        do {
+            hw_spi_rx(&status, 1);
+        } while (!(status & MEM_STREAM_STATUS_READY));
+        hw_spi_stop();
+
+        address += stream_length;
+        length -= stream_length;
+        buffer += stream_length;
+    }
 }
 
 void fpga_mem_copy (uint32_t src, uint32_t dst, size_t length) {
@@ -90,6 +173,28 @@ void fpga_mem_copy (uint32_t src, uint32_t dst, size_t length) {
     while (fpga_reg_get(REG_MEM_SCR) & MEM_SCR_BUSY);
 }
 
+bool fpga_mem_crc32 (uint32_t address, size_t length, uint32_t *crc) {
+    if (((address % 2) != 0) || (fpga_reg_get(REG_BIST_SCR) & BIST_SCR_BUSY)) {
+        return true;
+    }
+
+    fpga_reg_set(REG_BIST_LENGTH, 0);
+    fpga_reg_set(REG_BIST_CRC, CRC32_PROBE_SEED);
+    while (fpga_reg_get(REG_BIST_SCR) & BIST_SCR_BUSY);
+    if (fpga_reg_get(REG_BIST_CRC) != CRC32_PROBE_SEED) {
+        return true;
+    }
+
+    fpga_reg_set(REG_BIST_ADDRESS, address);
+    fpga_reg_set(REG_BIST_LENGTH, length);
+    fpga_reg_set(REG_BIST_CRC, *crc);
+    while (fpga_reg_get(REG_BIST_SCR) & BIST_SCR_BUSY);
+
+    *crc = fpga_reg_get(REG_BIST_CRC);
+
+    return false;
+}
+
 uint8_t fpga_usb_status_get (void) {
     fpga_cmd_t cmd = CMD_USB_STATUS;
     uint8_t status;
@@ -122,3 +227,42 @@ void fpga_usb_push (uint8_t data) {
     hw_spi_tx(&data, 1);
     hw_spi_stop();
 }
+
+void fpga_spi_tune (void) {
+    int dividers_count = (sizeof(spi_tuning_dividers) / sizeof(spi_divider_t));
+
+    for (int d = 0; d < dividers_count; d++) {
+        bool passed[SPI_TUNING_DELAYS];
+        int best_score = 0;
+        uint8_t best_delay = 0;
+
+        for (int delay = 0; delay < SPI_TUNING_DELAYS; delay++) {
+            passed[delay] = fpga_spi_test(spi_tuning_dividers[d], delay);
+        }
+
+        for (int delay = 0; delay < SPI_TUNING_DELAYS; delay++) {
+            if (!passed[delay]) {
+                continue;
+            }
+            int score = 1;
+            if ((delay > 0) && passed[delay - 1]) {
+                score += 1;
+            }
+            if ((delay < (SPI_TUNING_DELAYS - 1)) && passed[delay + 1]) {
+                score += 1;
+            }
+            if (score > best_score) {
+                best_score = score;
+                best_delay = delay;
+            }
+        }
+
+        if (best_score > 0) {
+            fpga_reg_set(REG_SPI_SCR, (best_delay << SPI_SCR_SAMPLE_DELAY_BIT) & SPI_SCR_SAMPLE_DELAY_MASK);
+            hw_spi_set_divider(spi_tuning_dividers[d]);
+            return;
+        }
+    }
+
+    fpga_reg_set(REG_SPI_SCR, 0);
+}
@@ -2,6 +2,7 @@
 #define FPGA_H__
 
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -14,7 +15,9 @@ typedef enum {
     CMD_MEM_WRITE,
     CMD_USB_STATUS,
     CMD_USB_READ,
-    CMD_USB_WRITE
+    CMD_USB_WRITE,
+    CMD_MEM_STREAM_READ,
+    CMD_MEM_STREAM_WRITE,
 } fpga_cmd_t;
 
 typedef enum {
@@ -58,6 +61,21 @@ typedef enum {
     REG_CIC_0,
     REG_CIC_1,
     REG_AUX,
+    REG_BIST_ADDRESS,
+    REG_BIST_LENGTH,
+    REG_BIST_DATA,
+    REG_BIST_SCR,
+    REG_BIST_ERROR_0,
+    REG_BIST_ERROR_1,
+    REG_BIST_CRC,
+    REG_USB_FIFO_COUNT,
+    REG_DD_SEQ_ADDRESS,
+    REG_DD_SEQ_SCR,
+    REG_SPI_SCR,
+    REG_CIC_2,
+    REG_CIC_3,
+    REG_CIC_4,
+    REG_CIC_MARGIN,
 } fpga_reg_t;
 
 
@@ -66,7 +84,7 @@ typedef enum {
 
 #define FPGA_ID                         (0x64)
 
-#define FPGA_MAX_MEM_TRANSFER           (1024)
+#define FPGA_MAX_MEM_TRANSFER           (2048)
 
 #define USB_STATUS_RXNE                 (1 << 0)
 #define USB_STATUS_TXE                  (1 << 1)
@@ -77,6 +95,8 @@ typedef enum {
 #define MEM_SCR_BUSY                    (1 << 3)
 #define MEM_SCR_LENGTH_BIT              (4)
 
+#define MEM_STREAM_STATUS_READY         (1 << 0)
+
 #define USB_SCR_FIFO_FLUSH              (1 << 0)
 #define USB_SCR_RXNE                    (1 << 1)
 #define USB_SCR_TXE                     (1 << 2)
@@ -92,6 +112,11 @@ typedef enum {
 #define USB_SCR_FIFO_FLUSH_BUSY         (1 << 30)
 #define USB_SCR_IRQ                     (1 << 31)
 
+#define USB_FIFO_COUNT_RX_BIT           (0)
+#define USB_FIFO_COUNT_RX_MASK          (0xFFFF << USB_FIFO_COUNT_RX_BIT)
+#define USB_FIFO_COUNT_TX_BIT           (16)
+#define USB_FIFO_COUNT_TX_MASK          (0xFFFFUL << USB_FIFO_COUNT_TX_BIT)
+
 #define DMA_SCR_START                   (1 << 0)
 #define DMA_SCR_STOP                    (1 << 1)
 #define DMA_SCR_DIRECTION               (1 << 2)
@@ -129,18 +154,19 @@ typedef enum {
 #define FLASHRAM_SCR_WRITE_OR_ERASE     (1 << 13)
 
 #define FLASH_SCR_BUSY                  (1 << 0)
+#define FLASH_SCR_MEMORY_BUSY           (1 << 1)
 
 #define RTC_SCR_PENDING                 (1 << 0)
 #define RTC_SCR_DONE                    (1 << 1)
 #define RTC_SCR_MAGIC                   (0x52544300)
 #define RTC_SCR_MAGIC_MASK              (0xFFFFFF00)
 
-#define SD_SCR_CLOCK_MODE_OFF           (0 << 0)
-#define SD_SCR_CLOCK_MODE_400KHZ        (1 << 0)
-#define SD_SCR_CLOCK_MODE_25MHZ         (2 << 0)
-#define SD_SCR_CLOCK_MODE_50MHZ         (3 << 0)
-#define SD_SCR_CLOCK_MODE_BIT           (0)
-#define SD_SCR_CLOCK_MODE_MASK          (0x3 << SD_SCR_CLOCK_MODE_BIT)
+#define SD_SCR_CLOCK_ENABLE             (1 << 0)
+#define SD_SCR_CLOCK_CONFIG             (1 << 1)
+#define SD_SCR_CLOCK_PERIOD_BIT         (8)
+#define SD_SCR_CLOCK_PERIOD_MASK        (0xFF << SD_SCR_CLOCK_PERIOD_BIT)
+#define SD_SCR_DAT_SAMPLE_DELAY_BIT     (16)
+#define SD_SCR_DAT_SAMPLE_DELAY_MASK    (0x3 << SD_SCR_DAT_SAMPLE_DELAY_BIT)
 #define SD_SCR_CMD_BUSY                 (1 << 2)
 #define SD_SCR_CMD_ERROR                (1 << 3)
 #define SD_SCR_CARD_BUSY                (1 << 4)
@@ -192,12 +218,38 @@ typedef enum {
 #define DD_HEAD_TRACK_MASK              (DD_HEAD_MASK | DD_TRACK_MASK)
 #define DD_HEAD_TRACK_INDEX_LOCK        (1 << 13)
 
+#define DD_SEQ_SCR_START                (1 << 0)
+#define DD_SEQ_SCR_ACTIVE               (1 << 0)
+#define DD_SEQ_SCR_STOP                 (1 << 1)
+#define DD_SEQ_SCR_COUNT_BIT            (8)
+#define DD_SEQ_SCR_SECTOR_BIT           (8)
+#define DD_SEQ_SCR_SECTOR_MASK          (0xFF << DD_SEQ_SCR_SECTOR_BIT)
+
+#define SPI_SCR_SAMPLE_DELAY_BIT        (0)
+#define SPI_SCR_SAMPLE_DELAY_MASK       (0x3 << SPI_SCR_SAMPLE_DELAY_BIT)
+
 #define CIC_SEED_BIT                    (16)
 #define CIC_REGION                      (1 << 24)
 #define CIC_64DD_MODE                   (1 << 25)
 #define CIC_DISABLED                    (1 << 26)
 #define CIC_INVALID_REGION_DETECTED     (1 << 27)
 #define CIC_INVALID_REGION_RESET        (1 << 28)
+#define CIC_STREAM_VALID                (1UL << 31)
+#define CIC_MARGIN_MASK                 (0xFFFF)
+#define CIC_MARGIN_STEP_BIT             (16)
+#define CIC_MARGIN_VALID                (1 << 20)
+
+#define BIST_SCR_START                  (1 << 0)
+#define BIST_SCR_STOP                   (1 << 1)
+#define BIST_SCR_BUSY                   (1 << 2)
+#define BIST_SCR_WRITE_PASS             (1 << 3)
+#define BIST_SCR_VERIFY_PASS            (1 << 4)
+#define BIST_SCR_INVERT                 (1 << 5)
+#define BIST_SCR_PATTERN_BIT            (6)
+#define BIST_SCR_PATTERN_MASK           (0x3 << BIST_SCR_PATTERN_BIT)
+#define BIST_SCR_ERROR_COUNT_BIT        (8)
+#define BIST_ERROR_ADDRESS_MASK         (0x07FFFFFF)
+#define BIST_ERROR_SELECT_BIT           (27)
 
 
 uint8_t fpga_id_get (void);
@@ -206,9 +258,11 @@ void fpga_reg_set (fpga_reg_t reg, uint32_t value);
 void fpga_mem_read (uint32_t address, size_t length, uint8_t *buffer);
 void fpga_mem_write (uint32_t address, size_t length, uint8_t *buffer);
 void fpga_mem_copy (uint32_t src, uint32_t dst, size_t length);
+bool fpga_mem_crc32 (uint32_t address, size_t length, uint32_t *crc);
 uint8_t fpga_usb_status_get (void);
 uint8_t fpga_usb_pop (void);
 void fpga_usb_push (uint8_t data);
+void fpga_spi_tune (void);
 
 
 #endif
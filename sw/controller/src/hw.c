@@ -41,79 +41,92 @@ static void hw_clock_init (void) {
 }
 
 
-#define TIMEOUT_US_PER_TICK (10)
+#define TIMEBASE_US_PER_TICK    (1)
 
-static void hw_timeout_init (void) {
+static void hw_timebase_init (void) {
     RCC->APBENR1 |= RCC_APBENR1_DBGEN;
+    DBG->APBFZ1 |= DBG_APB_FZ1_DBG_TIM3_STOP;
     DBG->APBFZ2 |= DBG_APB_FZ2_DBG_TIM1_STOP;
 
+    RCC->APBENR1 |= RCC_APBENR1_TIM3EN;
     RCC->APBENR2 |= RCC_APBENR2_TIM1EN;
 
-    TIM1->CR1 = TIM_CR1_OPM;
-    TIM1->PSC = (((CPU_FREQ / 1000 / 1000) * TIMEOUT_US_PER_TICK) - 1);
+    TIM1->PSC = (((CPU_FREQ / 1000 / 1000) * TIMEBASE_US_PER_TICK) - 1);
+    TIM1->ARR = 0xFFFF;
+    TIM1->CR2 = TIM_CR2_MMS_1;
     TIM1->EGR = TIM_EGR_UG;
+
+    TIM3->PSC = 0;
+    TIM3->ARR = 0xFFFF;
+    TIM3->SMCR = (TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0);
+    TIM3->EGR = TIM_EGR_UG;
+    TIM3->CNT = 0;
+
+    TIM3->CR1 = TIM_CR1_CEN;
+    TIM1->CR1 = TIM_CR1_CEN;
 }
 
+uint32_t hw_timebase_get_us (void) {
+    uint16_t high;
+    uint16_t low;
+
+    // TIM3 counts TIM1 overflows, it increments a few cycles after TIM1 wraps to zero
+    do {
+        high = TIM3->CNT;
+        low = TIM1->CNT;
+    } while ((high != TIM3->CNT) || (low == 0));
+
+    return ((((uint32_t) (high) << 16) | low) * TIMEBASE_US_PER_TICK);
+}
+
+
+static uint32_t timeout_start_us;
+
 static void hw_timeout_start (void) {
-    TIM1->CR1 &= ~(TIM_CR1_CEN);
-    TIM1->CNT = 0;
-    TIM1->CR1 |= TIM_CR1_CEN;
+    timeout_start_us = hw_timebase_get_us();
 }
 
 static bool hw_timeout_elapsed (uint32_t timeout_us) {
-    uint16_t count = TIM1->CNT;
+    return ((hw_timebase_get_us() - timeout_start_us) >= timeout_us);
+}
 
-    uint32_t adjusted_timeout = ((timeout_us + (TIMEOUT_US_PER_TICK - 1)) / TIMEOUT_US_PER_TICK);
 
-    if ((count >= adjusted_timeout) || (count == 0xFFFF)) {
-        return true;
-    }
+void hw_delay_us (uint32_t delay_us) {
+    uint32_t start_us = hw_timebase_get_us();
+    while ((hw_timebase_get_us() - start_us) < delay_us);
+}
 
-    return false;
+void hw_delay_ms (uint32_t delay_ms) {
+    hw_delay_us(delay_ms * 1000);
 }
 
 
-#define DELAY_US_PER_TICK   (1)
-#define DELAY_MS_PER_TICK   (1)
+#define STOPWATCH_MS_PER_TICK   (1)
 
-static void hw_delay_init (void) {
+static void hw_stopwatch_init (void) {
     RCC->APBENR1 |= RCC_APBENR1_DBGEN;
-    DBG->APBFZ1 |= DBG_APB_FZ1_DBG_TIM3_STOP;
+    DBG->APBFZ2 |= DBG_APB_FZ2_DBG_TIM14_STOP;
 
-    RCC->APBENR1 |= RCC_APBENR1_TIM3EN;
+    RCC->APBENR2 |= RCC_APBENR2_TIM14EN;
 
-    TIM3->CR1 = TIM_CR1_OPM;
-    TIM3->EGR = TIM_EGR_UG;
+    TIM14->PSC = (((CPU_FREQ / 1000) * STOPWATCH_MS_PER_TICK) - 1);
+    TIM14->ARR = 0xFFFF;
+    TIM14->EGR = TIM_EGR_UG;
 }
 
-void hw_delay_us (uint32_t delay_us) {
-    TIM3->CR1 &= ~(TIM_CR1_CEN);
-    TIM3->PSC = (((CPU_FREQ / 1000 / 1000) * DELAY_US_PER_TICK) - 1);
-    TIM3->CNT = 0;
-    TIM3->EGR = TIM_EGR_UG;
-    TIM3->CR1 |= TIM_CR1_CEN;
-
-    uint32_t adjusted_delay = ((delay_us + (DELAY_US_PER_TICK - 1)) / DELAY_US_PER_TICK);
-
-    uint16_t count;
-    do {
-        count = TIM3->CNT;
-    } while ((count < adjusted_delay) && (count != 0xFFFF));
+void hw_stopwatch_start (void) {
+    TIM14->CR1 &= ~(TIM_CR1_CEN);
+    TIM14->CNT = 0;
+    TIM14->SR = 0;
+    TIM14->CR1 |= TIM_CR1_CEN;
 }
 
-void hw_delay_ms (uint32_t delay_ms) {
-    TIM3->CR1 &= ~(TIM_CR1_CEN);
-    TIM3->PSC = (((CPU_FREQ / 1000) * DELAY_MS_PER_TICK) - 1);
-    TIM3->CNT = 0;
-    TIM3->EGR = TIM_EGR_UG;
-    TIM3->CR1 |= TIM_CR1_CEN;
-
-    uint32_t adjusted_delay = ((delay_ms + (DELAY_MS_PER_TICK - 1)) / DELAY_MS_PER_TICK);
-
-    uint16_t count;
-    do {
-        count = TIM3->CNT;
-    } while ((count < adjusted_delay) && (count != 0xFFFF));
+uint32_t hw_stopwatch_get_ms (void) {
+    uint32_t count = TIM14->CNT;
+    if (TIM14->SR & TIM_SR_UIF) {
+        count = (0x10000 + TIM14->CNT);
+    }
+    return (count * STOPWATCH_MS_PER_TICK);
 }
 
 
@@ -264,7 +277,7 @@ static void hw_spi_init (void) {
     SPI1->CR1 = (
         SPI_CR1_SSM |
         SPI_CR1_SSI |
-        SPI_CR1_BR_1 |
+        (SPI_DIVIDER_8 << SPI_CR1_BR_Pos) |
         SPI_CR1_SPE |
         SPI_CR1_MSTR |
         SPI_CR1_CPHA
@@ -321,9 +334,26 @@ void hw_spi_tx (uint8_t *data, int length) {
     DMA1_Channel2->CCR = 0;
 }
 
+void hw_spi_set_divider (spi_divider_t divider) {
+    while (SPI1->SR & SPI_SR_BSY);
+    SPI1->CR1 &= ~(SPI_CR1_SPE);
+    SPI1->CR1 = ((SPI1->CR1 & ~(SPI_CR1_BR)) | (divider << SPI_CR1_BR_Pos));
+    SPI1->CR1 |= SPI_CR1_SPE;
+}
+
 
 #define I2C_TIMEOUT_US_BUSY     (10000)
 #define I2C_TIMEOUT_US_PER_BYTE (1000)
+#define I2C_TIMEOUT_SCL_LOW     (780)
+
+#define I2C_ICR_ALL             (I2C_ICR_NACKCF | I2C_ICR_STOPCF | I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_TIMOUTCF)
+
+static bool i2c_irq_enabled = false;
+static i2c_transfer_t *volatile i2c_queue_head = NULL;
+static i2c_transfer_t *i2c_queue_tail = NULL;
+static uint8_t *i2c_tx_data;
+static uint8_t *i2c_rx_data;
+static i2c_error_t i2c_error;
 
 static void hw_i2c_init (void) {
     RCC->APBENR1 |= RCC_APBENR1_I2C1EN;
@@ -339,7 +369,122 @@ static void hw_i2c_init (void) {
     I2C1->CR1 |= I2C_CR1_PE;
 }
 
+static void hw_i2c_irq_init (void) {
+    I2C1->TIMEOUTR = (I2C_TIMEOUTR_TIMOUTEN | (I2C_TIMEOUT_SCL_LOW << I2C_TIMEOUTR_TIMEOUTA_Pos));
+    I2C1->CR1 |= (
+        I2C_CR1_ERRIE |
+        I2C_CR1_TCIE |
+        I2C_CR1_STOPIE |
+        I2C_CR1_NACKIE |
+        I2C_CR1_RXIE |
+        I2C_CR1_TXIE
+    );
+
+    i2c_irq_enabled = true;
+
+    NVIC_EnableIRQ(I2C1_IRQn);
+}
+
+static void hw_i2c_start_read (i2c_transfer_t *transfer) {
+    I2C1->CR2 = (
+        I2C_CR2_AUTOEND |
+        (transfer->rx_length << I2C_CR2_NBYTES_Pos) |
+        I2C_CR2_START |
+        I2C_CR2_RD_WRN |
+        (transfer->address << I2C_CR2_SADD_Pos)
+    );
+}
+
+static void hw_i2c_start_transfer (i2c_transfer_t *transfer) {
+    i2c_tx_data = transfer->tx_data;
+    i2c_rx_data = transfer->rx_data;
+    i2c_error = I2C_OK;
+
+    I2C1->ICR = I2C_ICR_ALL;
+
+    if (transfer->tx_length > 0) {
+        I2C1->CR2 = (
+            ((transfer->rx_length > 0) ? 0 : I2C_CR2_AUTOEND) |
+            (transfer->tx_length << I2C_CR2_NBYTES_Pos) |
+            I2C_CR2_START |
+            (transfer->address << I2C_CR2_SADD_Pos)
+        );
+    } else {
+        hw_i2c_start_read(transfer);
+    }
+}
+
+static void hw_i2c_finish_transfer (void) {
+    i2c_transfer_t *transfer = i2c_queue_head;
+
+    if (i2c_error != I2C_OK) {
+        I2C1->CR1 &= ~(I2C_CR1_PE);
+        while (I2C1->CR1 & I2C_CR1_PE);
+        I2C1->CR1 |= I2C_CR1_PE;
+    }
+
+    i2c_queue_head = transfer->next;
+
+    transfer->error = i2c_error;
+    transfer->pending = false;
+
+    if (transfer->callback) {
+        transfer->callback(i2c_error);
+    }
+
+    if (i2c_queue_head != NULL) {
+        hw_i2c_start_transfer(i2c_queue_head);
+    }
+}
+
+void hw_i2c_queue (i2c_transfer_t *transfer) {
+    transfer->pending = true;
+    transfer->error = I2C_OK;
+    transfer->next = NULL;
+
+    hw_enter_critical();
+    if (i2c_queue_head == NULL) {
+        i2c_queue_head = transfer;
+        i2c_queue_tail = transfer;
+        hw_i2c_start_transfer(transfer);
+    } else {
+        i2c_queue_tail->next = transfer;
+        i2c_queue_tail = transfer;
+    }
+    hw_exit_critical();
+}
+
+void hw_i2c_abort (i2c_transfer_t *transfer) {
+    hw_enter_critical();
+    if (transfer == i2c_queue_head) {
+        i2c_error = I2C_ERROR_BUSY;
+        hw_i2c_finish_transfer();
+    } else if (transfer->pending) {
+        i2c_transfer_t *previous = i2c_queue_head;
+        while ((previous != NULL) && (previous->next != transfer)) {
+            previous = previous->next;
+        }
+        if (previous != NULL) {
+            previous->next = transfer->next;
+            if (i2c_queue_tail == transfer) {
+                i2c_queue_tail = previous;
+            }
+            transfer->error = I2C_ERROR_BUSY;
+            transfer->pending = false;
+            if (transfer->callback) {
+                transfer->callback(I2C_ERROR_BUSY);
+            }
+        }
+    }
+    hw_exit_critical();
+}
+
+// Polled transfer for primer and loader, app code owns the bus through hw_i2c_queue
 i2c_error_t hw_i2c_trx (uint8_t address, uint8_t *tx_data, uint8_t tx_length, uint8_t *rx_data, uint8_t rx_length) {
+    if (i2c_irq_enabled) {
+        return I2C_ERROR_BUSY;
+    }
+
     hw_timeout_start();
 
     while (I2C1->ISR & I2C_ISR_BUSY) {
@@ -423,6 +568,44 @@ i2c_error_t hw_i2c_trx (uint8_t address, uint8_t *tx_data, uint8_t tx_length, ui
     return I2C_OK;
 }
 
+void I2C1_IRQHandler (void) {
+    uint32_t isr = I2C1->ISR;
+    i2c_transfer_t *transfer = i2c_queue_head;
+
+    if (transfer == NULL) {
+        I2C1->ICR = I2C_ICR_ALL;
+        return;
+    }
+
+    if (isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_TIMEOUT)) {
+        i2c_error = ((isr & I2C_ISR_ARLO) ? I2C_ERROR_BUSY : I2C_ERROR_TIMEOUT);
+        hw_i2c_finish_transfer();
+        return;
+    }
+
+    if (isr & I2C_ISR_NACKF) {
+        I2C1->ICR = I2C_ICR_NACKCF;
+        i2c_error = I2C_ERROR_NACK;
+    }
+
+    if (isr & I2C_ISR_TXIS) {
+        I2C1->TXDR = *i2c_tx_data++;
+    }
+
+    if (isr & I2C_ISR_RXNE) {
+        *i2c_rx_data++ = I2C1->RXDR;
+    }
+
+    if (isr & I2C_ISR_TC) {
+        hw_i2c_start_read(transfer);
+    }
+
+    if (isr & I2C_ISR_STOPF) {
+        I2C1->ICR = I2C_ICR_STOPCF;
+        hw_i2c_finish_transfer();
+    }
+}
+
 
 static void hw_crc32_init (void) {
     RCC->AHBENR |= RCC_AHBENR_CRCEN;
@@ -452,6 +635,11 @@ hw_flash_t hw_flash_read (uint32_t offset) {
 
 static void hw_flash_unlock (void) {
     while (FLASH->SR & FLASH_SR_BSY1);
+    FLASH->SR = (
+        FLASH_SR_OPTVERR | FLASH_SR_FASTERR | FLASH_SR_MISERR | FLASH_SR_PGSERR |
+        FLASH_SR_SIZERR | FLASH_SR_PGAERR | FLASH_SR_WRPERR | FLASH_SR_PROGERR |
+        FLASH_SR_OPERR | FLASH_SR_EOP
+    );
     if (FLASH->CR & FLASH_CR_LOCK) {
         FLASH->KEYR = 0x45670123;
         __ISB();
@@ -459,20 +647,32 @@ static void hw_flash_unlock (void) {
     }
 }
 
-void hw_flash_erase (void) {
+void hw_flash_erase_page (uint32_t offset) {
     hw_flash_unlock();
-    FLASH->CR |= (FLASH_CR_STRT | FLASH_CR_MER1);
+    FLASH->CR &= ~(FLASH_CR_PNB_Msk);
+    FLASH->CR |= (FLASH_CR_PER | ((offset / HW_FLASH_PAGE_SIZE) << FLASH_CR_PNB_Pos));
+    FLASH->CR |= FLASH_CR_STRT;
     while (FLASH->SR & FLASH_SR_BSY1);
+    FLASH->CR &= ~(FLASH_CR_PER | FLASH_CR_PNB_Msk);
 }
 
-void hw_flash_program (uint32_t offset, hw_flash_t value) {
+bool hw_flash_program_row (uint32_t offset, hw_flash_t *data) {
+    uint32_t *source = (uint32_t *) (data);
+    __IO uint32_t *destination = (__IO uint32_t *) (FLASH_BASE + offset);
+    uint32_t errors = (
+        FLASH_SR_FASTERR | FLASH_SR_MISERR | FLASH_SR_PGSERR | FLASH_SR_SIZERR |
+        FLASH_SR_PGAERR | FLASH_SR_WRPERR | FLASH_SR_PROGERR
+    );
     hw_flash_unlock();
-    FLASH->CR |= FLASH_CR_PG;
-    *(__IO uint32_t *) (FLASH_BASE + offset) = ((value) & 0xFFFFFFFF);
-    __ISB();
-    *(__IO uint32_t *) (FLASH_BASE + offset + 4) = ((value >> 32) & 0xFFFFFFFF);
+    FLASH->CR |= FLASH_CR_FSTPG;
+    for (int i = 0; i < (HW_FLASH_ROW_SIZE / sizeof(uint32_t)); i++) {
+        destination[i] = source[i];
+    }
     while (FLASH->SR & FLASH_SR_BSY1);
-    FLASH->CR &= ~(FLASH_CR_PG);
+    FLASH->CR &= ~(FLASH_CR_FSTPG);
+    errors &= FLASH->SR;
+    FLASH->SR = errors;
+    return (errors != 0);
 }
 
 
@@ -581,8 +781,7 @@ static void hw_misc_init (void) {
 
 void hw_primer_init (void) {
     hw_clock_init();
-    hw_timeout_init();
-    hw_delay_init();
+    hw_timebase_init();
     hw_led_init();
     hw_uart_init();
     hw_spi_init();
@@ -592,21 +791,22 @@ void hw_primer_init (void) {
 
 void hw_loader_init (void) {
     hw_clock_init();
-    hw_timeout_init();
-    hw_delay_init();
+    hw_timebase_init();
+    hw_stopwatch_init();
     hw_led_init();
     hw_spi_init();
+    hw_crc32_init();
 }
 
 void hw_app_init (void) {
     hw_clock_init();
-    hw_timeout_init();
-    hw_delay_init();
+    hw_timebase_init();
     hw_adc_init();
     hw_led_init();
     hw_misc_init();
     hw_uart_init();
     hw_spi_init();
     hw_i2c_init();
+    hw_i2c_irq_init();
     hw_crc32_init();
 }
@@ -2,6 +2,7 @@
 #define HW_H__
 
 
+#include <stdbool.h>
 #include <stdint.h>
 
 
@@ -32,6 +33,26 @@ typedef enum {
     I2C_ERROR_NACK,
 } i2c_error_t;
 
+typedef struct i2c_transfer {
+    uint8_t address;
+    uint8_t *tx_data;
+    uint8_t tx_length;
+    uint8_t *rx_data;
+    uint8_t rx_length;
+    void (*callback) (i2c_error_t error);
+    volatile bool pending;
+    volatile i2c_error_t error;
+    struct i2c_transfer *next;
+} i2c_transfer_t;
+
+typedef enum {
+    SPI_DIVIDER_4 = 1,
+    SPI_DIVIDER_8 = 2,
+} spi_divider_t;
+
+#define HW_FLASH_PAGE_SIZE      (2048)
+#define HW_FLASH_ROW_SIZE       (256)
+
 typedef uint64_t hw_flash_t;
 
 typedef enum {
@@ -54,9 +75,14 @@ void hw_set_vector_table (uint32_t offset);
 void hw_enter_critical (void);
 void hw_exit_critical (void);
 
+uint32_t hw_timebase_get_us (void);
+
 void hw_delay_us (uint32_t delay_us);
 void hw_delay_ms (uint32_t delay_ms);
 
+void hw_stopwatch_start (void);
+uint32_t hw_stopwatch_get_ms (void);
+
 void hw_systick_config (uint32_t period_ms, void (*callback) (void));
 
 uint32_t hw_gpio_get (gpio_id_t id);
@@ -71,16 +97,19 @@ void hw_spi_start (void);
 void hw_spi_stop (void);
 void hw_spi_rx (uint8_t *data, int length);
 void hw_spi_tx (uint8_t *data, int length);
+void hw_spi_set_divider (spi_divider_t divider);
 
 i2c_error_t hw_i2c_trx (uint8_t i2c_address, uint8_t *tx_data, uint8_t tx_length, uint8_t *rx_data, uint8_t rx_length);
+void hw_i2c_queue (i2c_transfer_t *transfer);
+void hw_i2c_abort (i2c_transfer_t *transfer);
 
 void hw_crc32_reset (void);
 uint32_t hw_crc32_calculate (uint8_t *data, uint32_t length);
 
 uint32_t hw_flash_size (void);
 hw_flash_t hw_flash_read (uint32_t offset);
-void hw_flash_erase (void);
-void hw_flash_program (uint32_t offset, hw_flash_t value);
+void hw_flash_erase_page (uint32_t offset);
+bool hw_flash_program_row (uint32_t offset, hw_flash_t *data);
 
 void hw_reset (loader_parameters_t *parameters);
 
@@ -9,7 +9,14 @@
 #define VENDOR_SCR_WRITE        (1 << 1)
 #define VENDOR_SCR_LENGTH_BIT   (2)
 #define VENDOR_SCR_DELAY        (1 << 4)
+#define VENDOR_SCR_BURST        (1 << 5)
+#define VENDOR_SCR_FRAME_OPEN   (1 << 6)
+#define VENDOR_SCR_FRAME_CLOSE  (1 << 7)
 #define VENDOR_SCR_ADDRESS_BIT  (8)
+#define VENDOR_SCR_WORDS_BIT    (16)
+
+#define VENDOR_FIFO_WORDS       (8)
+#define VENDOR_BUFFER_SIZE      (1024)
 
 #define LCMXO2_I2C_ADDR_CFG     (0x80)
 #define LCMXO2_I2C_ADDR_RESET   (0x86)
@@ -60,6 +67,9 @@ typedef enum {
 
 
 #ifndef LCMXO2_I2C
+static bool lcmxo2_burst_supported = false;
+
+
 static void lcmxo2_reg_set (uint8_t reg, uint8_t value) {
     fpga_reg_set(REG_VENDOR_DATA, value << 24);
     fpga_reg_set(REG_VENDOR_SCR,
@@ -109,6 +119,56 @@ static void lcmxo2_write_data (uint8_t *buffer, uint32_t length) {
         while (fpga_reg_get(REG_VENDOR_SCR) & VENDOR_SCR_BUSY);
     }
 }
+
+static void lcmxo2_burst_start (uint8_t reg, uint32_t words, uint32_t flags) {
+    fpga_reg_set(REG_VENDOR_SCR,
+        ((words - 1) << VENDOR_SCR_WORDS_BIT) |
+        (reg << VENDOR_SCR_ADDRESS_BIT) |
+        flags |
+        VENDOR_SCR_BURST |
+        VENDOR_SCR_START
+    );
+    while (fpga_reg_get(REG_VENDOR_SCR) & VENDOR_SCR_BUSY);
+}
+
+static void lcmxo2_burst_probe (void) {
+    fpga_reg_set(REG_VENDOR_DATA, 0);
+    lcmxo2_burst_start(LCMXO2_CFGCR, 1, VENDOR_SCR_WRITE);
+    lcmxo2_burst_supported = (fpga_reg_get(REG_VENDOR_SCR) & VENDOR_SCR_BURST);
+}
+
+static void lcmxo2_execute_burst (uint32_t data, cmd_type_t type, uint8_t *buffer, uint8_t length, bool write) {
+    uint32_t words = (length / 4);
+
+    fpga_reg_set(REG_VENDOR_DATA, data);
+
+    if (write) {
+        for (int i = 0; i < words; i++) {
+            fpga_reg_set(REG_VENDOR_DATA, (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+            buffer += 4;
+        }
+        lcmxo2_burst_start(LCMXO2_CFGTXDR, (words + 1), (VENDOR_SCR_FRAME_OPEN | VENDOR_SCR_FRAME_CLOSE | VENDOR_SCR_WRITE));
+        return;
+    }
+
+    lcmxo2_burst_start(LCMXO2_CFGTXDR, 1,
+        VENDOR_SCR_FRAME_OPEN |
+        ((words == 0) ? VENDOR_SCR_FRAME_CLOSE : 0) |
+        ((type == CMD_DELAYED) ? VENDOR_SCR_DELAY : 0) |
+        VENDOR_SCR_WRITE
+    );
+
+    if (words > 0) {
+        lcmxo2_burst_start(LCMXO2_CFGRXDR, words, VENDOR_SCR_FRAME_CLOSE);
+        for (int i = 0; i < words; i++) {
+            uint32_t value = fpga_reg_get(REG_VENDOR_DATA);
+            *buffer++ = ((value >> 24) & 0xFF);
+            *buffer++ = ((value >> 16) & 0xFF);
+            *buffer++ = ((value >> 8) & 0xFF);
+            *buffer++ = (value & 0xFF);
+        }
+    }
+}
 #endif
 
 static void lcmxo2_reset_bus (void) {
@@ -118,6 +178,7 @@ static void lcmxo2_reset_bus (void) {
 #else
     lcmxo2_reg_set(LCMXO2_CFGCR, CFGCR_RSTE);
     lcmxo2_reg_set(LCMXO2_CFGCR, 0);
+    lcmxo2_burst_probe();
 #endif
 }
 
@@ -137,10 +198,20 @@ static bool lcmxo2_execute_cmd (uint8_t cmd, uint32_t arg, cmd_type_t type, uint
 
     return (error != I2C_OK);
 #else
-    lcmxo2_reg_set(LCMXO2_CFGCR, CFGCR_WBCE);
-
     uint32_t data = (cmd << 24) | (arg & 0x00FFFFFF);
 
+    if (
+        lcmxo2_burst_supported &&
+        (type != CMD_TWO_OP) &&
+        ((length % 4) == 0) &&
+        (((length / 4) + 1) <= VENDOR_FIFO_WORDS)
+    ) {
+        lcmxo2_execute_burst(data, type, buffer, length, write);
+        return false;
+    }
+
+    lcmxo2_reg_set(LCMXO2_CFGCR, CFGCR_WBCE);
+
     fpga_reg_set(REG_VENDOR_DATA, data);
     fpga_reg_set(REG_VENDOR_SCR,
         (LCMXO2_CFGTXDR << VENDOR_SCR_ADDRESS_BIT) |
@@ -291,8 +362,9 @@ vendor_error_t vendor_backup (uint32_t address, uint32_t *length) {
 }
 
 vendor_error_t vendor_update (uint32_t address, uint32_t length) {
-    uint8_t buffer[FLASH_PAGE_SIZE];
+    uint8_t buffer[VENDOR_BUFFER_SIZE];
     uint8_t verify_buffer[FLASH_PAGE_SIZE];
+    uint32_t block_length;
 
     if (length == 0) {
         return VENDOR_ERROR_ARGS;
@@ -312,22 +384,28 @@ vendor_error_t vendor_update (uint32_t address, uint32_t length) {
         return lcmxo2_fail(VENDOR_ERROR_ERASE);
     }
     lcmxo2_reset_flash_address();
-    for (int i = 0; i < length; i += FLASH_PAGE_SIZE) {
-        fpga_mem_read(address + i, FLASH_PAGE_SIZE, buffer);
-        if (lcmxo2_write_flash_page(buffer)) {
-            return lcmxo2_fail(VENDOR_ERROR_PROGRAM);
+    for (uint32_t offset = 0; offset < length; offset += block_length) {
+        block_length = ((length - offset) > sizeof(buffer)) ? sizeof(buffer) : (length - offset);
+        fpga_mem_read(address + offset, block_length, buffer);
+        for (int i = 0; i < block_length; i += FLASH_PAGE_SIZE) {
+            if (lcmxo2_write_flash_page(&buffer[i])) {
+                return lcmxo2_fail(VENDOR_ERROR_PROGRAM);
+            }
         }
     }
     if (lcmxo2_program_done()) {
         return lcmxo2_fail(VENDOR_ERROR_PROGRAM);
     }
     lcmxo2_reset_flash_address();
-    for (int i = 0; i < length; i += FLASH_PAGE_SIZE) {
-        lcmxo2_read_flash_page(buffer);
-        fpga_mem_read(address + i, FLASH_PAGE_SIZE, verify_buffer);
-        for (int x = 0; x < FLASH_PAGE_SIZE; x++) {
-            if (buffer[x] != verify_buffer[x]) {
-                return lcmxo2_fail(VENDOR_ERROR_VERIFY);
+    for (uint32_t offset = 0; offset < length; offset += block_length) {
+        block_length = ((length - offset) > sizeof(buffer)) ? sizeof(buffer) : (length - offset);
+        fpga_mem_read(address + offset, block_length, buffer);
+        for (int i = 0; i < block_length; i += FLASH_PAGE_SIZE) {
+            lcmxo2_read_flash_page(verify_buffer);
+            for (int x = 0; x < FLASH_PAGE_SIZE; x++) {
+                if (buffer[i + x] != verify_buffer[x]) {
+                    return lcmxo2_fail(VENDOR_ERROR_VERIFY);
+                }
             }
         }
     }
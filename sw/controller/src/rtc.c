@@ -14,6 +14,7 @@
 #define RTC_ADDRESS_RTCDATE         (0x04)
 #define RTC_ADDRESS_RTCMTH          (0x05)
 #define RTC_ADDRESS_RTCYEAR         (0x06)
+#define RTC_ADDRESS_CONTROL         (0x07)
 #define RTC_ADDRESS_OSCTRIM         (0x08)
 #define RTC_ADDRESS_SRAM_MAGIC      (0x20)
 #define RTC_ADDRESS_SRAM_REGION     (0x24)
@@ -26,9 +27,24 @@
 #define RTC_RTCWKDAY_VBATEN         (1 << 3)
 #define RTC_RTCWKDAY_OSCRUN         (1 << 5)
 
+#define RTC_CONTROL_SQWEN           (1 << 6)
+#define RTC_CONTROL_SQWFS_1HZ       (0 << 0)
+
 #define RTC_SETTINGS_VERSION        (1)
 
 #define RTC_TIME_REFRESH_PERIOD_MS  (500)
+#define RTC_TIME_SYNC_PERIOD_S      (60)
+#define RTC_MFP_TIMEOUT_MS          (1500)
+#define RTC_I2C_TIMEOUT_MS          (100)
+
+#define RTC_I2C_OPS                 (3)
+
+#define RTC_PENDING_READ_TIME       (1 << 0)
+#define RTC_PENDING_WRITE_TIME      (1 << 1)
+#define RTC_PENDING_WRITE_CENTURY   (1 << 2)
+#define RTC_PENDING_WRITE_REGION    (1 << 3)
+#define RTC_PENDING_WRITE_SETTINGS  (1 << 4)
+#define RTC_PENDING_WRITE_MAGIC     (1 << 5)
 
 #define RTC_FROM_BCD(x)             ((((((x) >> 4) & 0xF) % 10) * 10) + (((x) & 0xF) % 10))
 #define RTC_TO_BCD(x)               (((((x) / 10) % 10) << 4) | ((x) % 10))
@@ -50,6 +66,19 @@ typedef struct {
     } century;
 } rtc_raw_time_t;
 
+typedef enum {
+    RTC_I2C_IDLE,
+    RTC_I2C_INIT_CHECK,
+    RTC_I2C_READ_TIME,
+    RTC_I2C_STOP_OSC,
+    RTC_I2C_WRITE,
+} rtc_i2c_state_t;
+
+typedef struct {
+    i2c_transfer_t transfer;
+    uint8_t buffer[16];
+} rtc_i2c_op_t;
+
 
 static rtc_real_time_t rtc_time = {
     .second     = 0x00,
@@ -65,45 +94,24 @@ static uint8_t rtc_region = 0xFF;
 static rtc_settings_t rtc_settings = {
     .led_enabled    = true,
 };
+static const uint8_t rtc_magic[4] = { 'R', 'T', 'C', '1' };
+static bool rtc_time_valid = false;
+static bool rtc_mfp_level = false;
+static bool rtc_tick_level = false;
+static uint8_t rtc_sync_countdown = 0;
+static uint8_t rtc_pending = 0;
+static rtc_i2c_state_t rtc_i2c_state = RTC_I2C_IDLE;
+static rtc_i2c_op_t rtc_i2c_ops[RTC_I2C_OPS];
+static uint8_t rtc_i2c_ops_count = 0;
+static uint8_t rtc_i2c_ops_queued = 0;
+static volatile uint8_t rtc_i2c_remaining = 0;
+static volatile bool rtc_i2c_failed = false;
+static rtc_raw_time_t rtc_i2c_raw;
+static uint8_t rtc_i2c_osc_status;
+static uint8_t rtc_i2c_magic[sizeof(rtc_magic)];
+static uint32_t rtc_i2c_settings_version;
 
 
-static bool rtc_read (uint8_t address, uint8_t *data, uint8_t length) {
-    if (hw_i2c_trx(RTC_I2C_ADDRESS, &address, 1, data, length) != I2C_OK) {
-        led_blink_error(LED_ERROR_RTC);
-        return true;
-    }
-
-    return false;
-}
-
-static bool rtc_write (uint8_t address, uint8_t *data, uint8_t length) {
-    uint8_t buffer[16];
-    buffer[0] = address;
-
-    for (int i = 0; i < length; i++) {
-        buffer[i + 1] = data[i];
-    }
-
-    if (hw_i2c_trx(RTC_I2C_ADDRESS, buffer, length + 1, NULL, 0) != I2C_OK) {
-        led_blink_error(LED_ERROR_RTC);
-        return true;
-    }
-
-    return false;
-}
-
-static void rtc_osc_stop (void) {
-    uint8_t tmp;
-
-    rtc_read(RTC_ADDRESS_RTCSEC, &tmp, sizeof(tmp));
-
-    tmp &= ~(RTC_RTCSEC_ST);
-
-    rtc_write(RTC_ADDRESS_RTCSEC, &tmp, sizeof(tmp));
-
-    while ((!rtc_read(RTC_ADDRESS_RTCWKDAY, &tmp, 1)) && (tmp & RTC_RTCWKDAY_OSCRUN));
-}
-
 static void rtc_sanitize_raw_time (rtc_raw_time_t *raw) {
     raw->time.second &= 0b01111111;
     raw->time.minute &= 0b01111111;
@@ -252,76 +260,67 @@ static void rtc_real_to_raw (rtc_raw_time_t *raw, rtc_real_time_t *real) {
     rtc_adjust_date(&raw->century.value, &raw->time.year, &raw->time.month, &raw->time.day, day_offset);
 }
 
-static void rtc_read_time (void) {
-    rtc_raw_time_t raw;
-    bool update_raw_century = false;
-
-    if (rtc_read(RTC_ADDRESS_RTCSEC, (uint8_t *) (&raw.time), sizeof(raw.time))) {
+static void rtc_tick (void) {
+    uint8_t second = RTC_FROM_BCD(rtc_time.second) + 1;
+    if (second < 60) {
+        rtc_time.second = RTC_TO_BCD(second);
         return;
     }
+    rtc_time.second = 0x00;
 
-    if (rtc_read(RTC_ADDRESS_SRAM_CENTURY, (uint8_t *) (&raw.century), sizeof(raw.century))) {
+    uint8_t minute = RTC_FROM_BCD(rtc_time.minute) + 1;
+    if (minute < 60) {
+        rtc_time.minute = RTC_TO_BCD(minute);
         return;
     }
+    rtc_time.minute = 0x00;
 
-    rtc_sanitize_raw_time(&raw);
-
-    if (raw.time.year < raw.century.last_year) {
-        raw.century.value += 1;
-        update_raw_century = true;
-    }
-
-    if (raw.time.year != raw.century.last_year) {
-        raw.century.last_year = raw.time.year;
-        update_raw_century = true;
+    uint8_t hour = RTC_FROM_BCD(rtc_time.hour) + 1;
+    if (hour < 24) {
+        rtc_time.hour = RTC_TO_BCD(hour);
+        return;
     }
+    rtc_time.hour = 0x00;
 
-    if (update_raw_century) {
-        rtc_write(RTC_ADDRESS_SRAM_CENTURY, (uint8_t *) (&raw.century), sizeof(raw.century));
-    }
+    rtc_time.weekday = ((rtc_time.weekday % 7) + 1);
 
-    rtc_raw_to_real(&raw, &rtc_time);
+    rtc_adjust_date(&rtc_time.century, &rtc_time.year, &rtc_time.month, &rtc_time.day, 1);
 }
 
-static void rtc_write_time (void) {
-    rtc_raw_time_t raw;
-    uint8_t raw_regs[7];
-
-    rtc_real_to_raw(&raw, &rtc_time);
+static bool rtc_update_time (rtc_raw_time_t *raw) {
+    bool update_raw_century = false;
 
-    rtc_sanitize_raw_time(&raw);
+    rtc_sanitize_raw_time(raw);
 
-    raw_regs[0] = (raw.time.second | RTC_RTCSEC_ST);
-    raw_regs[1] = raw.time.minute;
-    raw_regs[2] = raw.time.hour;
-    raw_regs[3] = (raw.time.weekday | RTC_RTCWKDAY_VBATEN);
-    raw_regs[4] = raw.time.day;
-    raw_regs[5] = raw.time.month;
-    raw_regs[6] = raw.time.year;
+    if (raw->time.year < raw->century.last_year) {
+        raw->century.value += 1;
+        update_raw_century = true;
+    }
 
-    raw.century.last_year = raw.time.year;
+    if (raw->time.year != raw->century.last_year) {
+        raw->century.last_year = raw->time.year;
+        update_raw_century = true;
+    }
 
-    rtc_osc_stop();
+    rtc_raw_to_real(raw, &rtc_time);
 
-    rtc_write(RTC_ADDRESS_SRAM_CENTURY, (uint8_t *) (&raw.century), sizeof(raw.century));
-    rtc_write(RTC_ADDRESS_RTCMIN, &raw_regs[1], sizeof(raw_regs) - sizeof(raw_regs[0]));
-    rtc_write(RTC_ADDRESS_RTCSEC, &raw_regs[0], sizeof(raw_regs[0]));
+    return update_raw_century;
 }
 
-static void rtc_read_region (void) {
-    rtc_read(RTC_ADDRESS_SRAM_REGION, &rtc_region, sizeof(rtc_region));
-}
+static void rtc_prepare_time (rtc_raw_time_t *raw, uint8_t *raw_regs) {
+    rtc_real_to_raw(raw, &rtc_time);
 
-static void rtc_write_region (void) {
-    rtc_write(RTC_ADDRESS_SRAM_REGION, &rtc_region, sizeof(rtc_region));
-}
+    rtc_sanitize_raw_time(raw);
 
-static void rtc_read_settings (void) {
-    rtc_read(RTC_ADDRESS_SRAM_SETTINGS, (uint8_t *) (&rtc_settings), sizeof(rtc_settings));
-}
+    raw_regs[0] = (raw->time.second | RTC_RTCSEC_ST);
+    raw_regs[1] = raw->time.minute;
+    raw_regs[2] = raw->time.hour;
+    raw_regs[3] = (raw->time.weekday | RTC_RTCWKDAY_VBATEN);
+    raw_regs[4] = raw->time.day;
+    raw_regs[5] = raw->time.month;
+    raw_regs[6] = raw->time.year;
 
-static void rtc_write_settings (void) {
-    rtc_write(RTC_ADDRESS_SRAM_SETTINGS, (uint8_t *) (&rtc_settings), sizeof(rtc_settings));
+    raw->century.last_year = raw->time.year;
 }
 
 static void rtc_read_joybus_time (void) {
@@ -358,6 +357,188 @@ static void rtc_write_joybus_time (void) {
 }
 
 
+static void rtc_i2c_callback (i2c_error_t error) {
+    if (error != I2C_OK) {
+        rtc_i2c_failed = true;
+    }
+    rtc_i2c_remaining -= 1;
+}
+
+static void rtc_i2c_prepare (uint8_t address, uint8_t *tx_data, uint8_t tx_length, uint8_t *rx_data, uint8_t rx_length) {
+    rtc_i2c_op_t *op = &rtc_i2c_ops[rtc_i2c_ops_count++];
+
+    op->buffer[0] = address;
+
+    for (int i = 0; i < tx_length; i++) {
+        op->buffer[i + 1] = tx_data[i];
+    }
+
+    op->transfer.address = RTC_I2C_ADDRESS;
+    op->transfer.tx_data = op->buffer;
+    op->transfer.tx_length = (tx_length + 1);
+    op->transfer.rx_data = rx_data;
+    op->transfer.rx_length = rx_length;
+    op->transfer.callback = rtc_i2c_callback;
+}
+
+static void rtc_i2c_start (rtc_i2c_state_t state) {
+    rtc_i2c_state = state;
+    rtc_i2c_failed = false;
+    rtc_i2c_remaining = rtc_i2c_ops_count;
+    rtc_i2c_ops_queued = rtc_i2c_ops_count;
+
+    timer_countdown_start(TIMER_ID_RTC_I2C, RTC_I2C_TIMEOUT_MS);
+
+    for (int i = 0; i < rtc_i2c_ops_count; i++) {
+        hw_i2c_queue(&rtc_i2c_ops[i].transfer);
+    }
+
+    rtc_i2c_ops_count = 0;
+}
+
+static void rtc_i2c_init_check (void) {
+    rtc_i2c_prepare(RTC_ADDRESS_SRAM_MAGIC, NULL, 0, rtc_i2c_magic, sizeof(rtc_i2c_magic));
+    rtc_i2c_prepare(RTC_ADDRESS_SRAM_VERSION, NULL, 0, (uint8_t *) (&rtc_i2c_settings_version), sizeof(rtc_i2c_settings_version));
+    rtc_i2c_start(RTC_I2C_INIT_CHECK);
+}
+
+static void rtc_i2c_init_check_done (void) {
+    bool uninitialized = false;
+    uint8_t osc_trim = 0;
+    uint8_t control = (RTC_CONTROL_SQWEN | RTC_CONTROL_SQWFS_1HZ);
+
+    for (int i = 0; i < sizeof(rtc_magic); i++) {
+        if (rtc_i2c_magic[i] != rtc_magic[i]) {
+            uninitialized = true;
+            break;
+        }
+    }
+
+    if (uninitialized) {
+        rtc_i2c_prepare(RTC_ADDRESS_OSCTRIM, &osc_trim, sizeof(osc_trim), NULL, 0);
+        rtc_pending |= (RTC_PENDING_WRITE_TIME | RTC_PENDING_WRITE_REGION | RTC_PENDING_WRITE_SETTINGS | RTC_PENDING_WRITE_MAGIC);
+    } else {
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_REGION, NULL, 0, &rtc_region, sizeof(rtc_region));
+        if (rtc_i2c_settings_version == RTC_SETTINGS_VERSION) {
+            rtc_i2c_prepare(RTC_ADDRESS_SRAM_SETTINGS, NULL, 0, (uint8_t *) (&rtc_settings), sizeof(rtc_settings));
+        } else {
+            rtc_pending |= (RTC_PENDING_WRITE_SETTINGS | RTC_PENDING_WRITE_MAGIC);
+        }
+    }
+    rtc_i2c_prepare(RTC_ADDRESS_CONTROL, &control, sizeof(control), NULL, 0);
+    rtc_i2c_start(RTC_I2C_WRITE);
+}
+
+static void rtc_i2c_read_time (void) {
+    rtc_i2c_prepare(RTC_ADDRESS_RTCSEC, NULL, 0, (uint8_t *) (&rtc_i2c_raw.time), sizeof(rtc_i2c_raw.time));
+    rtc_i2c_prepare(RTC_ADDRESS_SRAM_CENTURY, NULL, 0, (uint8_t *) (&rtc_i2c_raw.century), sizeof(rtc_i2c_raw.century));
+    rtc_i2c_start(RTC_I2C_READ_TIME);
+}
+
+static void rtc_i2c_read_time_done (void) {
+    uint8_t second = RTC_FROM_BCD(rtc_time.second);
+
+    if (rtc_update_time(&rtc_i2c_raw)) {
+        rtc_pending |= RTC_PENDING_WRITE_CENTURY;
+    }
+
+    // RTC seconds counter advances on the other MFP edge, tick there from now on
+    if (rtc_time_valid && (RTC_FROM_BCD(rtc_time.second) == ((second + 1) % 60))) {
+        rtc_tick_level = !rtc_tick_level;
+    }
+
+    rtc_time_valid = true;
+
+    rtc_write_joybus_time();
+}
+
+static void rtc_i2c_stop_osc (void) {
+    uint8_t second = 0x00;
+
+    rtc_i2c_prepare(RTC_ADDRESS_RTCSEC, &second, sizeof(second), NULL, 0);
+    rtc_i2c_prepare(RTC_ADDRESS_RTCWKDAY, NULL, 0, &rtc_i2c_osc_status, sizeof(rtc_i2c_osc_status));
+    rtc_i2c_start(RTC_I2C_STOP_OSC);
+}
+
+static void rtc_i2c_wait_osc (void) {
+    rtc_i2c_prepare(RTC_ADDRESS_RTCWKDAY, NULL, 0, &rtc_i2c_osc_status, sizeof(rtc_i2c_osc_status));
+    rtc_i2c_start(RTC_I2C_STOP_OSC);
+}
+
+static void rtc_i2c_write_time (void) {
+    rtc_raw_time_t raw;
+    uint8_t raw_regs[7];
+
+    rtc_prepare_time(&raw, raw_regs);
+
+    rtc_i2c_prepare(RTC_ADDRESS_SRAM_CENTURY, (uint8_t *) (&raw.century), sizeof(raw.century), NULL, 0);
+    rtc_i2c_prepare(RTC_ADDRESS_RTCMIN, &raw_regs[1], sizeof(raw_regs) - sizeof(raw_regs[0]), NULL, 0);
+    rtc_i2c_prepare(RTC_ADDRESS_RTCSEC, &raw_regs[0], sizeof(raw_regs[0]), NULL, 0);
+    rtc_i2c_start(RTC_I2C_WRITE);
+}
+
+static void rtc_i2c_process (void) {
+    if (rtc_i2c_state != RTC_I2C_IDLE) {
+        if (rtc_i2c_remaining > 0) {
+            if (timer_countdown_elapsed(TIMER_ID_RTC_I2C)) {
+                for (int i = 0; i < rtc_i2c_ops_queued; i++) {
+                    hw_i2c_abort(&rtc_i2c_ops[i].transfer);
+                }
+            }
+            return;
+        }
+
+        rtc_i2c_state_t state = rtc_i2c_state;
+
+        rtc_i2c_state = RTC_I2C_IDLE;
+
+        if (rtc_i2c_failed) {
+            led_blink_error(LED_ERROR_RTC);
+        } else if (state == RTC_I2C_INIT_CHECK) {
+            rtc_i2c_init_check_done();
+            return;
+        } else if (state == RTC_I2C_READ_TIME) {
+            if (!(rtc_pending & RTC_PENDING_WRITE_TIME)) {
+                rtc_i2c_read_time_done();
+            }
+        } else if (state == RTC_I2C_STOP_OSC) {
+            if (rtc_i2c_osc_status & RTC_RTCWKDAY_OSCRUN) {
+                rtc_i2c_wait_osc();
+            } else {
+                rtc_i2c_write_time();
+            }
+            return;
+        }
+    }
+
+    if (rtc_pending & RTC_PENDING_WRITE_TIME) {
+        rtc_pending &= ~(RTC_PENDING_WRITE_TIME | RTC_PENDING_WRITE_CENTURY);
+        rtc_i2c_stop_osc();
+    } else if (rtc_pending & RTC_PENDING_WRITE_CENTURY) {
+        rtc_pending &= ~(RTC_PENDING_WRITE_CENTURY);
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_CENTURY, (uint8_t *) (&rtc_i2c_raw.century), sizeof(rtc_i2c_raw.century), NULL, 0);
+        rtc_i2c_start(RTC_I2C_WRITE);
+    } else if (rtc_pending & RTC_PENDING_WRITE_REGION) {
+        rtc_pending &= ~(RTC_PENDING_WRITE_REGION);
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_REGION, &rtc_region, sizeof(rtc_region), NULL, 0);
+        rtc_i2c_start(RTC_I2C_WRITE);
+    } else if (rtc_pending & RTC_PENDING_WRITE_SETTINGS) {
+        rtc_pending &= ~(RTC_PENDING_WRITE_SETTINGS);
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_SETTINGS, (uint8_t *) (&rtc_settings), sizeof(rtc_settings), NULL, 0);
+        rtc_i2c_start(RTC_I2C_WRITE);
+    } else if (rtc_pending & RTC_PENDING_WRITE_MAGIC) {
+        uint32_t settings_version = RTC_SETTINGS_VERSION;
+        rtc_pending &= ~(RTC_PENDING_WRITE_MAGIC);
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_MAGIC, (uint8_t *) (rtc_magic), sizeof(rtc_magic), NULL, 0);
+        rtc_i2c_prepare(RTC_ADDRESS_SRAM_VERSION, (uint8_t *) (&settings_version), sizeof(settings_version), NULL, 0);
+        rtc_i2c_start(RTC_I2C_WRITE);
+    } else if (rtc_pending & RTC_PENDING_READ_TIME) {
+        rtc_pending &= ~(RTC_PENDING_READ_TIME);
+        rtc_i2c_read_time();
+    }
+}
+
+
 void rtc_get_time (rtc_real_time_t *time) {
     time->second = rtc_time.second;
     time->minute = rtc_time.minute;
@@ -378,8 +559,9 @@ void rtc_set_time (rtc_real_time_t *time) {
     rtc_time.month = time->month;
     rtc_time.year = time->year;
     rtc_time.century = time->century;
-    rtc_write_time();
-    rtc_read_time();
+    rtc_write_joybus_time();
+    rtc_pending |= RTC_PENDING_WRITE_TIME;
+    rtc_sync_countdown = 0;
 }
 
 
@@ -389,7 +571,7 @@ uint8_t rtc_get_region (void) {
 
 void rtc_set_region (uint8_t region) {
     rtc_region = region;
-    rtc_write_region();
+    rtc_pending |= RTC_PENDING_WRITE_REGION;
 }
 
 
@@ -398,49 +580,25 @@ rtc_settings_t *rtc_get_settings (void) {
 }
 
 void rtc_save_settings (void) {
-    rtc_write_settings();
+    rtc_pending |= RTC_PENDING_WRITE_SETTINGS;
 }
 
 
 void rtc_init (void) {
-    bool uninitialized = false;
-    const char *magic = "RTC1";
-    uint8_t buffer[sizeof(magic)];
-    uint8_t osc_trim = 0;
-    uint32_t settings_version;
+    rtc_i2c_init_check();
+    rtc_pending |= RTC_PENDING_READ_TIME;
 
-    for (int i = 0; i < sizeof(buffer) / sizeof(buffer[0]); i++) {
-        buffer[i] = 0;
+    // Region and settings are used by the other init functions, run the queued transfers to completion
+    while ((rtc_i2c_state != RTC_I2C_IDLE) || (rtc_pending != 0)) {
+        rtc_i2c_process();
     }
 
-    rtc_read(RTC_ADDRESS_SRAM_MAGIC, buffer, sizeof(buffer));
-    rtc_read(RTC_ADDRESS_SRAM_VERSION, (uint8_t *) (&settings_version), sizeof(settings_version));
-
-    for (int i = 0; i < sizeof(magic); i++) {
-        if (buffer[i] != magic[i]) {
-            uninitialized = true;
-            break;
-        }
-    }
+    rtc_write_joybus_time();
 
-    if (uninitialized) {
-        rtc_write(RTC_ADDRESS_OSCTRIM, &osc_trim, sizeof(osc_trim));
-        rtc_write_time();
-        rtc_write_region();
-        rtc_write(RTC_ADDRESS_SRAM_MAGIC, (uint8_t *) (magic), sizeof(magic));
-    }
+    rtc_mfp_level = (hw_gpio_get(GPIO_ID_RTC_MFP) != 0);
+    rtc_sync_countdown = 0;
 
-    if (uninitialized || (settings_version != RTC_SETTINGS_VERSION)) {
-        settings_version = RTC_SETTINGS_VERSION;
-        rtc_write_settings();
-        rtc_write(RTC_ADDRESS_SRAM_VERSION, (uint8_t *) (&settings_version), sizeof(settings_version));
-    }
-
-    rtc_read_time();
-    rtc_read_region();
-    rtc_read_settings();
-
-    timer_countdown_start(TIMER_ID_RTC, RTC_TIME_REFRESH_PERIOD_MS);
+    timer_countdown_start(TIMER_ID_RTC, RTC_MFP_TIMEOUT_MS);
 }
 
 
@@ -449,15 +607,32 @@ void rtc_process (void) {
 
     if ((scr & RTC_SCR_PENDING) && ((scr & RTC_SCR_MAGIC_MASK) == RTC_SCR_MAGIC)) {
         rtc_read_joybus_time();
-        rtc_write_time();
-        rtc_read_time();
-        rtc_write_joybus_time();
         fpga_reg_set(REG_RTC_SCR, RTC_SCR_DONE);
+        rtc_pending |= RTC_PENDING_WRITE_TIME;
+        rtc_sync_countdown = 0;
+    }
+
+    bool mfp_level = (hw_gpio_get(GPIO_ID_RTC_MFP) != 0);
+
+    if (mfp_level != rtc_mfp_level) {
+        rtc_mfp_level = mfp_level;
+        timer_countdown_start(TIMER_ID_RTC, RTC_MFP_TIMEOUT_MS);
+        if (mfp_level == rtc_tick_level) {
+            rtc_tick();
+            rtc_write_joybus_time();
+            if (rtc_sync_countdown > 0) {
+                rtc_sync_countdown -= 1;
+            }
+        } else if (rtc_sync_countdown == 0) {
+            rtc_sync_countdown = RTC_TIME_SYNC_PERIOD_S;
+            rtc_pending |= RTC_PENDING_READ_TIME;
+        }
     }
 
     if (timer_countdown_elapsed(TIMER_ID_RTC)) {
         timer_countdown_start(TIMER_ID_RTC, RTC_TIME_REFRESH_PERIOD_MS);
-        rtc_read_time();
-        rtc_write_joybus_time();
+        rtc_pending |= RTC_PENDING_READ_TIME;
     }
+
+    rtc_i2c_process();
 }
@@ -1,6 +1,7 @@
 #include "fpga.h"
 #include "hw.h"
 #include "sd.h"
+#include "telemetry.h"
 #include "timer.h"
 
 
@@ -41,12 +42,24 @@
 #define DAT_TIMEOUT_INIT_MS             (2000)
 #define DAT_TIMEOUT_DATA_MS             (5000)
 
+#define FPGA_CLOCK_KHZ                  (100000)
+
+#define TUNING_SECTOR                   (0)
+#define TUNING_READS                    (4)
+#define TUNING_SAMPLE_DELAYS            (4)
+#define TUNING_TIMEOUT_MS               (100)
+
+#define RETRY_MAX_ERRORS                (16)
+#define RETRY_FALLBACK_ERRORS           (3)
+
 
 typedef enum {
-    CLOCK_STOP,
-    CLOCK_400KHZ,
-    CLOCK_25MHZ,
-    CLOCK_50MHZ,
+    CLOCK_STOP = 0,
+    CLOCK_50MHZ = 1,
+    CLOCK_33MHZ = 2,
+    CLOCK_25MHZ = 3,
+    CLOCK_12MHZ = 7,
+    CLOCK_400KHZ = 249,
 } sd_clock_t;
 
 typedef enum {
@@ -78,6 +91,19 @@ typedef enum {
     CMD6_ERROR_TIMEOUT,
 } cmd6_error_t;
 
+typedef struct {
+    uint32_t crc_errors;
+    uint32_t retries;
+    uint32_t fallbacks;
+    uint32_t failures;
+} sd_stats_t;
+
+typedef struct {
+    uint32_t run_blocks;
+    uint32_t errors;
+    uint32_t consecutive_errors;
+} dat_retry_t;
+
 
 struct process {
     bool card_initialized;
@@ -87,28 +113,33 @@ struct process {
     uint8_t cid[16];
     bool byte_swap;
     sd_lock_t lock;
+    sd_clock_t clock;
+    uint8_t sample_delay;
+    bool clock_tuned;
+    sd_stats_t stats;
 };
 
 
 static struct process p;
 
+static const sd_clock_t tuning_clocks_hs[] = { CLOCK_50MHZ, CLOCK_33MHZ, CLOCK_25MHZ };
+static const sd_clock_t tuning_clocks_ds[] = { CLOCK_25MHZ };
 
-static void sd_set_clock (sd_clock_t mode) {
-    fpga_reg_set(REG_SD_SCR, SD_SCR_CLOCK_MODE_OFF);
 
-    switch (mode) {
-        case CLOCK_400KHZ:
-            fpga_reg_set(REG_SD_SCR, SD_SCR_CLOCK_MODE_400KHZ);
-            break;
-        case CLOCK_25MHZ:
-            fpga_reg_set(REG_SD_SCR, SD_SCR_CLOCK_MODE_25MHZ);
-            break;
-        case CLOCK_50MHZ:
-            fpga_reg_set(REG_SD_SCR, SD_SCR_CLOCK_MODE_50MHZ);
-            break;
-        default:
-            break;
+static void sd_set_clock (sd_clock_t clock, uint8_t sample_delay) {
+    fpga_reg_set(REG_SD_SCR, 0);
+
+    if (clock != CLOCK_STOP) {
+        fpga_reg_set(REG_SD_SCR, (
+            ((sample_delay << SD_SCR_DAT_SAMPLE_DELAY_BIT) & SD_SCR_DAT_SAMPLE_DELAY_MASK) |
+            ((clock << SD_SCR_CLOCK_PERIOD_BIT) & SD_SCR_CLOCK_PERIOD_MASK) |
+            SD_SCR_CLOCK_CONFIG |
+            SD_SCR_CLOCK_ENABLE
+        ));
     }
+
+    p.clock = clock;
+    p.sample_delay = sample_delay;
 }
 
 static bool sd_cmd (uint8_t cmd, uint32_t arg, rsp_type_t rsp_type, void *rsp) {
@@ -222,6 +253,41 @@ static dat_error_t sd_dat_wait (uint16_t timeout_ms) {
     return DAT_ERROR_TIMEOUT;
 }
 
+static void sd_dat_retry_init (dat_retry_t *retry) {
+    retry->run_blocks = DAT_BLOCK_MAX_COUNT;
+    retry->errors = 0;
+    retry->consecutive_errors = 0;
+}
+
+static void sd_dat_retry_success (dat_retry_t *retry) {
+    retry->consecutive_errors = 0;
+    if (retry->run_blocks < DAT_BLOCK_MAX_COUNT) {
+        retry->run_blocks *= 2;
+    }
+}
+
+static bool sd_dat_retry_error (dat_retry_t *retry, uint32_t blocks) {
+    p.stats.crc_errors += 1;
+    retry->errors += 1;
+    retry->consecutive_errors += 1;
+
+    if (retry->errors > RETRY_MAX_ERRORS) {
+        p.stats.failures += 1;
+        return false;
+    }
+
+    retry->run_blocks = (blocks > 1) ? (blocks / 2) : 1;
+
+    if (((retry->consecutive_errors % RETRY_FALLBACK_ERRORS) == 0) && (p.clock < CLOCK_12MHZ)) {
+        sd_set_clock(p.clock + 1, p.sample_delay);
+        p.stats.fallbacks += 1;
+    }
+
+    p.stats.retries += 1;
+
+    return true;
+}
+
 static bool sd_dat_check_crc16 (uint8_t *data, uint32_t length) {
     uint16_t device_crc[4];
     uint16_t controller_crc[4];
@@ -284,6 +350,70 @@ static cmd6_error_t sd_cmd6 (uint32_t arg, uint8_t *buffer) {
     return CMD6_OK;
 }
 
+static bool sd_tuning_read (void) {
+    fpga_reg_set(REG_SD_DAT, SD_DAT_START_READ | SD_DAT_FIFO_FLUSH);
+    if (sd_cmd(17, TUNING_SECTOR, RSP_R1, NULL)) {
+        sd_dat_abort();
+        return true;
+    }
+    if (sd_dat_wait(TUNING_TIMEOUT_MS) != DAT_OK) {
+        sd_cmd(12, 0, RSP_R1b, NULL);
+        return true;
+    }
+    fpga_reg_set(REG_SD_DAT, SD_DAT_FIFO_FLUSH);
+    return false;
+}
+
+static bool sd_tuning_test (sd_clock_t clock, uint8_t sample_delay) {
+    sd_set_clock(clock, sample_delay);
+    for (int i = 0; i < TUNING_READS; i++) {
+        if (sd_tuning_read()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sd_tune_clock (bool high_speed) {
+    const sd_clock_t *clocks = high_speed ? tuning_clocks_hs : tuning_clocks_ds;
+    int clocks_count = high_speed ? (sizeof(tuning_clocks_hs) / sizeof(sd_clock_t)) : (sizeof(tuning_clocks_ds) / sizeof(sd_clock_t));
+
+    for (int c = 0; c < clocks_count; c++) {
+        bool passed[TUNING_SAMPLE_DELAYS];
+        int best_score = 0;
+        uint8_t best_delay = 0;
+
+        for (int delay = 0; delay < TUNING_SAMPLE_DELAYS; delay++) {
+            passed[delay] = sd_tuning_test(clocks[c], delay);
+        }
+
+        for (int delay = 0; delay < TUNING_SAMPLE_DELAYS; delay++) {
+            if (!passed[delay]) {
+                continue;
+            }
+            int score = 1;
+            if ((delay > 0) && passed[delay - 1]) {
+                score += 1;
+            }
+            if ((delay < (TUNING_SAMPLE_DELAYS - 1)) && passed[delay + 1]) {
+                score += 1;
+            }
+            if (score > best_score) {
+                best_score = score;
+                best_delay = delay;
+            }
+        }
+
+        if (best_score > 0) {
+            sd_set_clock(clocks[c], best_delay);
+            p.clock_tuned = true;
+            return;
+        }
+    }
+
+    sd_set_clock(high_speed ? CLOCK_50MHZ : CLOCK_25MHZ, 0);
+}
+
 
 sd_error_t sd_card_init (void) {
     uint32_t arg;
@@ -302,8 +432,12 @@ sd_error_t sd_card_init (void) {
 
     p.card_initialized = true;
     p.rca = 0;
+    p.clock_tuned = false;
+    p.stats = (sd_stats_t) { 0 };
 
-    sd_set_clock(CLOCK_400KHZ);
+    bool high_speed = false;
+
+    sd_set_clock(CLOCK_400KHZ, 0);
 
     sd_cmd(0, 0, RSP_NONE, NULL);
 
@@ -337,7 +471,7 @@ sd_error_t sd_card_init (void) {
         }
     } while (true);
 
-    sd_set_clock(CLOCK_25MHZ);
+    sd_set_clock(CLOCK_25MHZ, 0);
 
     if (sd_cmd(2, 0, RSP_R2, NULL)) {
         sd_card_deinit();
@@ -374,7 +508,8 @@ sd_error_t sd_card_init (void) {
                             return SD_ERROR_CMD6_SWITCH_RESPONSE;
                         }
                         if (CMD6_HS_ENABLED(cmd6_buffer)) {
-                            sd_set_clock(CLOCK_50MHZ);
+                            sd_set_clock(CLOCK_50MHZ, 0);
+                            high_speed = true;
                         }
                         break;
                     }
@@ -423,6 +558,8 @@ sd_error_t sd_card_init (void) {
         return SD_ERROR_CMD7_IO;
     }
 
+    sd_tune_clock(high_speed);
+
     return SD_OK;
 }
 
@@ -431,9 +568,10 @@ void sd_card_deinit (void) {
         p.card_initialized = false;
         p.card_type_block = false;
         p.byte_swap = false;
-        sd_set_clock(CLOCK_400KHZ);
+        p.clock_tuned = false;
+        sd_set_clock(CLOCK_400KHZ, 0);
         sd_cmd(0, 0, RSP_NONE, NULL);
-        sd_set_clock(CLOCK_STOP);
+        sd_set_clock(CLOCK_STOP, 0);
     }
 }
 
@@ -443,12 +581,18 @@ bool sd_card_is_inserted (void) {
 
 uint32_t sd_card_get_status (void) {
     uint32_t scr = fpga_reg_get(REG_SD_SCR);
+    uint32_t clock_khz = (p.clock != CLOCK_STOP) ? (FPGA_CLOCK_KHZ / (p.clock + 1)) : 0;
+    uint32_t sample_delay = p.sample_delay;
+    uint32_t clock_tuned = p.clock_tuned ? 1 : 0;
     uint32_t byte_swap = p.byte_swap ? 1 : 0;
-    uint32_t clock_mode_50mhz = ((scr & SD_SCR_CLOCK_MODE_MASK) == SD_SCR_CLOCK_MODE_50MHZ) ? 1 : 0;
+    uint32_t clock_mode_50mhz = ((p.clock != CLOCK_STOP) && (p.clock < CLOCK_25MHZ)) ? 1 : 0;
     uint32_t card_type_block = p.card_type_block ? 1 : 0;
     uint32_t card_initialized = p.card_initialized ? 1 : 0;
     uint32_t card_inserted = (scr & SD_SCR_CARD_INSERTED) ? 1 : 0;
     return (
+        (clock_khz << 16) |
+        (sample_delay << 6) |
+        (clock_tuned << 5) |
         (byte_swap << 4) |
         (clock_mode_50mhz << 3) |
         (card_type_block << 2) |
@@ -468,6 +612,17 @@ sd_error_t sd_card_get_info (uint32_t address) {
     return SD_OK;
 }
 
+sd_error_t sd_card_get_stats (uint32_t address) {
+    uint32_t stats[SD_CARD_STATS_SIZE / sizeof(uint32_t)] = {
+        SWAP32(p.stats.crc_errors),
+        SWAP32(p.stats.retries),
+        SWAP32(p.stats.fallbacks),
+        SWAP32(p.stats.failures),
+    };
+    fpga_mem_write(address, sizeof(stats), (uint8_t *) (stats));
+    return SD_OK;
+}
+
 sd_error_t sd_set_byte_swap (bool enabled) {
     if (!p.card_initialized) {
         return SD_ERROR_NOT_INITIALIZED;
@@ -490,23 +645,33 @@ sd_error_t sd_write_sectors (uint32_t address, uint32_t sector, uint32_t count)
         sector *= SD_SECTOR_SIZE;
     }
 
+    uint32_t start_us = telemetry_op_start();
+
+    dat_retry_t retry;
+    sd_dat_retry_init(&retry);
+
     while (count > 0) {
-        uint32_t blocks = ((count > DAT_BLOCK_MAX_COUNT) ? DAT_BLOCK_MAX_COUNT : count);
+        uint32_t blocks = ((count > retry.run_blocks) ? retry.run_blocks : count);
         if (sd_cmd(25, sector, RSP_R1, NULL)) {
             return SD_ERROR_CMD25_IO;
         }
         sd_dat_prepare(address, blocks, DAT_WRITE);
         dat_error_t error = sd_dat_wait(DAT_TIMEOUT_DATA_MS);
+        sd_cmd(12, 0, RSP_R1b, NULL);
         if (error != DAT_OK) {
-            sd_cmd(12, 0, RSP_R1b, NULL);
+            if ((error == DAT_ERROR_IO) && sd_dat_retry_error(&retry, blocks)) {
+                continue;
+            }
             return (error == DAT_ERROR_IO) ? SD_ERROR_CMD25_CRC : SD_ERROR_CMD25_TIMEOUT;
         }
-        sd_cmd(12, 0, RSP_R1b, NULL);
+        sd_dat_retry_success(&retry);
         address += (blocks * SD_SECTOR_SIZE);
         sector += (blocks * (p.card_type_block ? 1 : SD_SECTOR_SIZE));
         count -= blocks;
     }
 
+    telemetry_op_done(TELEMETRY_OP_SD, start_us);
+
     return false;
 }
 
@@ -527,24 +692,34 @@ sd_error_t sd_read_sectors (uint32_t address, uint32_t sector, uint32_t count) {
         sector *= SD_SECTOR_SIZE;
     }
 
+    uint32_t start_us = telemetry_op_start();
+
+    dat_retry_t retry;
+    sd_dat_retry_init(&retry);
+
     while (count > 0) {
-        uint32_t blocks = ((count > DAT_BLOCK_MAX_COUNT) ? DAT_BLOCK_MAX_COUNT : count);
+        uint32_t blocks = ((count > retry.run_blocks) ? retry.run_blocks : count);
         sd_dat_prepare(address, blocks, DAT_READ);
         if (sd_cmd(18, sector, RSP_R1, NULL)) {
             sd_dat_abort();
             return SD_ERROR_CMD18_IO;
         }
         dat_error_t error = sd_dat_wait(DAT_TIMEOUT_DATA_MS);
+        sd_cmd(12, 0, RSP_R1b, NULL);
         if (error != DAT_OK) {
-            sd_cmd(12, 0, RSP_R1b, NULL);
+            if ((error == DAT_ERROR_IO) && sd_dat_retry_error(&retry, blocks)) {
+                continue;
+            }
             return (error == DAT_ERROR_IO) ? SD_ERROR_CMD18_CRC : SD_ERROR_CMD18_TIMEOUT;
         }
-        sd_cmd(12, 0, RSP_R1b, NULL);
+        sd_dat_retry_success(&retry);
         address += (blocks * SD_SECTOR_SIZE);
         sector += (blocks * (p.card_type_block ? 1 : SD_SECTOR_SIZE));
         count -= blocks;
     }
 
+    telemetry_op_done(TELEMETRY_OP_SD, start_us);
+
     return SD_OK;
 }
 
@@ -603,7 +778,8 @@ void sd_init (void) {
     p.card_initialized = false;
     p.byte_swap = false;
     p.lock = SD_LOCK_NONE;
-    sd_set_clock(CLOCK_STOP);
+    p.clock_tuned = false;
+    sd_set_clock(CLOCK_STOP, 0);
 }
 
 
@@ -8,6 +8,7 @@
 
 #define SD_SECTOR_SIZE      (512)
 #define SD_CARD_INFO_SIZE   (32)
+#define SD_CARD_STATS_SIZE  (16)
 
 
 typedef enum {
@@ -58,6 +59,7 @@ void sd_card_deinit (void);
 bool sd_card_is_inserted (void);
 uint32_t sd_card_get_status (void);
 sd_error_t sd_card_get_info (uint32_t address);
+sd_error_t sd_card_get_stats (uint32_t address);
 sd_error_t sd_set_byte_swap (bool enabled);
 
 sd_error_t sd_write_sectors (uint32_t address, uint32_t sector, uint32_t count);
@@ -0,0 +1,168 @@
+#include "fpga.h"
+#include "hw.h"
+#include "telemetry.h"
+#include "timer.h"
+#include "usb.h"
+#include "writeback.h"
+
+
+#define TELEMETRY_BUFFER_ADDRESS    (0x05002B00UL)
+#define TELEMETRY_BUFFER_LENGTH     (128)
+
+#define TELEMETRY_VERSION           (1)
+
+#define TELEMETRY_PERIOD_MIN_MS     (100)
+#define TELEMETRY_PERIOD_MAX_MS     (60000)
+
+#define TELEMETRY_PENDING_WRITEBACK (1 << 0)
+#define TELEMETRY_PENDING_FLASHRAM  (1 << 1)
+
+
+typedef struct {
+    uint32_t count;
+    uint32_t latency_total_us;
+    uint32_t latency_max_us;
+} telemetry_op_stats_t;
+
+typedef struct {
+    uint32_t version;
+    uint32_t timestamp_us;
+    uint32_t loop_count;
+    uint32_t loop_period_max_us;
+    uint32_t voltage;
+    uint32_t temperature;
+    uint32_t usb_rx_fifo_count;
+    uint32_t usb_tx_fifo_count;
+    uint32_t pending;
+    telemetry_op_stats_t ops[__TELEMETRY_OP_COUNT];
+} telemetry_report_t;
+
+_Static_assert(sizeof(telemetry_report_t) <= TELEMETRY_BUFFER_LENGTH, "Telemetry report doesn't fit in its buffer");
+
+struct process {
+    uint32_t period_ms;
+    uint32_t last_report_us;
+    bool report_in_flight;
+    uint32_t last_loop_us;
+    uint32_t loop_count;
+    uint32_t loop_period_max_us;
+    telemetry_op_stats_t ops[__TELEMETRY_OP_COUNT];
+};
+
+
+static struct process p;
+
+
+static void telemetry_report_done (void) {
+    p.report_in_flight = false;
+}
+
+static void telemetry_send_report (uint32_t now_us) {
+    telemetry_report_t report;
+    uint16_t voltage;
+    int16_t temperature;
+    uint32_t usb_fifo_count = fpga_reg_get(REG_USB_FIFO_COUNT);
+
+    hw_adc_read_voltage_temperature(&voltage, &temperature);
+
+    report.version = TELEMETRY_VERSION;
+    report.timestamp_us = now_us;
+    report.loop_count = p.loop_count;
+    report.loop_period_max_us = p.loop_period_max_us;
+    report.voltage = (uint32_t) (voltage);
+    report.temperature = (uint32_t) (temperature);
+    report.usb_rx_fifo_count = ((usb_fifo_count & USB_FIFO_COUNT_RX_MASK) >> USB_FIFO_COUNT_RX_BIT);
+    report.usb_tx_fifo_count = ((usb_fifo_count & USB_FIFO_COUNT_TX_MASK) >> USB_FIFO_COUNT_TX_BIT);
+    report.pending = 0;
+    if (writeback_pending()) {
+        report.pending |= TELEMETRY_PENDING_WRITEBACK;
+    }
+    if (fpga_reg_get(REG_FLASHRAM_SCR) & FLASHRAM_SCR_PENDING) {
+        report.pending |= TELEMETRY_PENDING_FLASHRAM;
+    }
+    for (telemetry_op_t op = 0; op < __TELEMETRY_OP_COUNT; op++) {
+        report.ops[op] = p.ops[op];
+    }
+
+    uint32_t *words = (uint32_t *) (&report);
+    for (int i = 0; i < (sizeof(report) / sizeof(uint32_t)); i++) {
+        words[i] = SWAP32(words[i]);
+    }
+    fpga_mem_write(TELEMETRY_BUFFER_ADDRESS, sizeof(report), (uint8_t *) (&report));
+
+    usb_tx_info_t packet_info;
+    usb_create_packet(&packet_info, PACKET_CMD_TELEMETRY);
+    packet_info.dma_length = sizeof(report);
+    packet_info.dma_address = TELEMETRY_BUFFER_ADDRESS;
+    packet_info.done_callback = telemetry_report_done;
+    if (usb_enqueue_packet(&packet_info)) {
+        p.report_in_flight = true;
+        p.last_report_us = now_us;
+        p.loop_period_max_us = 0;
+        for (telemetry_op_t op = 0; op < __TELEMETRY_OP_COUNT; op++) {
+            p.ops[op].latency_max_us = 0;
+        }
+    }
+}
+
+
+uint32_t telemetry_op_start (void) {
+    return timer_get_timestamp_us();
+}
+
+void telemetry_op_done (telemetry_op_t op, uint32_t start_us) {
+    uint32_t latency_us = timer_get_elapsed_us(start_us);
+    p.ops[op].count += 1;
+    p.ops[op].latency_total_us += latency_us;
+    if (latency_us > p.ops[op].latency_max_us) {
+        p.ops[op].latency_max_us = latency_us;
+    }
+}
+
+bool telemetry_set_period (uint32_t period_ms) {
+    if ((period_ms != 0) && ((period_ms < TELEMETRY_PERIOD_MIN_MS) || (period_ms > TELEMETRY_PERIOD_MAX_MS))) {
+        return true;
+    }
+    p.period_ms = period_ms;
+    p.last_report_us = timer_get_timestamp_us();
+    return false;
+}
+
+void telemetry_reset (void) {
+    p.period_ms = 0;
+}
+
+
+void telemetry_init (void) {
+    p.period_ms = 0;
+    p.last_report_us = timer_get_timestamp_us();
+    p.report_in_flight = false;
+    p.last_loop_us = p.last_report_us;
+    p.loop_count = 0;
+    p.loop_period_max_us = 0;
+    for (telemetry_op_t op = 0; op < __TELEMETRY_OP_COUNT; op++) {
+        p.ops[op].count = 0;
+        p.ops[op].latency_total_us = 0;
+        p.ops[op].latency_max_us = 0;
+    }
+}
+
+
+void telemetry_process (void) {
+    uint32_t now_us = timer_get_timestamp_us();
+    uint32_t loop_period_us = (now_us - p.last_loop_us);
+
+    p.last_loop_us = now_us;
+    p.loop_count += 1;
+    if (loop_period_us > p.loop_period_max_us) {
+        p.loop_period_max_us = loop_period_us;
+    }
+
+    if ((p.period_ms == 0) || p.report_in_flight) {
+        return;
+    }
+
+    if ((now_us - p.last_report_us) >= (p.period_ms * 1000)) {
+        telemetry_send_report(now_us);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef TELEMETRY_H__
+#define TELEMETRY_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+typedef enum {
+    TELEMETRY_OP_SD,
+    TELEMETRY_OP_USB,
+    TELEMETRY_OP_DD,
+    TELEMETRY_OP_WRITEBACK,
+    TELEMETRY_OP_FLASHRAM,
+    __TELEMETRY_OP_COUNT
+} telemetry_op_t;
+
+
+uint32_t telemetry_op_start (void);
+void telemetry_op_done (telemetry_op_t op, uint32_t start_us);
+
+bool telemetry_set_period (uint32_t period_ms);
+void telemetry_reset (void);
+
+void telemetry_init (void);
+
+void telemetry_process (void);
+
+
+#endif
@@ -1,48 +1,66 @@
+#include <stddef.h>
 #include "hw.h"
 #include "timer.h"
 
 
-#define TIMER_PERIOD_MS     (25)
+#define TIMER_PERIOD_MS     (1)
 
 
-typedef struct {
-    volatile bool pending;
+typedef struct timer {
     volatile bool running;
-    volatile uint32_t value;
+    uint32_t deadline_ms;
+    struct timer *next;
 } timer_t;
 
 static timer_t timer[__TIMER_ID_COUNT];
+static timer_t *timer_head;
+static volatile uint32_t timer_elapsed_ms;
 
 
-static void timer_update (void) {
-    for (timer_id_t id = 0; id < __TIMER_ID_COUNT; id++) {
-        if (timer[id].value > 0) {
-            timer[id].value -= 1;
-        }
-        if (timer[id].pending) {
-            timer[id].pending = false;
-        } else if (timer[id].value == 0) {
-            timer[id].running = false;
+static void timer_unlink (timer_t *t) {
+    timer_t **link = &timer_head;
+    while (*link != NULL) {
+        if (*link == t) {
+            *link = t->next;
+            break;
         }
+        link = &(*link)->next;
+    }
+    t->next = NULL;
+    t->running = false;
+}
+
+static void timer_update (void) {
+    timer_elapsed_ms += TIMER_PERIOD_MS;
+    while ((timer_head != NULL) && ((int32_t) (timer_elapsed_ms - timer_head->deadline_ms) > 0)) {
+        timer_t *t = timer_head;
+        timer_head = t->next;
+        t->next = NULL;
+        t->running = false;
     }
 }
 
 
 void timer_countdown_start (timer_id_t id, uint32_t value_ms) {
-    hw_enter_critical();
     if (value_ms > 0) {
-        timer[id].pending = true;
-        timer[id].running = true;
-        timer[id].value = ((value_ms + (TIMER_PERIOD_MS - 1)) / TIMER_PERIOD_MS);
+        timer_t *t = &timer[id];
+        hw_enter_critical();
+        timer_unlink(t);
+        t->deadline_ms = (timer_elapsed_ms + value_ms);
+        timer_t **link = &timer_head;
+        while ((*link != NULL) && ((int32_t) ((*link)->deadline_ms - t->deadline_ms) <= 0)) {
+            link = &(*link)->next;
+        }
+        t->next = *link;
+        *link = t;
+        t->running = true;
+        hw_exit_critical();
     }
-    hw_exit_critical();
 }
 
 void timer_countdown_abort (timer_id_t id) {
     hw_enter_critical();
-    timer[id].pending = false;
-    timer[id].running = false;
-    timer[id].value = 0;
+    timer_unlink(&timer[id]);
     hw_exit_critical();
 }
 
@@ -51,6 +69,25 @@ bool timer_countdown_elapsed (timer_id_t id) {
 }
 
 
+uint32_t timer_get_timestamp_ms (void) {
+    return timer_elapsed_ms;
+}
+
+uint32_t timer_get_timestamp_us (void) {
+    return hw_timebase_get_us();
+}
+
+uint32_t timer_get_elapsed_us (uint32_t start_us) {
+    return (timer_get_timestamp_us() - start_us);
+}
+
+
 void timer_init (void) {
+    timer_elapsed_ms = 0;
+    timer_head = NULL;
+    for (timer_id_t id = 0; id < __TIMER_ID_COUNT; id++) {
+        timer[id].running = false;
+        timer[id].next = NULL;
+    }
     hw_systick_config(TIMER_PERIOD_MS, timer_update);
 }
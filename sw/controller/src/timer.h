@@ -10,6 +10,7 @@ typedef enum {
     TIMER_ID_DD,
     TIMER_ID_LED,
     TIMER_ID_RTC,
+    TIMER_ID_RTC_I2C,
     TIMER_ID_SD,
     TIMER_ID_USB,
     TIMER_ID_WRITEBACK,
@@ -21,6 +22,10 @@ void timer_countdown_start (timer_id_t id, uint32_t value_ms);
 void timer_countdown_abort (timer_id_t id);
 bool timer_countdown_elapsed (timer_id_t id);
 
+uint32_t timer_get_timestamp_ms (void);
+uint32_t timer_get_timestamp_us (void);
+uint32_t timer_get_elapsed_us (uint32_t start_us);
+
 void timer_init (void);
 
 
@@ -15,6 +15,8 @@
 #define BOOTLOADER_ADDRESS      (0x04E00000UL)
 #define BOOTLOADER_LENGTH       (0x001E0000UL)
 
+#define MCU_BLOCK_SIZE          (1024)
+
 
 typedef enum {
     UPDATE_STATUS_MCU = 1,
@@ -35,10 +37,11 @@ typedef enum {
 
 static loader_parameters_t parameters;
 static const uint8_t update_token[16] = "SC64 Update v2.0";
-static uint8_t status_data[12] = {
+static uint8_t status_data[16] = {
     'P', 'K', 'T', PACKET_CMD_UPDATE_STATUS,
-    0, 0, 0, 4,
+    0, 0, 0, 8,
     0, 0, 0, UPDATE_STATUS_ERROR,
+    0, 0, 0, 0,
 };
 
 
@@ -53,6 +56,9 @@ static uint32_t update_checksum (uint32_t address, uint32_t length) {
     uint8_t buffer[128];
     uint32_t block_size;
     uint32_t checksum = 0;
+    if (!fpga_mem_crc32(address, length, &checksum)) {
+        return checksum;
+    }
     hw_crc32_reset();
     while (length > 0) {
         block_size = (length > sizeof(buffer)) ? sizeof(buffer) : length;
@@ -135,7 +141,12 @@ static void update_blink_led (uint32_t on, uint32_t off, int repeat) {
 }
 
 static void update_status_notify (update_status_t status) {
-    status_data[sizeof(status_data) - 1] = (uint8_t) (status);
+    uint32_t elapsed_ms = hw_stopwatch_get_ms();
+    status_data[11] = (uint8_t) (status);
+    status_data[12] = (uint8_t) (elapsed_ms >> 24);
+    status_data[13] = (uint8_t) (elapsed_ms >> 16);
+    status_data[14] = (uint8_t) (elapsed_ms >> 8);
+    status_data[15] = (uint8_t) (elapsed_ms);
     for (int i = 0; i < sizeof(status_data); i++) {
         while (!(fpga_usb_status_get() & USB_STATUS_TXE));
         fpga_usb_push(status_data[i]);
@@ -149,40 +160,68 @@ static void update_status_notify (update_status_t status) {
         update_blink_led(15, 185, 2);
         hw_delay_ms(500);
     }
+    hw_stopwatch_start();
 }
 
-static bool mcu_update (uint32_t address, uint32_t length) {
-    hw_flash_t buffer;
-    hw_flash_erase();
-    for (uint32_t offset = 0; offset < length; offset += sizeof(hw_flash_t)) {
-        fpga_mem_read(address + offset, sizeof(hw_flash_t), (uint8_t *) (&buffer));
-        hw_flash_program(offset, buffer);
-        if (hw_flash_read(offset) != buffer) {
-            return true;
+static void mcu_read_block (uint32_t address, uint32_t length, uint32_t offset, hw_flash_t *buffer) {
+    uint8_t *data = (uint8_t *) (buffer);
+    uint32_t block_length = 0;
+    if (offset < length) {
+        block_length = (length - offset);
+        if (block_length > MCU_BLOCK_SIZE) {
+            block_length = MCU_BLOCK_SIZE;
         }
+        fpga_mem_read(address + offset, block_length, data);
+    }
+    for (uint32_t i = block_length; i < MCU_BLOCK_SIZE; i++) {
+        data[i] = 0xFF;
     }
-    return false;
 }
 
-static bool bootloader_update (uint32_t address, uint32_t length) {
-    uint8_t update_buffer[FPGA_MAX_MEM_TRANSFER];
-    uint8_t verify_buffer[FPGA_MAX_MEM_TRANSFER];
-    for (uint32_t offset = 0; offset < BOOTLOADER_LENGTH; offset += FLASH_ERASE_BLOCK_SIZE) {
-        if (flash_erase_block(BOOTLOADER_ADDRESS + offset)) {
+static bool mcu_compare (uint32_t offset, hw_flash_t *buffer, uint32_t length) {
+    for (uint32_t i = 0; i < (length / sizeof(hw_flash_t)); i++) {
+        if (hw_flash_read(offset + (i * sizeof(hw_flash_t))) != buffer[i]) {
             return true;
         }
     }
-    if (flash_program(address, BOOTLOADER_ADDRESS, length)) {
-        return true;
+    return false;
+}
+
+static bool mcu_blank (hw_flash_t *buffer, uint32_t length) {
+    for (uint32_t i = 0; i < (length / sizeof(hw_flash_t)); i++) {
+        if (buffer[i] != 0xFFFFFFFFFFFFFFFFULL) {
+            return false;
+        }
     }
-    for (uint32_t offset = 0; offset < length; offset += sizeof(verify_buffer)) {
-        fpga_mem_read(address + offset, sizeof(update_buffer), update_buffer);
-        fpga_mem_read(BOOTLOADER_ADDRESS + offset, sizeof(verify_buffer), verify_buffer);
-        for (int i = 0; i < sizeof(verify_buffer); i++) {
-            if ((offset + i) >= length) {
+    return true;
+}
+
+static bool mcu_update (uint32_t address, uint32_t length) {
+    hw_flash_t buffer[MCU_BLOCK_SIZE / sizeof(hw_flash_t)];
+    for (uint32_t page = 0; page < hw_flash_size(); page += HW_FLASH_PAGE_SIZE) {
+        bool changed = false;
+        for (uint32_t offset = page; offset < (page + HW_FLASH_PAGE_SIZE); offset += MCU_BLOCK_SIZE) {
+            mcu_read_block(address, length, offset, buffer);
+            if (mcu_compare(offset, buffer, MCU_BLOCK_SIZE)) {
+                changed = true;
                 break;
             }
-            if (update_buffer[i] != verify_buffer[i]) {
+        }
+        if (!changed) {
+            continue;
+        }
+        hw_flash_erase_page(page);
+        for (uint32_t offset = page; offset < (page + HW_FLASH_PAGE_SIZE); offset += MCU_BLOCK_SIZE) {
+            mcu_read_block(address, length, offset, buffer);
+            for (uint32_t row = 0; row < MCU_BLOCK_SIZE; row += HW_FLASH_ROW_SIZE) {
+                hw_flash_t *row_buffer = &buffer[row / sizeof(hw_flash_t)];
+                if (!mcu_blank(row_buffer, HW_FLASH_ROW_SIZE)) {
+                    if (hw_flash_program_row(offset + row, row_buffer)) {
+                        return true;
+                    }
+                }
+            }
+            if (mcu_compare(offset, buffer, MCU_BLOCK_SIZE)) {
                 return true;
             }
         }
@@ -190,6 +229,28 @@ static bool bootloader_update (uint32_t address, uint32_t length) {
     return false;
 }
 
+static bool bootloader_update (uint32_t address, uint32_t length) {
+    uint32_t block_length;
+    for (uint32_t offset = 0; offset < length; offset += block_length) {
+        block_length = ((length - offset) > FLASH_ERASE_BLOCK_SIZE) ? FLASH_ERASE_BLOCK_SIZE : (length - offset);
+        uint32_t checksum = update_checksum(address + offset, block_length);
+        if (update_checksum(BOOTLOADER_ADDRESS + offset, block_length) == checksum) {
+            continue;
+        }
+        if (flash_erase_block(BOOTLOADER_ADDRESS + offset)) {
+            return true;
+        }
+        if (flash_program(address + offset, BOOTLOADER_ADDRESS + offset, block_length)) {
+            return true;
+        }
+        flash_wait_busy();
+        if (update_checksum(BOOTLOADER_ADDRESS + offset, block_length) != checksum) {
+            return true;
+        }
+    }
+    return false;
+}
+
 
 update_error_t update_backup (uint32_t address, uint32_t *length) {
     uint32_t mcu_length;
@@ -281,6 +342,9 @@ update_error_t update_prepare (uint32_t address, uint32_t length) {
                 if (data_length > BOOTLOADER_LENGTH) {
                     return UPDATE_ERROR_SIZE;
                 }
+                if (update_checksum(BOOTLOADER_ADDRESS, data_length) == update_checksum(data_address, data_length)) {
+                    break;
+                }
                 parameters.flags |= LOADER_FLAGS_UPDATE_BOOTLOADER;
                 parameters.bootloader_address = data_address;
                 break;
@@ -309,6 +373,8 @@ bool update_check (void) {
 void update_perform (void) {
     uint32_t length;
 
+    hw_stopwatch_start();
+
     if (parameters.flags & LOADER_FLAGS_UPDATE_MCU) {
         update_status_notify(UPDATE_STATUS_MCU);
         fpga_mem_read(parameters.mcu_address - 4, sizeof(length), (uint8_t *) (&length));
@@ -1,3 +1,4 @@
+#include "bist.h"
 #include "cfg.h"
 #include "cic.h"
 #include "dd.h"
@@ -7,6 +8,7 @@
 #include "led.h"
 #include "rtc.h"
 #include "sd.h"
+#include "telemetry.h"
 #include "timer.h"
 #include "update.h"
 #include "usb.h"
@@ -27,6 +29,15 @@
 #define DIAGNOSTIC_DATA_MARKER  (1 << 31)
 #define DIAGNOSTIC_DATA_VERSION (1)
 
+#define BIST_CONTROL_WRITE_PASS     (1 << 0)
+#define BIST_CONTROL_VERIFY_PASS    (1 << 1)
+#define BIST_CONTROL_INVERT         (1 << 2)
+#define BIST_CONTROL_STOP           (1 << 3)
+#define BIST_CONTROL_PATTERN_BIT    (4)
+#define BIST_CONTROL_PATTERN_MASK   (0x3)
+#define BIST_CONTROL_ERROR_BIT      (8)
+#define BIST_CONTROL_ERROR_MASK     (0xFF)
+
 
 enum rx_state {
     RX_STATE_IDLE,
@@ -52,12 +63,14 @@ struct process {
     uint8_t rx_cmd;
     uint32_t rx_args[2];
     bool rx_dma_running;
+    uint32_t rx_start_us;
 
     enum tx_state tx_state;
     uint8_t tx_counter;
     usb_tx_info_t tx_info;
     uint32_t tx_token;
     bool tx_dma_running;
+    uint32_t tx_start_us;
 
     bool flush_response;
     bool flush_packet;
@@ -226,6 +239,7 @@ static void usb_rx_process (void) {
             p.rx_state = RX_STATE_ARGS;
             p.rx_counter = 0;
             p.rx_dma_running = false;
+            p.rx_start_us = telemetry_op_start();
             p.flush_response = false;
             p.flush_packet = false;
             p.response_error = false;
@@ -271,6 +285,7 @@ static void usb_rx_process (void) {
                 cfg_reset_state();
                 cic_reset_parameters();
                 sd_release_lock(SD_LOCK_USB);
+                telemetry_reset();
                 p.rx_state = RX_STATE_IDLE;
                 p.response_pending = true;
                 break;
@@ -438,6 +453,14 @@ static void usb_rx_process (void) {
                         }
                         break;
 
+                    case 6:
+                        if (usb_validate_address_length(p.rx_args[0], SD_CARD_STATS_SIZE, true)) {
+                            error = SD_ERROR_INVALID_ADDRESS;
+                        } else {
+                            error = sd_card_get_stats(p.rx_args[0]);
+                        }
+                        break;
+
                     default:
                         error = SD_ERROR_INVALID_OPERATION;
                         break;
@@ -535,6 +558,23 @@ static void usb_rx_process (void) {
                 p.response_pending = true;
                 break;
 
+            case 'E':
+                if (usb_validate_address_length(p.rx_args[0], p.rx_args[1], true)) {
+                    p.response_error = true;
+                } else {
+                    p.response_error = flash_erase_range(p.rx_args[0], p.rx_args[1]);
+                }
+                p.rx_state = RX_STATE_IDLE;
+                p.response_pending = true;
+                break;
+
+            case 'e':
+                p.rx_state = RX_STATE_IDLE;
+                p.response_pending = true;
+                p.response_info.data_length = 8;
+                p.response_info.data[0] = flash_erase_range_status(&p.response_info.data[1]);
+                break;
+
             case 'f':
                 cfg_set_rom_write_enable(false);
                 p.response_info.data[0] = update_backup(p.rx_args[0], &p.response_info.data[1]);
@@ -557,12 +597,45 @@ static void usb_rx_process (void) {
                 }
                 break;
 
+            case 'b': {
+                uint32_t control = p.rx_args[0];
+                if (control & BIST_CONTROL_STOP) {
+                    bist_stop();
+                } else if (control & (BIST_CONTROL_WRITE_PASS | BIST_CONTROL_VERIFY_PASS)) {
+                    p.response_error = bist_start(
+                        (control & BIST_CONTROL_WRITE_PASS),
+                        (control & BIST_CONTROL_VERIFY_PASS),
+                        (bist_pattern_t) ((control >> BIST_CONTROL_PATTERN_BIT) & BIST_CONTROL_PATTERN_MASK),
+                        (control & BIST_CONTROL_INVERT),
+                        p.rx_args[1]
+                    );
+                }
+                p.rx_state = RX_STATE_IDLE;
+                p.response_pending = true;
+                p.response_info.data_length = 16;
+                p.response_info.data[0] = bist_is_busy();
+                p.response_info.data[1] = bist_get_error_count();
+                bist_get_error(
+                    ((control >> BIST_CONTROL_ERROR_BIT) & BIST_CONTROL_ERROR_MASK),
+                    &p.response_info.data[2],
+                    &p.response_info.data[3]
+                );
+                break;
+            }
+
+            case 'Q':
+                p.response_error = telemetry_set_period(p.rx_args[0]);
+                p.rx_state = RX_STATE_IDLE;
+                p.response_pending = true;
+                break;
+
             case '?':
                 p.rx_state = RX_STATE_IDLE;
                 p.response_pending = true;
-                p.response_info.data_length = 8;
+                p.response_info.data_length = 16;
                 p.response_info.data[0] = fpga_reg_get(REG_DEBUG_0);
                 p.response_info.data[1] = fpga_reg_get(REG_DEBUG_1);
+                cic_get_margins(&p.response_info.data[2]);
                 break;
 
             case '%': {
@@ -632,6 +705,7 @@ static void usb_tx_process (void) {
             p.tx_info = p.response_info;
             p.tx_token = p.response_error ? ERR_TOKEN : CMP_TOKEN;
             p.tx_dma_running = false;
+            p.tx_start_us = p.rx_start_us;
         } else if (p.packet_pending) {
             p.packet_pending = false;
             p.tx_state = TX_STATE_TOKEN;
@@ -690,6 +764,9 @@ static void usb_tx_process (void) {
 
     if (p.tx_state == TX_STATE_FLUSH) {
         fpga_reg_set(REG_USB_SCR, USB_SCR_WRITE_FLUSH);
+        if (p.tx_token != PKT_TOKEN) {
+            telemetry_op_done(TELEMETRY_OP_USB, p.tx_start_us);
+        }
         if (p.tx_info.done_callback) {
             p.tx_info.done_callback();
         }
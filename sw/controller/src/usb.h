@@ -15,6 +15,7 @@ typedef enum packet_cmd {
     PACKET_CMD_ISV_OUTPUT = 'I',
     PACKET_CMD_SAVE_WRITEBACK = 'S',
     PACKET_CMD_UPDATE_STATUS = 'F',
+    PACKET_CMD_TELEMETRY = 'Q',
 } usb_packet_cmd_e;
 
 
@@ -2,6 +2,7 @@
 #include "fpga.h"
 #include "led.h"
 #include "sd.h"
+#include "telemetry.h"
 #include "timer.h"
 #include "usb.h"
 #include "writeback.h"
@@ -172,15 +173,19 @@ void writeback_process (void) {
     }
 
     if (p.pending && timer_countdown_elapsed(TIMER_ID_WRITEBACK)) {
+        uint32_t start_us = telemetry_op_start();
+
         switch (p.mode) {
             case WRITEBACK_SD:
                 writeback_save_to_sd();
                 p.pending = false;
+                telemetry_op_done(TELEMETRY_OP_WRITEBACK, start_us);
                 break;
 
             case WRITEBACK_USB:
                 if (writeback_save_to_usb()) {
                     p.pending = false;
+                    telemetry_op_done(TELEMETRY_OP_WRITEBACK, start_us);
                 }
                 break;
 
@@ -0,0 +1,122 @@
+use std::time::Duration;
+
+pub enum Unit {
+    MibPerSecond,
+    Microseconds,
+    Milliseconds,
+}
+
+impl Unit {
+    fn as_str(&self) -> &'static str {
+        match self {
+            Unit::MibPerSecond => "MiB/s",
+            Unit::Microseconds => "us",
+            Unit::Milliseconds => "ms",
+        }
+    }
+}
+
+pub struct BenchResult {
+    pub group: &'static str,
+    pub test: String,
+    pub parameter: String,
+    pub value: f64,
+    pub unit: Unit,
+    /// Result only approximates the named operation (console side of the transfer is missing)
+    pub proxy: bool,
+}
+
+pub struct BenchReport {
+    pub firmware_version: String,
+    pub serial: String,
+    pub timestamp: String,
+    pub results: Vec<BenchResult>,
+}
+
+const MIB_DIVIDER: f64 = 1024.0 * 1024.0;
+
+pub fn throughput(length: usize, elapsed: Duration) -> f64 {
+    (length as f64 / MIB_DIVIDER) / elapsed.as_secs_f64()
+}
+
+pub fn percentile(sorted_samples: &[Duration], percentile: f64) -> Duration {
+    if sorted_samples.is_empty() {
+        return Duration::ZERO;
+    }
+    let rank = ((percentile / 100.0) * (sorted_samples.len() - 1) as f64).round() as usize;
+    sorted_samples[rank.min(sorted_samples.len() - 1)]
+}
+
+fn json_string(value: &str) -> String {
+    let mut escaped = String::with_capacity(value.len() + 2);
+    escaped.push('"');
+    for c in value.chars() {
+        match c {
+            '"' => escaped.push_str("\\\""),
+            '\\' => escaped.push_str("\\\\"),
+            '\n' => escaped.push_str("\\n"),
+            '\r' => escaped.push_str("\\r"),
+            '\t' => escaped.push_str("\\t"),
+            c if (c as u32) < 0x20 => escaped.push_str(&format!("\\u{:04x}", c as u32)),
+            c => escaped.push(c),
+        }
+    }
+    escaped.push('"');
+    escaped
+}
+
+fn csv_field(value: &str) -> String {
+    if value.contains([',', '"', '\n', '\r']) {
+        format!("\"{}\"", value.replace('"', "\"\""))
+    } else {
+        value.to_string()
+    }
+}
+
+impl BenchReport {
+    pub fn to_json(&self) -> String {
+        let results: Vec<String> = self
+            .results
+            .iter()
+            .map(|result| {
+                format!(
+                    "    {{\"group\": {}, \"test\": {}, \"parameter\": {}, \"value\": {:.3}, \"unit\": {}, \"proxy\": {}}}",
+                    json_string(result.group),
+                    json_string(&result.test),
+                    json_string(&result.parameter),
+                    result.value,
+                    json_string(result.unit.as_str()),
+                    result.proxy,
+                )
+            })
+            .collect();
+        format!(
+            "{{\n  \"firmware_version\": {},\n  \"serial\": {},\n  \"timestamp\": {},\n  \"results\": [\n{}\n  ]\n}}\n",
+            json_string(&self.firmware_version),
+            json_string(&self.serial),
+            json_string(&self.timestamp),
+            results.join(",\n"),
+        )
+    }
+
+    pub fn to_csv(&self) -> String {
+        let mut csv = String::from(
+            "timestamp,firmware_version,serial,group,test,parameter,value,unit,proxy\n",
+        );
+        for result in self.results.iter() {
+            csv.push_str(&format!(
+                "{},{},{},{},{},{},{:.3},{},{}\n",
+                csv_field(&self.timestamp),
+                csv_field(&self.firmware_version),
+                csv_field(&self.serial),
+                csv_field(result.group),
+                csv_field(&result.test),
+                csv_field(&result.parameter),
+                result.value,
+                result.unit.as_str(),
+                result.proxy,
+            ));
+        }
+        csv
+    }
+}
@@ -3,11 +3,16 @@ use chrono::Local;
 use colored::Colorize;
 use encoding_rs::EUC_JP;
 use std::{
-    fs::File,
-    io::{stdin, Read, Write},
+    borrow::Cow,
+    fs::{create_dir_all, File},
+    io::{stdin, BufWriter, Read, Write},
     path::PathBuf,
-    sync::mpsc::{channel, Receiver, Sender},
-    thread::spawn,
+    sync::{
+        mpsc::{channel, sync_channel, Receiver, Sender, SyncSender, TrySendError},
+        Arc,
+    },
+    thread::{spawn, JoinHandle},
+    time::{Duration, Instant},
 };
 
 pub enum Encoding {
@@ -15,11 +20,19 @@ pub enum Encoding {
     EUCJP,
 }
 
+pub enum CaptureFormat {
+    PngSequence,
+    RawVideo,
+}
+
 pub struct Handler {
-    header: Option<Vec<u8>>,
+    header: Vec<u8>,
     line_rx: Receiver<String>,
     external_line_tx: Sender<String>,
     encoding: Encoding,
+    frame_writer: Option<FrameWriter>,
+    previous_frame: Option<Arc<Frame>>,
+    capture_stats: Option<CaptureStats>,
 }
 
 enum DataType {
@@ -63,7 +76,7 @@ impl From<DataType> for u32 {
     }
 }
 
-#[derive(Clone, Copy)]
+#[derive(Clone, Copy, PartialEq)]
 enum ScreenshotPixelFormat {
     Rgba16,
     Rgba32,
@@ -93,12 +106,15 @@ struct ScreenshotMetadata {
     format: ScreenshotPixelFormat,
     width: u32,
     height: u32,
+    delta: bool,
 }
 
-impl TryFrom<Vec<u8>> for ScreenshotMetadata {
+const SCREENSHOT_FLAG_DELTA: u32 = 1 << 0;
+
+impl TryFrom<&[u8]> for ScreenshotMetadata {
     type Error = String;
-    fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
-        if value.len() != 16 {
+    fn try_from(value: &[u8]) -> Result<Self, Self::Error> {
+        if value.len() != 16 && value.len() != 20 {
             return Err("Invalid header length for screenshot metadata".into());
         }
         if u32::from_be_bytes(value[0..4].try_into().unwrap()) != DataType::Screenshot.into() {
@@ -107,6 +123,11 @@ impl TryFrom<Vec<u8>> for ScreenshotMetadata {
         let format = u32::from_be_bytes(value[4..8].try_into().unwrap());
         let width = u32::from_be_bytes(value[8..12].try_into().unwrap());
         let height = u32::from_be_bytes(value[12..16].try_into().unwrap());
+        let flags = if value.len() == 20 {
+            u32::from_be_bytes(value[16..20].try_into().unwrap())
+        } else {
+            0
+        };
         if width > 4096 || height > 4096 {
             return Err("Invalid width or height for screenshot metadata".into());
         }
@@ -114,6 +135,7 @@ impl TryFrom<Vec<u8>> for ScreenshotMetadata {
             format: format.try_into()?,
             width,
             height,
+            delta: (flags & SCREENSHOT_FLAG_DELTA) != 0,
         })
     }
 }
@@ -164,6 +186,268 @@ macro_rules! stop {
 
 const MAX_PACKET_LENGTH: usize = 8 * 1024 * 1024;
 const SUPPORTED_USB_PROTOCOL_VERSION: u16 = 2;
+const FRAME_QUEUE_LENGTH: usize = 8;
+const CAPTURE_REPORT_INTERVAL: Duration = Duration::from_secs(5);
+
+#[derive(Clone)]
+struct Frame {
+    format: ScreenshotPixelFormat,
+    width: u32,
+    height: u32,
+    data: sc64::PacketData,
+}
+
+impl Frame {
+    fn matches(&self, metadata: &ScreenshotMetadata) -> bool {
+        self.format == metadata.format
+            && self.width == metadata.width
+            && self.height == metadata.height
+    }
+
+    fn apply_delta(&mut self, delta: &[u8]) -> Result<(), String> {
+        let mut offset = 0;
+        while offset < delta.len() {
+            if (delta.len() - offset) < 8 {
+                return Err("Truncated span header in delta encoded screenshot".into());
+            }
+            let start = u32::from_be_bytes(delta[offset..offset + 4].try_into().unwrap()) as usize;
+            let length =
+                u32::from_be_bytes(delta[offset + 4..offset + 8].try_into().unwrap()) as usize;
+            offset += 8;
+            if start > self.data.len() || length > (delta.len() - offset) {
+                return Err("Span out of bounds in delta encoded screenshot".into());
+            }
+            let end = match start.checked_add(length) {
+                Some(end) if end <= self.data.len() => end,
+                _ => return Err("Span out of bounds in delta encoded screenshot".into()),
+            };
+            self.data[start..end].copy_from_slice(&delta[offset..offset + length]);
+            offset += length;
+        }
+        Ok(())
+    }
+
+    fn rgba32(&self) -> Cow<'_, [u8]> {
+        match self.format {
+            ScreenshotPixelFormat::Rgba16 => {
+                // Branchless per-pixel body so the compiler can vectorize the whole loop
+                let mut pixels = vec![0u8; self.data.len() * 2];
+                for (p, pixel) in self.data.chunks_exact(2).zip(pixels.chunks_exact_mut(4)) {
+                    let value = u16::from_be_bytes([p[0], p[1]]);
+                    pixel[0] = ((value >> 8) & 0xF8) as u8;
+                    pixel[1] = ((value >> 3) & 0xF8) as u8;
+                    pixel[2] = ((value << 2) & 0xF8) as u8;
+                    pixel[3] = 0u8.wrapping_sub((value & 0x01) as u8);
+                }
+                Cow::Owned(pixels)
+            }
+            ScreenshotPixelFormat::Rgba32 => Cow::Borrowed(&self.data),
+        }
+    }
+
+    fn save_png(&self, filename: &str) -> Result<(), String> {
+        let (width, height) = (self.width, self.height);
+        let pixels = self.rgba32();
+        if pixels.len() as u64 != (width as u64 * height as u64 * 4) {
+            return Err("Frame data does not match its dimensions".into());
+        }
+        image::save_buffer(filename, &pixels, width, height, image::ColorType::Rgba8)
+            .map_err(|error| error.to_string())
+    }
+}
+
+enum FrameJob {
+    Screenshot(Arc<Frame>),
+    Capture(Arc<Frame>),
+}
+
+enum CaptureSink {
+    PngSequence {
+        directory: PathBuf,
+        frames: u64,
+    },
+    RawVideo {
+        writer: BufWriter<File>,
+        path: PathBuf,
+        size: Option<(u32, u32)>,
+        frames: u64,
+    },
+}
+
+impl CaptureSink {
+    fn new(path: &PathBuf, format: CaptureFormat) -> Result<Self, String> {
+        Ok(match format {
+            CaptureFormat::PngSequence => {
+                if let Err(error) = create_dir_all(path) {
+                    return Err(format!(
+                        "Couldn't create capture directory [{}]: {error}",
+                        path.to_string_lossy()
+                    ));
+                }
+                Self::PngSequence {
+                    directory: path.clone(),
+                    frames: 0,
+                }
+            }
+            CaptureFormat::RawVideo => match File::create(path) {
+                Ok(file) => Self::RawVideo {
+                    writer: BufWriter::new(file),
+                    path: path.clone(),
+                    size: None,
+                    frames: 0,
+                },
+                Err(error) => {
+                    return Err(format!(
+                        "Couldn't create capture file [{}]: {error}",
+                        path.to_string_lossy()
+                    ))
+                }
+            },
+        })
+    }
+
+    fn write(&mut self, frame: &Frame) -> Result<(), String> {
+        match self {
+            Self::PngSequence { directory, frames } => {
+                let filename = directory.join(format!("frame-{:06}.png", *frames));
+                frame.save_png(&filename.to_string_lossy())?;
+                *frames += 1;
+            }
+            Self::RawVideo {
+                writer,
+                size,
+                frames,
+                ..
+            } => {
+                let frame_size = (frame.width, frame.height);
+                if *size.get_or_insert(frame_size) != frame_size {
+                    return Err("Frame size changed during raw video capture".into());
+                }
+                writer
+                    .write_all(&frame.rgba32())
+                    .map_err(|error| error.to_string())?;
+                *frames += 1;
+            }
+        }
+        Ok(())
+    }
+
+    fn finish(self) {
+        match self {
+            Self::PngSequence { directory, frames } => {
+                success!(
+                    "Wrote [{frames}] frames to [{}]",
+                    directory.to_string_lossy()
+                );
+            }
+            Self::RawVideo {
+                mut writer,
+                path,
+                size,
+                frames,
+            } => {
+                if let Err(error) = writer.flush() {
+                    return error!("Couldn't write capture file: {error}");
+                }
+                let (width, height) = size.unwrap_or_default();
+                success!(
+                    "Wrote [{frames}] {width}x{height} RGBA frames to [{}]",
+                    path.to_string_lossy()
+                );
+            }
+        }
+    }
+}
+
+struct FrameWriter {
+    job_tx: Option<SyncSender<FrameJob>>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl FrameWriter {
+    fn new(sink: Option<CaptureSink>) -> Self {
+        let (job_tx, job_rx) = sync_channel::<FrameJob>(FRAME_QUEUE_LENGTH);
+        let thread = spawn(move || frame_writer_thread(job_rx, sink));
+        FrameWriter {
+            job_tx: Some(job_tx),
+            thread: Some(thread),
+        }
+    }
+
+    fn screenshot(&self, frame: Arc<Frame>) {
+        if let Some(job_tx) = &self.job_tx {
+            job_tx.send(FrameJob::Screenshot(frame)).ok();
+        }
+    }
+
+    fn capture(&self, frame: Arc<Frame>) -> bool {
+        match &self.job_tx {
+            Some(job_tx) => match job_tx.try_send(FrameJob::Capture(frame)) {
+                Ok(()) => true,
+                Err(TrySendError::Full(_)) | Err(TrySendError::Disconnected(_)) => false,
+            },
+            None => false,
+        }
+    }
+}
+
+impl Drop for FrameWriter {
+    fn drop(&mut self) {
+        drop(self.job_tx.take());
+        if let Some(thread) = self.thread.take() {
+            thread.join().ok();
+        }
+    }
+}
+
+struct CaptureStats {
+    started: Instant,
+    window_started: Instant,
+    window_frames: u64,
+    frames: u64,
+    dropped: u64,
+    copied: u64,
+}
+
+impl CaptureStats {
+    fn new() -> Self {
+        let now = Instant::now();
+        CaptureStats {
+            started: now,
+            window_started: now,
+            window_frames: 0,
+            frames: 0,
+            dropped: 0,
+            copied: 0,
+        }
+    }
+
+    fn record(&mut self, accepted: bool) {
+        if accepted {
+            self.frames += 1;
+            self.window_frames += 1;
+        } else {
+            self.dropped += 1;
+        }
+        let elapsed = self.window_started.elapsed();
+        if elapsed >= CAPTURE_REPORT_INTERVAL {
+            self.report(self.window_frames, elapsed);
+            self.window_started = Instant::now();
+            self.window_frames = 0;
+        }
+    }
+
+    fn report(&self, frames: u64, elapsed: Duration) {
+        println!(
+            "{}: {} frames, {:.1} fps, {} dropped, {} copied for delta",
+            "[Capture]".bold(),
+            self.frames,
+            frames as f64 / elapsed.as_secs_f64(),
+            self.dropped,
+            self.copied
+        );
+    }
+}
 
 impl Handler {
     pub fn new() -> Self {
@@ -173,10 +457,13 @@ impl Handler {
         spawn(move || stdin_thread(line_tx));
 
         Handler {
-            header: None,
+            header: Vec::new(),
             line_rx,
             external_line_tx,
             encoding: Encoding::UTF8,
+            frame_writer: None,
+            previous_frame: None,
+            capture_stats: None,
         }
     }
 
@@ -184,6 +471,13 @@ impl Handler {
         self.encoding = encoding;
     }
 
+    pub fn set_capture(&mut self, path: &PathBuf, format: CaptureFormat) -> Result<(), String> {
+        let sink = CaptureSink::new(path, format)?;
+        self.frame_writer = Some(FrameWriter::new(Some(sink)));
+        self.capture_stats = Some(CaptureStats::new());
+        Ok(())
+    }
+
     pub fn send_external_input(&self, input: &str) {
         self.external_line_tx.send(input.to_string()).unwrap();
     }
@@ -215,7 +509,7 @@ impl Handler {
             sc64::DebugPacket {
                 datatype: DataType::RawBinary.into(),
                 data: match load_file(line.trim_matches('@')) {
-                    Ok(data) => data,
+                    Ok(data) => data.into(),
                     Err(error) => return stop!(None, "{error}"),
                 },
             }
@@ -251,7 +545,7 @@ impl Handler {
             data.append(&mut b"\0".to_vec());
             sc64::DebugPacket {
                 datatype: DataType::Text.into(),
-                data,
+                data: data.into(),
             }
         };
 
@@ -267,16 +561,18 @@ impl Handler {
         Some(UserInput::Packet(packet))
     }
 
-    pub fn handle_debug_packet(&mut self, debug_packet: sc64::DebugPacket) {
+    /// Returns the packet buffer for recycling, full screenshot frames keep it instead
+    pub fn handle_debug_packet(&mut self, debug_packet: sc64::DebugPacket) -> Option<Vec<u8>> {
         let sc64::DebugPacket { datatype, data } = debug_packet;
         match datatype.into() {
             DataType::Text => self.handle_datatype_text(&data),
             DataType::RawBinary => self.handle_datatype_raw_binary(&data),
             DataType::Header => self.handle_datatype_header(&data),
-            DataType::Screenshot => self.handle_datatype_screenshot(&data),
+            DataType::Screenshot => return self.handle_datatype_screenshot(data),
             DataType::Heartbeat => self.handle_datatype_heartbeat(&data),
             _ => error!("Received unknown debug packet datatype: 0x{datatype:02X}"),
         }
+        Some(data.into_buffer())
     }
 
     pub fn handle_is_viewer_64(&self, data: &[u8]) {
@@ -285,7 +581,7 @@ impl Handler {
 
     pub fn handle_save_writeback(
         &self,
-        save_writeback: sc64::SaveWriteback,
+        save_writeback: &sc64::SaveWriteback,
         path: &Option<PathBuf>,
     ) {
         let filename = &if let Some(path) = path {
@@ -328,46 +624,72 @@ impl Handler {
     }
 
     fn handle_datatype_header(&mut self, data: &[u8]) {
-        self.header = Some(data.to_vec());
+        self.header.clear();
+        self.header.extend_from_slice(data);
     }
 
-    fn handle_datatype_screenshot(&mut self, data: &[u8]) {
-        let header = match self.header.take() {
-            Some(header) => header,
-            None => return error!("Got screenshot packet without header data"),
-        };
-        let ScreenshotMetadata {
-            format,
-            height,
-            width,
-        } = match header.try_into() {
+    fn handle_datatype_screenshot(&mut self, data: sc64::PacketData) -> Option<Vec<u8>> {
+        if self.header.is_empty() {
+            error!("Got screenshot packet without header data");
+            return Some(data.into_buffer());
+        }
+        let metadata = ScreenshotMetadata::try_from(self.header.as_slice());
+        self.header.clear();
+        let metadata = match metadata {
             Ok(data) => data,
-            Err(error) => return error!("{error}"),
+            Err(error) => {
+                error!("{error}");
+                return Some(data.into_buffer());
+            }
+        };
+        let (frame, buffer) = if metadata.delta {
+            (
+                self.decode_delta_frame(&metadata, &data),
+                Some(data.into_buffer()),
+            )
+        } else {
+            (decode_full_frame(&metadata, data), None)
         };
-        let format_size: u32 = format.into();
-        if data.len() as u32 != format_size * width * height {
-            return error!("Data length did not match header data for screenshot datatype");
-        }
-        let mut image = image::RgbaImage::new(width, height);
-        for (x, y, pixel) in image.enumerate_pixels_mut() {
-            let location = ((x + (y * width)) * format_size) as usize;
-            let p = &data[location..location + format_size as usize];
-            pixel.0 = match format {
-                ScreenshotPixelFormat::Rgba16 => {
-                    let r = ((p[0] >> 3) & 0x1F) << 3;
-                    let g = (((p[0] & 0x07) << 2) | ((p[1] >> 6) & 0x03)) << 3;
-                    let b = ((p[1] >> 1) & 0x1F) << 3;
-                    let a = ((p[1]) & 0x01) * 255;
-                    [r, g, b, a]
+        let frame = match frame {
+            Ok(frame) => frame,
+            Err(error) => {
+                if let Some(capture_stats) = &mut self.capture_stats {
+                    capture_stats.record(false);
                 }
-                ScreenshotPixelFormat::Rgba32 => [p[0], p[1], p[2], p[3]],
+                error!("{error}");
+                return buffer;
             }
+        };
+        self.previous_frame = Some(frame.clone());
+        let frame_writer = self
+            .frame_writer
+            .get_or_insert_with(|| FrameWriter::new(None));
+        if let Some(capture_stats) = &mut self.capture_stats {
+            capture_stats.record(frame_writer.capture(frame));
+        } else {
+            frame_writer.screenshot(frame);
         }
-        let filename = &generate_filename("screenshot", "png");
-        if let Some(error) = image.save(filename).err() {
-            return error!("Couldn't save screenshot [{filename}]: {error}");
+        buffer
+    }
+
+    fn decode_delta_frame(
+        &mut self,
+        metadata: &ScreenshotMetadata,
+        data: &[u8],
+    ) -> Result<Arc<Frame>, String> {
+        let mut frame = match self.previous_frame.take() {
+            Some(frame) if frame.matches(metadata) => frame,
+            _ => return Err("Got delta encoded screenshot without matching previous frame".into()),
+        };
+        // Previous frame is copied only when the frame writer hasn't released it yet
+        if Arc::get_mut(&mut frame).is_none() {
+            frame = Arc::new(Frame::clone(&frame));
+            if let Some(capture_stats) = &mut self.capture_stats {
+                capture_stats.copied += 1;
+            }
         }
-        success!("Wrote {width}x{height} pixels to [{filename}]");
+        Arc::get_mut(&mut frame).unwrap().apply_delta(data)?;
+        Ok(frame)
     }
 
     fn handle_datatype_heartbeat(&mut self, data: &[u8]) {
@@ -417,6 +739,57 @@ fn load_file(path: &str) -> Result<Vec<u8>, String> {
     }
 }
 
+impl Drop for Handler {
+    fn drop(&mut self) {
+        if let Some(capture_stats) = &self.capture_stats {
+            capture_stats.report(capture_stats.frames, capture_stats.started.elapsed());
+        }
+    }
+}
+
+fn decode_full_frame(
+    metadata: &ScreenshotMetadata,
+    data: sc64::PacketData,
+) -> Result<Arc<Frame>, String> {
+    let format_size: u32 = metadata.format.into();
+    if data.len() as u32 != format_size * metadata.width * metadata.height {
+        return Err("Data length did not match header data for screenshot datatype".into());
+    }
+    Ok(Arc::new(Frame {
+        format: metadata.format,
+        width: metadata.width,
+        height: metadata.height,
+        data,
+    }))
+}
+
+fn frame_writer_thread(job_rx: Receiver<FrameJob>, mut sink: Option<CaptureSink>) {
+    for job in job_rx.iter() {
+        match job {
+            FrameJob::Screenshot(frame) => {
+                let (width, height) = (frame.width, frame.height);
+                let filename = &generate_filename("screenshot", "png");
+                match frame.save_png(filename) {
+                    Ok(()) => {
+                        success!("Wrote {width}x{height} pixels to [{filename}]");
+                    }
+                    Err(error) => error!("Couldn't save screenshot [{filename}]: {error}"),
+                }
+            }
+            FrameJob::Capture(frame) => {
+                if let Some(sink) = &mut sink {
+                    if let Err(error) = sink.write(&frame) {
+                        error!("Couldn't write captured frame: {error}");
+                    }
+                }
+            }
+        }
+    }
+    if let Some(sink) = sink {
+        sink.finish();
+    }
+}
+
 fn generate_filename(prefix: &str, extension: &str) -> String {
     format!(
         "{prefix}-{}.{extension}",
@@ -434,3 +807,48 @@ fn stdin_thread(line_tx: Sender<String>) {
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::{Frame, ScreenshotPixelFormat};
+
+    fn frame() -> Frame {
+        Frame {
+            format: ScreenshotPixelFormat::Rgba16,
+            width: 4,
+            height: 2,
+            data: vec![0; 16].into(),
+        }
+    }
+
+    fn span(start: u32, data: &[u8]) -> Vec<u8> {
+        let mut span = start.to_be_bytes().to_vec();
+        span.extend((data.len() as u32).to_be_bytes());
+        span.extend(data);
+        span
+    }
+
+    #[test]
+    fn apply_delta_spans() {
+        let mut frame = frame();
+        let mut delta = span(2, &[1, 2]);
+        delta.extend(span(14, &[3, 4]));
+        frame.apply_delta(&delta).unwrap();
+        assert_eq!(frame.data[0..4], [0, 0, 1, 2]);
+        assert_eq!(frame.data[14..16], [3, 4]);
+        frame.apply_delta(&span(16, &[])).unwrap();
+    }
+
+    #[test]
+    fn apply_delta_out_of_bounds() {
+        let mut frame = frame();
+        assert!(frame.apply_delta(&span(17, &[])).is_err());
+        assert!(frame.apply_delta(&span(15, &[1, 2])).is_err());
+        assert!(frame.apply_delta(&span(0, &[1, 2])[..9]).is_err());
+        assert!(frame.apply_delta(&span(0, &[1])[..7]).is_err());
+        let mut delta = 8u32.to_be_bytes().to_vec();
+        delta.extend(u32::MAX.to_be_bytes());
+        assert!(frame.apply_delta(&delta).is_err());
+        assert_eq!(*frame.data, [0; 16]);
+    }
+}
@@ -0,0 +1,193 @@
+use crate::sc64;
+use std::{
+    fs::{read_to_string, remove_file, rename, File},
+    io::{Seek, SeekFrom, Write},
+    path::{Path, PathBuf},
+    sync::mpsc::{sync_channel, Receiver, SyncSender},
+    thread::{spawn, JoinHandle},
+};
+
+const NAMED_RANGES: [(&str, u32, usize); 3] = [
+    ("sdram", 0x0000_0000, 64 * 1024 * 1024),
+    ("flash", 0x0400_0000, 16 * 1024 * 1024),
+    ("bram", 0x0500_0000, sc64::MEMORY_LENGTH - 0x0500_0000),
+];
+
+const CHUNK_QUEUE_LENGTH: usize = 4;
+
+pub fn parse_range(value: &str) -> Result<(u32, usize), String> {
+    if let Some((_, address, length)) = NAMED_RANGES
+        .iter()
+        .find(|(name, _, _)| name.eq_ignore_ascii_case(value))
+    {
+        return Ok((*address, *length));
+    }
+    let (address, length) = match value.split_once(':') {
+        Some(range) => range,
+        None => {
+            return Err(format!(
+                "Invalid range [{value}], expected <address>:<length> or one of: sdram, flash, bram"
+            ))
+        }
+    };
+    let address = clap_num::maybe_hex::<u32>(address)?;
+    let length = clap_num::maybe_hex::<usize>(length)?;
+    if length == 0 || (address as usize + length) > sc64::MEMORY_LENGTH {
+        return Err(format!("Range [{value}] exceeds SC64 memory space"));
+    }
+    Ok((address, length))
+}
+
+pub struct DumpRange {
+    pub address: u32,
+    pub length: usize,
+    pub file_offset: u64,
+    pub completed: usize,
+}
+
+impl DumpRange {
+    pub fn remaining(&self) -> (u32, usize) {
+        (
+            self.address + self.completed as u32,
+            self.length - self.completed,
+        )
+    }
+}
+
+pub struct DumpChunk {
+    pub range: usize,
+    pub data: Vec<u8>,
+}
+
+pub struct DumpProgress {
+    path: PathBuf,
+    pub ranges: Vec<DumpRange>,
+}
+
+impl DumpProgress {
+    pub fn new(dump_path: &Path, ranges: &[(u32, usize)], sparse: bool) -> Self {
+        let mut path = dump_path.as_os_str().to_owned();
+        path.push(".progress");
+        let mut file_offset = 0;
+        let ranges = ranges
+            .iter()
+            .map(|&(address, length)| {
+                let range = DumpRange {
+                    address,
+                    length,
+                    file_offset: if sparse { address as u64 } else { file_offset },
+                    completed: 0,
+                };
+                file_offset += length as u64;
+                range
+            })
+            .collect();
+        DumpProgress {
+            path: path.into(),
+            ranges,
+        }
+    }
+
+    pub fn file_length(&self) -> u64 {
+        self.ranges
+            .iter()
+            .map(|range| range.file_offset + range.length as u64)
+            .max()
+            .unwrap_or(0)
+    }
+
+    pub fn total(&self) -> usize {
+        self.ranges.iter().map(|range| range.length).sum()
+    }
+
+    pub fn completed(&self) -> usize {
+        self.ranges.iter().map(|range| range.completed).sum()
+    }
+
+    pub fn resume(&mut self) -> Result<(), String> {
+        let contents = read_to_string(&self.path).map_err(|error| {
+            format!(
+                "Couldn't read dump progress file [{}]: {error}",
+                self.path.to_string_lossy()
+            )
+        })?;
+        let mut saved: Vec<[u64; 4]> = Vec::new();
+        for line in contents.lines() {
+            let fields = line
+                .split_whitespace()
+                .map(|field| u64::from_str_radix(field.trim_start_matches("0x"), 16))
+                .collect::<Result<Vec<u64>, _>>()
+                .map_err(|_| "Invalid dump progress file contents".to_string())?;
+            saved.push(
+                fields
+                    .try_into()
+                    .map_err(|_| "Invalid dump progress file contents".to_string())?,
+            );
+        }
+        if saved.len() != self.ranges.len()
+            || self.ranges.iter().zip(saved.iter()).any(|(range, fields)| {
+                fields[0] != range.address as u64
+                    || fields[1] != range.length as u64
+                    || fields[2] != range.file_offset
+            })
+        {
+            return Err("Dump progress file doesn't match requested ranges".into());
+        }
+        for (range, fields) in self.ranges.iter_mut().zip(saved.iter()) {
+            range.completed = (fields[3] as usize).min(range.length);
+        }
+        Ok(())
+    }
+
+    fn save(&self) -> std::io::Result<()> {
+        let mut temporary_path = self.path.clone().into_os_string();
+        temporary_path.push(".tmp");
+        let mut file = File::create(&temporary_path)?;
+        for range in self.ranges.iter() {
+            writeln!(
+                file,
+                "0x{:08X} 0x{:X} 0x{:X} 0x{:X}",
+                range.address, range.length, range.file_offset, range.completed
+            )?;
+        }
+        drop(file);
+        rename(&temporary_path, &self.path)
+    }
+
+    pub fn remove(&self) {
+        remove_file(&self.path).ok();
+    }
+}
+
+pub fn spawn_writer(
+    file: File,
+    progress: DumpProgress,
+) -> (
+    SyncSender<DumpChunk>,
+    JoinHandle<(DumpProgress, std::io::Result<()>)>,
+) {
+    let (chunk_tx, chunk_rx) = sync_channel::<DumpChunk>(CHUNK_QUEUE_LENGTH);
+    let thread = spawn(move || {
+        let mut file = file;
+        let mut progress = progress;
+        let result = write_chunks(&mut file, &mut progress, chunk_rx);
+        (progress, result)
+    });
+    (chunk_tx, thread)
+}
+
+fn write_chunks(
+    file: &mut File,
+    progress: &mut DumpProgress,
+    chunk_rx: Receiver<DumpChunk>,
+) -> std::io::Result<()> {
+    progress.save()?;
+    for chunk in chunk_rx.iter() {
+        let range = &mut progress.ranges[chunk.range];
+        file.seek(SeekFrom::Start(range.file_offset + range.completed as u64))?;
+        file.write_all(&chunk.data)?;
+        range.completed += chunk.data.len();
+        progress.save()?;
+    }
+    Ok(())
+}
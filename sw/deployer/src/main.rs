@@ -1,5 +1,8 @@
+mod bench;
 mod debug;
 mod disk;
+mod dump;
+mod monitor;
 mod n64;
 mod sc64;
 
@@ -9,7 +12,7 @@ use clap_num::{maybe_hex, maybe_hex_range};
 use colored::Colorize;
 use panic_message::panic_message;
 use std::{
-    fs::File,
+    fs::{File, OpenOptions},
     io::{stdin, stdout, Read, Write},
     panic,
     path::PathBuf,
@@ -18,6 +21,7 @@ use std::{
         atomic::{AtomicBool, Ordering},
         Arc,
     },
+    time::{Duration, Instant},
 };
 
 #[derive(Parser)]
@@ -26,7 +30,7 @@ struct Cli {
     #[command(subcommand)]
     command: Commands,
 
-    /// Connect to SC64 device on provided local port
+    /// Connect to SC64 device on provided local port (use "emu://[option=value,...]" for emulated device)
     #[arg(short, long)]
     port: Option<String>,
 
@@ -58,6 +62,9 @@ enum Commands {
     /// Dump data from arbitrary location in SC64 memory space
     Dump(DumpArgs),
 
+    /// Display live SC64 telemetry and export it as Prometheus metrics
+    Monitor(MonitorArgs),
+
     /// Perform operations on the SD card
     SD {
         #[command(subcommand)]
@@ -85,6 +92,9 @@ enum Commands {
     /// Test SC64 hardware
     Test,
 
+    /// Benchmark SC64 performance and print machine-readable results
+    Bench(BenchArgs),
+
     /// Expose SC64 device over network
     Server(ServerArgs),
 }
@@ -170,6 +180,10 @@ struct _64DDArgs {
     /// Force CIC seed
     #[arg(long, value_parser = |s: &str| maybe_hex::<u8>(s))]
     cic_seed: Option<u8>,
+
+    /// Print USB packet buffer statistics on exit
+    #[arg(short, long)]
+    verbose: bool,
 }
 
 #[derive(Args)]
@@ -193,6 +207,18 @@ struct DebugArgs {
     /// List of commands to send after connecting to the SC64, semicolon separated (;)
     #[arg(long)]
     init: Option<String>,
+
+    /// Record incoming screenshot frames continuously to a directory (PNG) or a file (raw RGBA)
+    #[arg(long, value_name = "path")]
+    capture: Option<PathBuf>,
+
+    /// Output format for the continuous frame capture
+    #[arg(long, default_value = "png", requires = "capture")]
+    capture_format: CaptureFormat,
+
+    /// Print USB packet buffer statistics on exit
+    #[arg(short, long)]
+    verbose: bool,
 }
 
 #[derive(Args)]
@@ -207,6 +233,33 @@ struct DumpArgs {
 
     /// Path to the dump file
     path: PathBuf,
+
+    /// Additional range to dump as <address>:<length> or one of: sdram, flash, bram (can be specified multiple times)
+    #[arg(long = "range", value_name = "range", value_parser = dump::parse_range)]
+    ranges: Vec<(u32, usize)>,
+
+    /// Place each range at the file offset equal to its memory address (gaps are left sparse)
+    #[arg(long)]
+    sparse: bool,
+
+    /// Continue an interrupted dump from the last completed chunk
+    #[arg(long)]
+    resume: bool,
+}
+
+#[derive(Args)]
+struct MonitorArgs {
+    /// Telemetry report period in milliseconds
+    #[arg(short, long, default_value = "1000", value_parser = |s: &str| maybe_hex_range::<u32>(s, 100, 60000))]
+    interval: u32,
+
+    /// Write Prometheus text format metrics to a file after each report
+    #[arg(long, value_name = "path")]
+    prometheus_file: Option<PathBuf>,
+
+    /// Serve Prometheus text format metrics over HTTP on provided port
+    #[arg(long, value_name = "port")]
+    prometheus_port: Option<u16>,
 }
 
 #[derive(Subcommand)]
@@ -314,6 +367,83 @@ struct FirmwareUpdateArgs {
     use_flash_memory: bool,
 }
 
+#[derive(Args)]
+struct BenchArgs {
+    /// Output format
+    #[arg(short, long, default_value = "json")]
+    format: BenchFormat,
+
+    /// Path to the output file (results are printed to stdout if not provided)
+    #[arg(short, long)]
+    output: Option<PathBuf>,
+
+    /// USB transfer chunk sizes in kiB (comma separated)
+    #[arg(long, value_delimiter = ',', default_values_t = [4, 64, 1024, 8192])]
+    usb_chunks: Vec<usize>,
+
+    /// Total USB transfer length per measurement in MiB
+    #[arg(long, default_value_t = 16, value_parser = |s: &str| maybe_hex_range::<usize>(s, 1, 64))]
+    usb_length: usize,
+
+    /// Number of command round-trip samples
+    #[arg(long, default_value_t = 1000)]
+    latency_samples: usize,
+
+    /// SD card request sizes in sectors (comma separated)
+    #[arg(long, value_delimiter = ',', default_values_t = [1, 8, 64, 256])]
+    sd_requests: Vec<u32>,
+
+    /// Total SD card length per sequential measurement in MiB
+    #[arg(long, default_value_t = 4)]
+    sd_length: usize,
+
+    /// Number of random SD card requests per request size
+    #[arg(long, default_value_t = 64)]
+    sd_random_samples: usize,
+
+    /// Measure SD card write speed (sectors are read first and then written back unchanged)
+    #[arg(long)]
+    sd_write: bool,
+
+    /// Measure flash erase and program speed (overwrites last block of extended ROM area)
+    #[arg(long)]
+    flash: bool,
+
+    /// Number of 64DD block upload and save read samples (host side proxies for block service
+    /// and save writeback latency)
+    #[arg(long, default_value_t = 100)]
+    transfer_samples: usize,
+
+    /// Skip USB and command latency measurements
+    #[arg(long)]
+    skip_usb: bool,
+
+    /// Skip SD card measurements
+    #[arg(long)]
+    skip_sd: bool,
+}
+
+#[derive(Clone, ValueEnum)]
+enum BenchFormat {
+    Json,
+    Csv,
+}
+
+#[derive(Clone, ValueEnum)]
+enum CaptureFormat {
+    Png,
+    Raw,
+}
+
+impl From<CaptureFormat> for debug::CaptureFormat {
+    fn from(value: CaptureFormat) -> Self {
+        match value {
+            CaptureFormat::Png => Self::PngSequence,
+            CaptureFormat::Raw => Self::RawVideo,
+        }
+    }
+}
+
 #[derive(Args)]
 struct ServerArgs {
     /// Listen on provided address:port
@@ -415,12 +545,14 @@ fn handle_command(command: &Commands, port: Option<String>, remote: Option<Strin
         Commands::_64DD(args) => handle_64dd_command(connection, args),
         Commands::Debug(args) => handle_debug_command(connection, args),
         Commands::Dump(args) => handle_dump_command(connection, args),
+        Commands::Monitor(args) => handle_monitor_command(connection, args),
         Commands::SD { command } => handle_sd_command(connection, command),
         Commands::Info => handle_info_command(connection),
         Commands::Reset => handle_reset_command(connection),
         Commands::Set { command } => handle_set_command(connection, command),
         Commands::Firmware { command } => handle_firmware_command(connection, command),
         Commands::Test => handle_test_command(connection),
+        Commands::Bench(args) => handle_bench_command(connection, args),
         Commands::Server(args) => handle_server_command(connection, args),
     };
     match result {
@@ -460,9 +592,12 @@ fn handle_upload_command(connection: Connection, args: &UploadArgs) -> Result<()
 
     let (mut rom_file, rom_name, rom_length) = open_file(&args.rom)?;
 
-    log_wait(format!("Uploading ROM [{rom_name}]"), || {
+    let flash_stats = log_wait(format!("Uploading ROM [{rom_name}]"), || {
         sc64.upload_rom(&mut rom_file, rom_length, args.no_shadow)
     })?;
+    if flash_stats.blocks > 0 {
+        println!("Flash memory: {flash_stats}");
+    }
 
     let save: SaveType = if let Some(save_type) = args.save_type.clone() {
         save_type
@@ -560,9 +695,12 @@ fn handle_64dd_command(connection: Connection, args: &_64DDArgs) -> Result<(), s
         if rom_length > MAX_ROM_LENGTH {
             return Err(sc64::Error::new("ROM file size too big for 64DD mode"));
         }
-        log_wait(format!("Uploading ROM [{rom_name}]"), || {
+        let flash_stats = log_wait(format!("Uploading ROM [{rom_name}]"), || {
             sc64.upload_rom(&mut rom_file, rom_length, false)
         })?;
+        if flash_stats.blocks > 0 {
+            println!("Flash memory: {flash_stats}");
+        }
 
         let save: SaveType = if let Some(save_type) = args.save_type.clone() {
             save_type
@@ -733,10 +871,13 @@ fn handle_64dd_command(connection: Connection, args: &_64DDArgs) -> Result<(), s
                     }
                 }
                 sc64::DataPacket::DebugData(debug_packet) => {
-                    debug_handler.handle_debug_packet(debug_packet);
+                    if let Some(buffer) = debug_handler.handle_debug_packet(debug_packet) {
+                        sc64.recycle_buffer(buffer);
+                    }
                 }
                 sc64::DataPacket::SaveWriteback(save_writeback) => {
-                    debug_handler.handle_save_writeback(save_writeback, &args.save);
+                    debug_handler.handle_save_writeback(&save_writeback, &args.save);
+                    sc64.recycle_buffer(save_writeback.data.into_buffer());
                 }
                 sc64::DataPacket::DataFlushed => {
                     debug_handler.handle_data_flushed();
@@ -751,6 +892,10 @@ fn handle_64dd_command(connection: Connection, args: &_64DDArgs) -> Result<(), s
         }
     }
 
+    if args.verbose {
+        println!("{}: {}", "[64DD]".bold(), sc64.packet_buffer_stats());
+    }
+
     sc64.reset_state()?;
 
     Ok(())
@@ -778,6 +923,16 @@ fn handle_debug_command(connection: Connection, args: &DebugArgs) -> Result<(),
     if !args.no_writeback {
         sc64.set_save_writeback(true)?;
     }
+    if let Some(path) = &args.capture {
+        debug_handler
+            .set_capture(path, args.capture_format.clone().into())
+            .map_err(|error| sc64::Error::new(&error))?;
+        println!(
+            "{}: Recording frames to [{}]",
+            "[Capture]".bold(),
+            path.to_string_lossy().bright_blue()
+        );
+    }
 
     println!("{}: Started", "[Debug]".bold());
 
@@ -793,13 +948,17 @@ fn handle_debug_command(connection: Connection, args: &DebugArgs) -> Result<(),
         if let Some(data_packet) = sc64.receive_data_packet()? {
             match data_packet {
                 sc64::DataPacket::DebugData(debug_packet) => {
-                    debug_handler.handle_debug_packet(debug_packet);
+                    if let Some(buffer) = debug_handler.handle_debug_packet(debug_packet) {
+                        sc64.recycle_buffer(buffer);
+                    }
                 }
                 sc64::DataPacket::IsViewer64(message) => {
                     debug_handler.handle_is_viewer_64(&message);
+                    sc64.recycle_buffer(message);
                 }
                 sc64::DataPacket::SaveWriteback(save_writeback) => {
-                    debug_handler.handle_save_writeback(save_writeback, &args.save);
+                    debug_handler.handle_save_writeback(&save_writeback, &args.save);
+                    sc64.recycle_buffer(save_writeback.data.into_buffer());
                 }
                 sc64::DataPacket::DataFlushed => {
                     debug_handler.handle_data_flushed();
@@ -822,6 +981,10 @@ fn handle_debug_command(connection: Connection, args: &DebugArgs) -> Result<(),
         println!("{}: Stopped listening", "[IS-Viewer 64]".bold());
     }
 
+    if args.verbose {
+        println!("{}: {}", "[Debug]".bold(), sc64.packet_buffer_stats());
+    }
+
     println!("{}: Stopped", "[Debug]".bold());
 
     Ok(())
@@ -830,15 +993,146 @@ fn handle_debug_command(connection: Connection, args: &DebugArgs) -> Result<(),
 fn handle_dump_command(connection: Connection, args: &DumpArgs) -> Result<(), sc64::Error> {
     let mut sc64 = init_sc64(connection, true)?;
 
-    let (mut dump_file, dump_name) = create_file(&args.path)?;
+    let mut ranges = vec![(args.address, args.length)];
+    ranges.extend(args.ranges.iter().copied());
+    if ranges
+        .iter()
+        .any(|&(address, length)| (address as usize + length) > sc64::MEMORY_LENGTH)
+    {
+        return Err(sc64::Error::new("Invalid dump address or length"));
+    }
+
+    let mut progress = dump::DumpProgress::new(&args.path, &ranges, args.sparse);
+    if args.resume {
+        progress
+            .resume()
+            .map_err(|error| sc64::Error::new(&error))?;
+    }
+    let total_length = progress.total();
+    let resumed_length = progress.completed();
+    let pending: Vec<(usize, u32, usize)> = progress
+        .ranges
+        .iter()
+        .enumerate()
+        .filter(|(_, range)| range.completed < range.length)
+        .map(|(index, range)| {
+            let (address, length) = range.remaining();
+            (index, address, length)
+        })
+        .collect();
+
+    let dump_name = args.path.file_name().unwrap().to_string_lossy().to_string();
+    let dump_file = OpenOptions::new()
+        .write(true)
+        .create(!args.resume)
+        .truncate(!args.resume)
+        .open(&args.path)?;
+    dump_file.set_len(progress.file_length())?;
 
-    log_wait(
+    if resumed_length > 0 {
+        println!(
+            "Resuming dump, [0x{resumed_length:X}] of [0x{total_length:X}] bytes already done"
+        );
+    }
+
+    let (chunk_tx, writer) = dump::spawn_writer(dump_file, progress);
+
+    let start = Instant::now();
+    let dump_result = log_wait(
         format!(
-            "Dumping from [0x{:08X}] length [0x{:X}] to [{dump_name}]",
-            args.address, args.length
+            "Dumping [{}] range(s) [0x{:X}] bytes to [{dump_name}]",
+            ranges.len(),
+            total_length - resumed_length
         ),
-        || sc64.dump_memory(&mut dump_file, args.address, args.length),
-    )?;
+        || -> Result<(), sc64::Error> {
+            for &(index, address, length) in pending.iter() {
+                sc64.dump_memory(address, length, &mut |data| {
+                    chunk_tx
+                        .send(dump::DumpChunk { range: index, data })
+                        .map_err(|_| sc64::Error::new("Dump file writer stopped"))
+                })?;
+            }
+            Ok(())
+        },
+    );
+    drop(chunk_tx);
+    let (progress, write_result) = writer.join().unwrap();
+    let elapsed = start.elapsed();
+
+    if dump_result.is_err() || write_result.is_err() {
+        println!(
+            "{}",
+            format!(
+                "Dump interrupted after [0x{:X}] of [0x{:X}] bytes, run again with --resume to continue",
+                progress.completed(),
+                total_length
+            )
+            .bright_yellow()
+        );
+        dump_result?;
+        write_result?;
+    }
+
+    progress.remove();
+
+    let dumped_length = (total_length - resumed_length) as f64 / (1024.0 * 1024.0);
+    println!(
+        "Dumped [{dumped_length:.2} MiB] in [{:.2} s] ({:.2} MiB/s)",
+        elapsed.as_secs_f64(),
+        dumped_length / elapsed.as_secs_f64()
+    );
+
+    Ok(())
+}
+
+fn handle_monitor_command(connection: Connection, args: &MonitorArgs) -> Result<(), sc64::Error> {
+    let mut sc64 = init_sc64(connection, true)?;
+
+    let exporter =
+        monitor::PrometheusExporter::new(args.prometheus_file.clone(), args.prometheus_port)
+            .map_err(|error| {
+                sc64::Error::new(format!("Couldn't start Prometheus exporter: {error}").as_str())
+            })?;
+    if let Some(path) = &args.prometheus_file {
+        println!(
+            "{}: Writing metrics to [{}]",
+            "[Prometheus]".bold(),
+            path.to_string_lossy().bright_blue()
+        );
+    }
+    if let Some(port) = args.prometheus_port {
+        println!(
+            "{}: Serving metrics on port [{}]",
+            "[Prometheus]".bold(),
+            port.to_string().bright_blue()
+        );
+    }
+
+    sc64.set_telemetry_period(Some(Duration::from_millis(args.interval as u64)))?;
+
+    println!("{}: Started", "[Monitor]".bold());
+
+    let mut monitor = monitor::Monitor::new();
+
+    let exit = setup_exit_flag();
+    while !exit.load(Ordering::Relaxed) {
+        if let Some(sc64::DataPacket::Telemetry(telemetry)) = sc64.receive_data_packet()? {
+            if let Some(summary) = monitor.update(telemetry) {
+                println!("{}: {}", "[Monitor]".bold(), summary);
+            }
+            if let Err(error) = exporter.publish(monitor.render_prometheus()) {
+                println!(
+                    "{}: Couldn't write metrics: {}",
+                    "[Prometheus]".bold(),
+                    error.to_string().bright_red()
+                );
+            }
+        }
+    }
+
+    sc64.set_telemetry_period(None)?;
+
+    println!("{}: Stopped", "[Monitor]".bold());
 
     Ok(())
 }
@@ -1022,12 +1316,18 @@ fn handle_info_command(connection: Connection) -> Result<(), sc64::Error> {
     println!(" IS-Viewer 64:      {}", state.isviewer);
     println!(" SD card status:    {}", state.sd_card_status);
     println!("{}", "SummerCart64 diagnostic information:".bold());
+    if let Ok(stats) = sc64.get_sd_card_stats() {
+        println!(" SD card errors:    {stats}");
+    }
     println!(" PI I/O access:     {}", state.fpga_debug_data.pi_io_access);
     println!(
         " PI FIFO flags:     {}",
         state.fpga_debug_data.pi_fifo_flags
     );
     println!(" Current CIC step:  {}", state.fpga_debug_data.cic_step);
+    if let Some(cic_margins) = &state.fpga_debug_data.cic_margins {
+        println!(" CIC timing margin: {cic_margins}");
+    }
     println!(" Diagnostic data:   {}", state.diagnostic_data);
 
     Ok(())
@@ -1138,10 +1438,16 @@ fn handle_firmware_command(
                 "Do not unplug SC64 from the computer, doing so might brick your device".yellow()
             );
 
-            log_wait(
+            let update_stats = log_wait(
                 format!("Updating firmware, this might take a while [{update_name}]"),
                 || sc64.update_firmware(&firmware, args.use_flash_memory),
             )?;
+            if update_stats.flash.blocks > 0 {
+                println!("Flash memory: {}", update_stats.flash);
+            }
+            if !update_stats.steps.is_empty() {
+                println!("Update time: {update_stats}");
+            }
 
             Ok(())
         }
@@ -1183,42 +1489,12 @@ fn handle_test_command(connection: Connection) -> Result<(), sc64::Error> {
         (sc64::MemoryTestPattern::AllOnes, None),
         (sc64::MemoryTestPattern::Custom(0xAAAA5555), None),
         (sc64::MemoryTestPattern::Custom(0x5555AAAA), None),
+        (sc64::MemoryTestPattern::Walking(false), None),
+        (sc64::MemoryTestPattern::Walking(true), None),
         (sc64::MemoryTestPattern::Random, None),
         (sc64::MemoryTestPattern::Random, None),
         (sc64::MemoryTestPattern::Random, None),
         (sc64::MemoryTestPattern::Random, None),
-        (sc64::MemoryTestPattern::Custom(0x00010001), None),
-        (sc64::MemoryTestPattern::Custom(0xFFFEFFFE), None),
-        (sc64::MemoryTestPattern::Custom(0x00020002), None),
-        (sc64::MemoryTestPattern::Custom(0xFFFDFFFD), None),
-        (sc64::MemoryTestPattern::Custom(0x00040004), None),
-        (sc64::MemoryTestPattern::Custom(0xFFFBFFFB), None),
-        (sc64::MemoryTestPattern::Custom(0x00080008), None),
-        (sc64::MemoryTestPattern::Custom(0xFFF7FFF7), None),
-        (sc64::MemoryTestPattern::Custom(0x00100010), None),
-        (sc64::MemoryTestPattern::Custom(0xFFEFFFEF), None),
-        (sc64::MemoryTestPattern::Custom(0x00200020), None),
-        (sc64::MemoryTestPattern::Custom(0xFFDFFFDF), None),
-        (sc64::MemoryTestPattern::Custom(0x00400040), None),
-        (sc64::MemoryTestPattern::Custom(0xFFBFFFBF), None),
-        (sc64::MemoryTestPattern::Custom(0x00800080), None),
-        (sc64::MemoryTestPattern::Custom(0xFF7FFF7F), None),
-        (sc64::MemoryTestPattern::Custom(0x01000100), None),
-        (sc64::MemoryTestPattern::Custom(0xFEFFFEFF), None),
-        (sc64::MemoryTestPattern::Custom(0x02000200), None),
-        (sc64::MemoryTestPattern::Custom(0xFDFFFDFF), None),
-        (sc64::MemoryTestPattern::Custom(0x04000400), None),
-        (sc64::MemoryTestPattern::Custom(0xFBFFFBFF), None),
-        (sc64::MemoryTestPattern::Custom(0x08000800), None),
-        (sc64::MemoryTestPattern::Custom(0xF7FFF7FF), None),
-        (sc64::MemoryTestPattern::Custom(0x10001000), None),
-        (sc64::MemoryTestPattern::Custom(0xEFFFEFFF), None),
-        (sc64::MemoryTestPattern::Custom(0x20002000), None),
-        (sc64::MemoryTestPattern::Custom(0xDFFFDFFF), None),
-        (sc64::MemoryTestPattern::Custom(0x40004000), None),
-        (sc64::MemoryTestPattern::Custom(0xBFFFBFFF), None),
-        (sc64::MemoryTestPattern::Custom(0x80008000), None),
-        (sc64::MemoryTestPattern::Custom(0x7FFF7FFF), None),
         (sc64::MemoryTestPattern::AllZeros, Some(60)),
         (sc64::MemoryTestPattern::AllOnes, Some(60)),
     ];
@@ -1244,8 +1520,8 @@ fn handle_test_command(connection: Connection) -> Result<(), sc64::Error> {
             sdram_tests_failed = true;
             println!("{}", "error!".bright_red());
             println!("  Found a mismatch at address 0x{address:08X}",);
-            println!("   0x{written:08X} (W) != 0x{read:08X} (R)");
-            println!("   Total errors found: {}", result.all_errors.len());
+            println!("   0x{written:04X} (W) != 0x{read:04X} (R)");
+            println!("   Total errors found: {}", result.error_count);
         } else {
             println!("{}", "ok".bright_green());
         }
@@ -1263,6 +1539,227 @@ fn handle_test_command(connection: Connection) -> Result<(), sc64::Error> {
     Ok(())
 }
 
+fn handle_bench_command(connection: Connection, args: &BenchArgs) -> Result<(), sc64::Error> {
+    const DD_BLOCK_LENGTH: usize = 232 * 85;
+    const SAVE_LENGTHS: [(&str, usize); 4] = [
+        ("EEPROM 4k", 512),
+        ("EEPROM 16k", 2 * 1024),
+        ("SRAM", 32 * 1024),
+        ("FlashRAM", 128 * 1024),
+    ];
+
+    let serial = match &connection {
+        Connection::Local(port) => sc64::list_local_devices()
+            .unwrap_or_default()
+            .into_iter()
+            .find(|device| port.as_ref().map_or(true, |port| &device.port == port))
+            .map(|device| device.serial)
+            .unwrap_or_default(),
+        Connection::Remote(address) => format!("remote:{address}"),
+    };
+
+    let mut sc64 = init_sc64(connection, true)?;
+
+    let (major, minor, revision) = sc64.check_firmware_version()?;
+
+    sc64.reset_state()?;
+
+    let mut results = vec![];
+
+    if !args.skip_usb {
+        let total_length = args.usb_length * 1024 * 1024;
+        for chunk in args.usb_chunks.iter() {
+            let chunk_length = chunk * 1024;
+            for (test, direction) in [
+                ("read", sc64::SpeedTestDirection::Read),
+                ("write", sc64::SpeedTestDirection::Write),
+            ] {
+                eprintln!("[Bench]: USB {test}, {chunk} kiB chunks");
+                let elapsed = sc64.bench_usb_transfer(direction, chunk_length, total_length)?;
+                results.push(bench::BenchResult {
+                    group: "usb",
+                    test: test.to_string(),
+                    parameter: format!("chunk={chunk_length}"),
+                    value: bench::throughput(total_length, elapsed),
+                    unit: bench::Unit::MibPerSecond,
+                    proxy: false,
+                });
+            }
+        }
+
+        eprintln!("[Bench]: Command round-trip latency");
+        let mut samples = vec![];
+        for _ in 0..args.latency_samples {
+            samples.push(sc64.bench_command_latency()?);
+        }
+        samples.sort();
+        for percentile in [50.0, 90.0, 99.0, 100.0] {
+            results.push(bench::BenchResult {
+                group: "usb",
+                test: "latency".to_string(),
+                parameter: format!("p{percentile}"),
+                value: bench::percentile(&samples, percentile).as_secs_f64() * 1_000_000.0,
+                unit: bench::Unit::Microseconds,
+                proxy: false,
+            });
+        }
+    }
+
+    if !args.skip_sd {
+        match sc64.init_sd_card()? {
+            sc64::SdCardResult::OK => {}
+            result => {
+                return Err(sc64::Error::new(
+                    format!("Init SD card failed: {result}").as_str(),
+                ))
+            }
+        }
+
+        let sd_result = (|| -> Result<(), sc64::Error> {
+            let card_sectors = sc64.get_sd_card_info()?.sectors;
+            let total_sectors = (args.sd_length * 1024 * 1024 / sc64::SD_CARD_SECTOR_SIZE) as u32;
+
+            for &count in args.sd_requests.iter() {
+                let length = count as usize * sc64::SD_CARD_SECTOR_SIZE;
+                let mut tests: Vec<(&str, bool)> = vec![("read", false)];
+                if args.sd_write {
+                    tests.push(("write", true));
+                }
+                for (test, write) in tests {
+                    let sd_bench = |sc64: &mut sc64::SC64, sector: u32| {
+                        if write {
+                            sc64.bench_sd_card_rewrite(sector, count)
+                        } else {
+                            sc64.bench_sd_card_read(sector, count)
+                        }
+                    };
+
+                    eprintln!("[Bench]: SD card sequential {test}, {count} sector requests");
+                    let mut elapsed = std::time::Duration::ZERO;
+                    let mut transferred = 0;
+                    for sector in (0..total_sectors).step_by(count as usize) {
+                        elapsed += sd_bench(&mut sc64, sector)?;
+                        transferred += length;
+                    }
+                    results.push(bench::BenchResult {
+                        group: "sd",
+                        test: format!("sequential_{test}"),
+                        parameter: format!("request={length}"),
+                        value: bench::throughput(transferred, elapsed),
+                        unit: bench::Unit::MibPerSecond,
+                        proxy: false,
+                    });
+
+                    eprintln!("[Bench]: SD card random {test}, {count} sector requests");
+                    let mut samples = vec![];
+                    let max_sector = card_sectors.saturating_sub(count as u64).max(1);
+                    for _ in 0..args.sd_random_samples {
+                        let sector = (rand::random::<u64>() % max_sector) as u32;
+                        samples.push(sd_bench(&mut sc64, sector)?);
+                    }
+                    let elapsed: std::time::Duration = samples.iter().sum();
+                    results.push(bench::BenchResult {
+                        group: "sd",
+                        test: format!("random_{test}"),
+                        parameter: format!("request={length}"),
+                        value: bench::throughput(length * samples.len(), elapsed),
+                        unit: bench::Unit::MibPerSecond,
+                        proxy: false,
+                    });
+                    samples.sort();
+                    results.push(bench::BenchResult {
+                        group: "sd",
+                        test: format!("random_{test}_latency"),
+                        parameter: format!("request={length},p99"),
+                        value: bench::percentile(&samples, 99.0).as_secs_f64() * 1_000.0,
+                        unit: bench::Unit::Milliseconds,
+                        proxy: false,
+                    });
+                }
+            }
+
+            Ok(())
+        })();
+
+        sc64.deinit_sd_card()?;
+        sd_result?;
+    }
+
+    if args.flash {
+        eprintln!("[Bench]: Flash erase/program");
+        let (length, erase_time, program_time) = sc64.bench_flash()?;
+        results.push(bench::BenchResult {
+            group: "flash",
+            test: "erase".to_string(),
+            parameter: format!("block={length}"),
+            value: bench::throughput(length, erase_time),
+            unit: bench::Unit::MibPerSecond,
+            proxy: false,
+        });
+        results.push(bench::BenchResult {
+            group: "flash",
+            test: "program".to_string(),
+            parameter: format!("block={length}"),
+            value: bench::throughput(length, program_time),
+            unit: bench::Unit::MibPerSecond,
+            proxy: false,
+        });
+    }
+
+    // Neither test has the console side of the transfer available, results are host side
+    // proxies for the 64DD block service and save writeback latencies
+    let mut transfer_tests: Vec<(&str, String, usize)> =
+        vec![("dd", "block_upload".to_string(), DD_BLOCK_LENGTH)];
+    for (name, length) in SAVE_LENGTHS {
+        transfer_tests.push(("writeback", format!("save_read {name}"), length));
+    }
+    for (group, test, length) in transfer_tests {
+        eprintln!("[Bench]: {group} {test} (proxy, host side only)");
+        let mut samples = vec![];
+        for _ in 0..args.transfer_samples {
+            samples.push(if group == "dd" {
+                sc64.bench_dd_block_upload(length)?
+            } else {
+                sc64.bench_save_read(length)?
+            });
+        }
+        samples.sort();
+        for percentile in [50.0, 99.0] {
+            results.push(bench::BenchResult {
+                group,
+                test: test.clone(),
+                parameter: format!("length={length},p{percentile}"),
+                value: bench::percentile(&samples, percentile).as_secs_f64() * 1_000.0,
+                unit: bench::Unit::Milliseconds,
+                proxy: true,
+            });
+        }
+    }
+
+    sc64.reset_state()?;
+
+    let report = bench::BenchReport {
+        firmware_version: format!("v{major}.{minor}.{revision}"),
+        serial,
+        timestamp: Local::now().to_rfc3339(),
+        results,
+    };
+
+    let output = match args.format {
+        BenchFormat::Json => report.to_json(),
+        BenchFormat::Csv => report.to_csv(),
+    };
+
+    if let Some(path) = &args.output {
+        let (mut file, _) = create_file(path)?;
+        file.write_all(output.as_bytes())?;
+    } else {
+        print!("{output}");
+    }
+
+    Ok(())
+}
+
 fn handle_server_command(connection: Connection, args: &ServerArgs) -> Result<(), sc64::Error> {
     let port = if let Connection::Local(port) = connection {
         port
@@ -0,0 +1,310 @@
+use crate::sc64::{Telemetry, TelemetryOp};
+use std::{
+    fmt::{Display, Write as FmtWrite},
+    fs::{rename, File},
+    io::{Read, Write},
+    net::{TcpListener, TcpStream},
+    path::PathBuf,
+    sync::{Arc, Mutex},
+    thread::spawn,
+    time::Duration,
+};
+
+const HTTP_TIMEOUT: Duration = Duration::from_secs(5);
+
+#[derive(Clone, Copy, Default)]
+struct OpTotals {
+    count: u64,
+    latency_total_us: u64,
+    latency_max_us: u32,
+}
+
+pub struct OpRate {
+    name: &'static str,
+    per_second: f64,
+    average_us: f64,
+    max_us: u32,
+}
+
+pub struct MonitorSummary {
+    voltage: f32,
+    temperature: f32,
+    loop_rate: f64,
+    loop_period_max_us: u32,
+    usb_rx_fifo_count: u32,
+    usb_tx_fifo_count: u32,
+    ops: Vec<OpRate>,
+}
+
+impl Display for MonitorSummary {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_fmt(format_args!(
+            "{:.03} V / {:.01} °C | loop {:.01} kHz, max {} us | FIFO rx {} B, tx {} B",
+            self.voltage,
+            self.temperature,
+            self.loop_rate / 1000.0,
+            self.loop_period_max_us,
+            self.usb_rx_fifo_count,
+            self.usb_tx_fifo_count,
+        ))?;
+        for op in self.ops.iter() {
+            f.write_fmt(format_args!(" | {} {:.01}/s", op.name, op.per_second))?;
+            if op.per_second > 0.0 {
+                f.write_fmt(format_args!(
+                    " avg {:.0} us max {} us",
+                    op.average_us, op.max_us
+                ))?;
+            }
+        }
+        Ok(())
+    }
+}
+
+pub struct Monitor {
+    last: Option<Telemetry>,
+    reports: u64,
+    uptime_us: u64,
+    loop_count: u64,
+    ops: [OpTotals; 5],
+}
+
+impl Monitor {
+    pub fn new() -> Self {
+        Monitor {
+            last: None,
+            reports: 0,
+            uptime_us: 0,
+            loop_count: 0,
+            ops: [OpTotals::default(); 5],
+        }
+    }
+
+    pub fn update(&mut self, telemetry: Telemetry) -> Option<MonitorSummary> {
+        self.reports += 1;
+
+        let last = match self.last.replace(telemetry) {
+            Some(last) => last,
+            None => {
+                let current = self.last.as_ref().unwrap();
+                self.uptime_us = current.timestamp_us as u64;
+                self.loop_count = current.loop_count as u64;
+                for (totals, op) in self.ops.iter_mut().zip(current.ops.iter()) {
+                    totals.count = op.count as u64;
+                    totals.latency_total_us = op.latency_total_us as u64;
+                    totals.latency_max_us = op.latency_max_us;
+                }
+                return None;
+            }
+        };
+        let current = self.last.as_ref().unwrap();
+
+        let elapsed_us = current.timestamp_us.wrapping_sub(last.timestamp_us);
+        let loop_count = current.loop_count.wrapping_sub(last.loop_count);
+        self.uptime_us += elapsed_us as u64;
+        self.loop_count += loop_count as u64;
+
+        let elapsed = (elapsed_us as f64 / 1_000_000.0).max(f64::EPSILON);
+        let mut ops = Vec::with_capacity(TelemetryOp::ALL.len());
+        for ((totals, op), (previous, kind)) in self
+            .ops
+            .iter_mut()
+            .zip(current.ops.iter())
+            .zip(last.ops.iter().zip(TelemetryOp::ALL.iter()))
+        {
+            let count = op.count.wrapping_sub(previous.count);
+            let latency_us = op.latency_total_us.wrapping_sub(previous.latency_total_us);
+            totals.count += count as u64;
+            totals.latency_total_us += latency_us as u64;
+            totals.latency_max_us = op.latency_max_us;
+            ops.push(OpRate {
+                name: kind.name(),
+                per_second: count as f64 / elapsed,
+                average_us: if count > 0 {
+                    latency_us as f64 / count as f64
+                } else {
+                    0.0
+                },
+                max_us: op.latency_max_us,
+            });
+        }
+
+        Some(MonitorSummary {
+            voltage: current.voltage,
+            temperature: current.temperature,
+            loop_rate: loop_count as f64 / elapsed,
+            loop_period_max_us: current.loop_period_max_us,
+            usb_rx_fifo_count: current.usb_rx_fifo_count,
+            usb_tx_fifo_count: current.usb_tx_fifo_count,
+            ops,
+        })
+    }
+
+    pub fn render_prometheus(&self) -> String {
+        let mut text = String::new();
+        let current = match &self.last {
+            Some(current) => current,
+            None => return text,
+        };
+
+        let mut metric = |name: &str, kind: &str, help: &str, samples: &[(String, String)]| {
+            writeln!(text, "# HELP {name} {help}").unwrap();
+            writeln!(text, "# TYPE {name} {kind}").unwrap();
+            for (labels, value) in samples {
+                writeln!(text, "{name}{labels} {value}").unwrap();
+            }
+        };
+        let single = |value: String| vec![(String::new(), value)];
+        let seconds = |us: u64| format!("{:.6}", us as f64 / 1_000_000.0);
+
+        metric(
+            "sc64_telemetry_reports_total",
+            "counter",
+            "Telemetry reports received from the SC64",
+            &single(self.reports.to_string()),
+        );
+        metric(
+            "sc64_uptime_seconds",
+            "counter",
+            "Controller time covered by received telemetry reports",
+            &single(seconds(self.uptime_us)),
+        );
+        metric(
+            "sc64_main_loop_iterations_total",
+            "counter",
+            "Controller main loop iterations",
+            &single(self.loop_count.to_string()),
+        );
+        metric(
+            "sc64_main_loop_period_max_seconds",
+            "gauge",
+            "Longest controller main loop iteration in the last report period",
+            &single(seconds(current.loop_period_max_us as u64)),
+        );
+        metric(
+            "sc64_voltage_volts",
+            "gauge",
+            "Controller supply voltage",
+            &single(format!("{:.3}", current.voltage)),
+        );
+        metric(
+            "sc64_temperature_celsius",
+            "gauge",
+            "Controller die temperature",
+            &single(format!("{:.1}", current.temperature)),
+        );
+        metric(
+            "sc64_usb_fifo_bytes",
+            "gauge",
+            "Bytes waiting in the USB FIFOs",
+            &[
+                (
+                    "{direction=\"rx\"}".into(),
+                    current.usb_rx_fifo_count.to_string(),
+                ),
+                (
+                    "{direction=\"tx\"}".into(),
+                    current.usb_tx_fifo_count.to_string(),
+                ),
+            ],
+        );
+        metric(
+            "sc64_pending",
+            "gauge",
+            "Work queued for the controller",
+            &[
+                (
+                    "{queue=\"writeback\"}".into(),
+                    (current.writeback_pending as u8).to_string(),
+                ),
+                (
+                    "{queue=\"flashram\"}".into(),
+                    (current.flashram_pending as u8).to_string(),
+                ),
+            ],
+        );
+
+        let op_samples = |value: &dyn Fn(&OpTotals) -> String| {
+            TelemetryOp::ALL
+                .iter()
+                .zip(self.ops.iter())
+                .map(|(op, totals)| (format!("{{op=\"{}\"}}", op.name()), value(totals)))
+                .collect::<Vec<(String, String)>>()
+        };
+        metric(
+            "sc64_operations_total",
+            "counter",
+            "Completed controller operations",
+            &op_samples(&|totals| totals.count.to_string()),
+        );
+        metric(
+            "sc64_operation_latency_seconds_total",
+            "counter",
+            "Total time spent in completed controller operations",
+            &op_samples(&|totals| seconds(totals.latency_total_us)),
+        );
+        metric(
+            "sc64_operation_latency_max_seconds",
+            "gauge",
+            "Longest controller operation in the last report period",
+            &op_samples(&|totals| seconds(totals.latency_max_us as u64)),
+        );
+
+        text
+    }
+}
+
+pub struct PrometheusExporter {
+    file: Option<PathBuf>,
+    metrics: Arc<Mutex<String>>,
+}
+
+impl PrometheusExporter {
+    pub fn new(file: Option<PathBuf>, port: Option<u16>) -> std::io::Result<Self> {
+        let metrics = Arc::new(Mutex::new(String::new()));
+        if let Some(port) = port {
+            let listener = TcpListener::bind(("0.0.0.0", port))?;
+            let metrics = metrics.clone();
+            spawn(move || {
+                for stream in listener.incoming() {
+                    if let Ok(stream) = stream {
+                        serve_metrics(stream, &metrics).ok();
+                    }
+                }
+            });
+        }
+        Ok(PrometheusExporter { file, metrics })
+    }
+
+    pub fn publish(&self, text: String) -> std::io::Result<()> {
+        if let Some(path) = &self.file {
+            let mut temporary_path = path.clone().into_os_string();
+            temporary_path.push(".tmp");
+            File::create(&temporary_path)?.write_all(text.as_bytes())?;
+            rename(&temporary_path, path)?;
+        }
+        *self.metrics.lock().unwrap() = text;
+        Ok(())
+    }
+}
+
+fn serve_metrics(mut stream: TcpStream, metrics: &Mutex<String>) -> std::io::Result<()> {
+    stream.set_read_timeout(Some(HTTP_TIMEOUT))?;
+    stream.set_write_timeout(Some(HTTP_TIMEOUT))?;
+    let mut request = Vec::new();
+    let mut buffer = [0u8; 1024];
+    while !request.windows(4).any(|window| window == b"\r\n\r\n") {
+        let length = stream.read(&mut buffer)?;
+        if length == 0 || request.len() > 16 * 1024 {
+            break;
+        }
+        request.extend_from_slice(&buffer[..length]);
+    }
+    let body = metrics.lock().unwrap().clone();
+    write!(
+        stream,
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+        body.len(),
+        body
+    )?;
+    stream.flush()
+}
@@ -0,0 +1,1144 @@
+use super::{
+    error::Error,
+    time::{convert_from_datetime, convert_to_datetime},
+};
+use chrono::Local;
+use std::{
+    collections::VecDeque,
+    fs::{File, OpenOptions},
+    io::{Read, Seek, SeekFrom, Write},
+    thread::sleep,
+    time::{Duration, Instant},
+};
+
+const IDENTIFIER: &[u8; 4] = b"SCv2";
+const VERSION: u32 = (2 << 16) | 20;
+const REVISION: u32 = 0;
+
+const MEMORY_LENGTH: usize = 0x0500_2C80;
+
+const BOOTLOADER_ADDRESS: usize = 0x04E0_0000;
+const BOOTLOADER_LENGTH: usize = 1920 * 1024;
+
+const FLASH_ADDRESS: usize = 0x0400_0000;
+const FLASH_LENGTH: usize = 16 * 1024 * 1024;
+const FLASH_ERASE_BLOCK_SIZE: usize = 128 * 1024;
+
+const SAVE_ADDRESS: usize = 0x03FE_0000;
+const EEPROM_ADDRESS: usize = 0x0500_2000;
+
+const DD_BLOCK_BUFFER_ADDRESS: u32 = 0x03BC_0000 - 0x5000;
+
+const ISV_TOKEN: u32 = 0x4953_3634;
+const ISV_SETUP_TOKEN_ADDRESS: usize = 0x0000_0100;
+const ISV_SETUP_OFFSET_ADDRESS: usize = 0x0000_0104;
+const ISV_SETUP_READY_ADDRESS: usize = 0x0000_010C;
+const ISV_TOKEN_OFFSET: usize = 0x0000_0000;
+const ISV_READ_POINTER_OFFSET: usize = 0x0000_0004;
+const ISV_WRITE_POINTER_OFFSET: usize = 0x0000_0014;
+const ISV_BUFFER_OFFSET: usize = 0x0000_0020;
+const ISV_BUFFER_SIZE: u32 = (64 * 1024) - ISV_BUFFER_OFFSET as u32;
+
+const SD_SECTOR_SIZE: usize = 512;
+const SD_MAX_SECTOR_COUNT: u32 = 0x80_0000;
+
+const SD_OK: u32 = 0;
+const SD_ERROR_NO_CARD_IN_SLOT: u32 = 1;
+const SD_ERROR_NOT_INITIALIZED: u32 = 2;
+const SD_ERROR_INVALID_ARGUMENT: u32 = 3;
+const SD_ERROR_INVALID_ADDRESS: u32 = 4;
+const SD_ERROR_INVALID_OPERATION: u32 = 5;
+const SD_ERROR_CMD18_IO: u32 = 20;
+const SD_ERROR_CMD25_IO: u32 = 23;
+
+const WRITEBACK_DELAY: Duration = Duration::from_secs(1);
+const USB_READ_TIMEOUT: Duration = Duration::from_secs(1);
+const POLL_TIMEOUT: Duration = Duration::from_millis(1);
+const LINK_SLEEP_THRESHOLD: Duration = Duration::from_millis(1);
+
+const CFG_ID_BOOTLOADER_SWITCH: usize = 0;
+const CFG_ID_ROM_WRITE_ENABLE: usize = 1;
+const CFG_ID_ROM_SHADOW_ENABLE: usize = 2;
+const CFG_ID_DD_MODE: usize = 3;
+const CFG_ID_ISV_ADDRESS: usize = 4;
+const CFG_ID_BOOT_MODE: usize = 5;
+const CFG_ID_SAVE_TYPE: usize = 6;
+const CFG_ID_CIC_SEED: usize = 7;
+const CFG_ID_TV_TYPE: usize = 8;
+const CFG_ID_DD_SD_ENABLE: usize = 9;
+const CFG_ID_DD_DRIVE_TYPE: usize = 10;
+const CFG_ID_DD_DISK_STATE: usize = 11;
+const CFG_ID_BUTTON_STATE: usize = 12;
+const CFG_ID_BUTTON_MODE: usize = 13;
+const CFG_ID_ROM_EXTENDED_ENABLE: usize = 14;
+const CFG_ID_COUNT: usize = 15;
+
+const DD_MODE_REGS: u32 = 1;
+const DD_DISK_STATE_INSERTED: u32 = 1;
+const DD_COMMAND_READ: u32 = 1;
+
+const SETTING_ID_LED_ENABLE: u32 = 0;
+
+const TELEMETRY_VERSION: u32 = 1;
+const TELEMETRY_PERIOD_MIN_MS: u32 = 100;
+const TELEMETRY_PERIOD_MAX_MS: u32 = 60000;
+const TELEMETRY_OP_SD: usize = 0;
+const TELEMETRY_OP_USB: usize = 1;
+const TELEMETRY_OP_DD: usize = 2;
+const TELEMETRY_OP_COUNT: usize = 5;
+
+const SDRAM_ADDRESS: usize = 0x0000_0000;
+const SDRAM_LENGTH: usize = 64 * 1024 * 1024;
+
+const BIST_CONTROL_WRITE_PASS: u32 = 1 << 0;
+const BIST_CONTROL_VERIFY_PASS: u32 = 1 << 1;
+const BIST_CONTROL_INVERT: u32 = 1 << 2;
+const BIST_CONTROL_STOP: u32 = 1 << 3;
+const BIST_CONTROL_PATTERN_BIT: u32 = 4;
+const BIST_CONTROL_ERROR_BIT: u32 = 8;
+const BIST_PATTERN_CONSTANT: u32 = 0;
+const BIST_PATTERN_OWN_ADDRESS: u32 = 1;
+const BIST_PATTERN_WALKING: u32 = 2;
+const BIST_LFSR_TAPS: u16 = 0xB400;
+const BIST_ERROR_LOG_LENGTH: usize = 4;
+const BIST_ERROR_COUNT_MAX: u32 = 0xFF_FFFF;
+
+struct EmulatorOptions {
+    sd_card_image: Option<String>,
+    bandwidth: Option<f64>,
+    latency: Duration,
+    loopback: bool,
+    dd_reads: u32,
+}
+
+impl EmulatorOptions {
+    fn parse(options: &str) -> Result<Self, Error> {
+        let mut parsed = Self {
+            sd_card_image: None,
+            bandwidth: None,
+            latency: Duration::ZERO,
+            loopback: true,
+            dd_reads: 0,
+        };
+        for option in options.split(',').filter(|option| !option.is_empty()) {
+            let (key, value) = option.split_once('=').unwrap_or((option, ""));
+            let invalid_value =
+                || Error::new(format!("Invalid emulator option value [{option}]").as_str());
+            match key {
+                "sd" => parsed.sd_card_image = Some(value.to_string()),
+                "bandwidth" => {
+                    let mib_per_second: f64 = value.parse().map_err(|_| invalid_value())?;
+                    if mib_per_second <= 0.0 {
+                        return Err(invalid_value());
+                    }
+                    parsed.bandwidth = Some(mib_per_second * 1024.0 * 1024.0);
+                }
+                "latency" => {
+                    parsed.latency =
+                        Duration::from_micros(value.parse().map_err(|_| invalid_value())?)
+                }
+                "loopback" => parsed.loopback = value != "0",
+                "dd_reads" => parsed.dd_reads = value.parse().map_err(|_| invalid_value())?,
+                _ => {
+                    return Err(Error::new(
+                        format!("Unknown emulator option [{key}]").as_str(),
+                    ))
+                }
+            }
+        }
+        Ok(parsed)
+    }
+}
+
+struct SdCard {
+    file: File,
+    sectors: u64,
+    initialized: bool,
+    byte_swap: bool,
+}
+
+pub struct EmulatedDevice {
+    bandwidth: Option<f64>,
+    latency: Duration,
+    loopback: bool,
+
+    input: Vec<u8>,
+    output: VecDeque<u8>,
+    dtr: bool,
+    link_ready: Instant,
+
+    memory: Vec<u8>,
+    config: [u32; CFG_ID_COUNT],
+    led_enable: u32,
+    time_offset: chrono::Duration,
+    sd_card: Option<SdCard>,
+
+    writeback_enabled: bool,
+    writeback_deadline: Option<Instant>,
+    usb_flush_deadline: Option<Instant>,
+
+    dd_reads: u32,
+    dd_pending: bool,
+    dd_next_block: u32,
+    dd_request_time: Instant,
+
+    started: Instant,
+    loop_count: u32,
+    telemetry_period: Option<Duration>,
+    telemetry_deadline: Instant,
+    telemetry_ops: [[u32; 3]; TELEMETRY_OP_COUNT],
+
+    bist_error_count: u32,
+    bist_errors: [(u32, u32); BIST_ERROR_LOG_LENGTH],
+}
+
+fn get_u32(data: &[u8]) -> u32 {
+    u32::from_be_bytes(data[0..4].try_into().unwrap())
+}
+
+fn words_to_bytes(words: &[u32]) -> Vec<u8> {
+    words.iter().flat_map(|word| word.to_be_bytes()).collect()
+}
+
+fn swap_bytes(data: &mut [u8]) {
+    for pair in data.chunks_exact_mut(2) {
+        pair.swap(0, 1);
+    }
+}
+
+fn validate_address_length(address: u32, length: u32, exclude_bootloader: bool) -> bool {
+    let (address, length) = (address as usize, length as usize);
+    if length == 0 || address >= MEMORY_LENGTH || length > MEMORY_LENGTH {
+        return true;
+    }
+    if (address + length) > MEMORY_LENGTH {
+        return true;
+    }
+    if exclude_bootloader
+        && (address + length) > BOOTLOADER_ADDRESS
+        && address < (BOOTLOADER_ADDRESS + BOOTLOADER_LENGTH)
+    {
+        return true;
+    }
+    false
+}
+
+impl EmulatedDevice {
+    pub fn new(options: &str) -> Result<Self, Error> {
+        let options = EmulatorOptions::parse(options)?;
+
+        let sd_card = match &options.sd_card_image {
+            Some(path) => {
+                let file = OpenOptions::new()
+                    .read(true)
+                    .write(true)
+                    .open(path)
+                    .map_err(|error| {
+                        Error::new(
+                            format!("Couldn't open SD card image [{path}]: {error}").as_str(),
+                        )
+                    })?;
+                let sectors = file.metadata()?.len() / SD_SECTOR_SIZE as u64;
+                if sectors < 1024 {
+                    return Err(Error::new("SD card image must be at least 512 kiB long"));
+                }
+                Some(SdCard {
+                    file,
+                    sectors,
+                    initialized: false,
+                    byte_swap: false,
+                })
+            }
+            None => None,
+        };
+
+        let mut memory = vec![0u8; MEMORY_LENGTH];
+        memory[FLASH_ADDRESS..(FLASH_ADDRESS + FLASH_LENGTH)].fill(0xFF);
+
+        let mut device = Self {
+            bandwidth: options.bandwidth,
+            latency: options.latency,
+            loopback: options.loopback,
+            input: Vec::new(),
+            output: VecDeque::new(),
+            dtr: false,
+            link_ready: Instant::now(),
+            memory,
+            config: [0; CFG_ID_COUNT],
+            led_enable: 1,
+            time_offset: chrono::Duration::zero(),
+            sd_card,
+            writeback_enabled: false,
+            writeback_deadline: None,
+            usb_flush_deadline: None,
+            dd_reads: options.dd_reads,
+            dd_pending: false,
+            dd_next_block: 0,
+            dd_request_time: Instant::now(),
+            started: Instant::now(),
+            loop_count: 0,
+            telemetry_period: None,
+            telemetry_deadline: Instant::now(),
+            telemetry_ops: [[0; 3]; TELEMETRY_OP_COUNT],
+            bist_error_count: 0,
+            bist_errors: [(0, 0); BIST_ERROR_LOG_LENGTH],
+        };
+        device.config[CFG_ID_BOOTLOADER_SWITCH] = 1;
+        device.reset_state();
+
+        Ok(device)
+    }
+
+    pub fn read(&mut self, buffer: &mut [u8]) -> std::io::Result<usize> {
+        self.process_events();
+        if self.output.is_empty() {
+            sleep(POLL_TIMEOUT);
+            return Err(std::io::ErrorKind::TimedOut.into());
+        }
+        let length = buffer.len().min(self.output.len());
+        for (byte, value) in buffer.iter_mut().zip(self.output.drain(..length)) {
+            *byte = value;
+        }
+        self.throttle(length);
+        Ok(length)
+    }
+
+    pub fn write_all(&mut self, buffer: &[u8]) -> std::io::Result<()> {
+        self.throttle(buffer.len());
+        self.input.extend_from_slice(buffer);
+        if !self.dtr {
+            self.process_input();
+        }
+        Ok(())
+    }
+
+    pub fn flush(&mut self) -> std::io::Result<()> {
+        if !self.latency.is_zero() {
+            sleep(self.latency);
+        }
+        Ok(())
+    }
+
+    pub fn discard_input(&mut self) -> std::io::Result<()> {
+        self.output.clear();
+        Ok(())
+    }
+
+    pub fn discard_output(&mut self) -> std::io::Result<()> {
+        self.input.clear();
+        Ok(())
+    }
+
+    pub fn set_dtr(&mut self, value: bool) -> std::io::Result<()> {
+        self.dtr = value;
+        if value {
+            self.input.clear();
+            self.output.clear();
+        }
+        Ok(())
+    }
+
+    pub fn read_dsr(&mut self) -> std::io::Result<bool> {
+        Ok(self.dtr)
+    }
+
+    fn throttle(&mut self, length: usize) {
+        if let Some(bandwidth) = self.bandwidth {
+            let now = Instant::now();
+            self.link_ready =
+                self.link_ready.max(now) + Duration::from_secs_f64(length as f64 / bandwidth);
+            let debt = self.link_ready - now;
+            if debt > LINK_SLEEP_THRESHOLD {
+                sleep(debt);
+            }
+        }
+    }
+
+    fn send(&mut self, token: &[u8; 3], id: u8, data: &[u8]) {
+        self.output.extend(token);
+        self.output.push_back(id);
+        self.output.extend((data.len() as u32).to_be_bytes());
+        self.output.extend(data);
+    }
+
+    fn send_packet(&mut self, id: u8, data: &[u8]) {
+        self.send(b"PKT", id, data);
+    }
+
+    fn process_input(&mut self) {
+        while self.input.len() >= 12 {
+            if &self.input[0..3] != b"CMD" {
+                self.input.remove(0);
+                continue;
+            }
+            let id = self.input[3];
+            let args = [get_u32(&self.input[4..8]), get_u32(&self.input[8..12])];
+            let data_length = match id {
+                b'M' | b'U' => args[1] as usize,
+                b's' | b'S' => 4,
+                _ => 0,
+            };
+            if self.input.len() < (12 + data_length) {
+                break;
+            }
+            let data: Vec<u8> = self.input.drain(..(12 + data_length)).skip(12).collect();
+            let start = Instant::now();
+            if let Some((error, response)) = self.execute_command(id, args, &data) {
+                self.send(if error { b"ERR" } else { b"CMP" }, id, &response);
+                self.telemetry_op_done(TELEMETRY_OP_USB, start);
+            }
+            self.process_events();
+        }
+    }
+
+    fn execute_command(&mut self, id: u8, args: [u32; 2], data: &[u8]) -> Option<(bool, Vec<u8>)> {
+        Some(match id {
+            b'v' => (false, IDENTIFIER.to_vec()),
+            b'V' => (false, words_to_bytes(&[VERSION, REVISION])),
+            b'R' => {
+                self.reset_state();
+                (false, vec![])
+            }
+            b'B' => (false, vec![]),
+            b'c' => match self.config_query(args[0]) {
+                Some(value) => (false, words_to_bytes(&[value])),
+                None => (true, words_to_bytes(&[args[1]])),
+            },
+            b'C' => (self.config_update(args[0], args[1]), vec![]),
+            b'a' => match args[0] {
+                SETTING_ID_LED_ENABLE => (false, words_to_bytes(&[self.led_enable])),
+                _ => (true, words_to_bytes(&[args[1]])),
+            },
+            b'A' => match args[0] {
+                SETTING_ID_LED_ENABLE => {
+                    self.led_enable = (args[1] != 0) as u32;
+                    (false, vec![])
+                }
+                _ => (true, vec![]),
+            },
+            b't' => {
+                let time = convert_from_datetime(Local::now().naive_local() + self.time_offset);
+                (false, words_to_bytes(&time))
+            }
+            b'T' => {
+                let bytes: [u8; 8] = words_to_bytes(&args).try_into().unwrap();
+                match convert_to_datetime(&bytes) {
+                    Ok(datetime) => {
+                        self.time_offset = datetime - Local::now().naive_local();
+                        (false, vec![])
+                    }
+                    Err(_) => (true, vec![]),
+                }
+            }
+            b'm' => {
+                if validate_address_length(args[0], args[1], false) {
+                    (true, vec![])
+                } else {
+                    let address = args[0] as usize;
+                    let length = args[1] as usize;
+                    (false, self.memory[address..(address + length)].to_vec())
+                }
+            }
+            b'M' => {
+                if validate_address_length(args[0], args[1], true) {
+                    (true, vec![])
+                } else {
+                    self.memory_write(args[0] as usize, data);
+                    (false, vec![])
+                }
+            }
+            b'U' => {
+                if !data.is_empty() {
+                    if self.loopback {
+                        let header = ((args[0] & 0xFF) << 24) | (data.len() as u32 & 0xFFFFFF);
+                        let mut packet = header.to_be_bytes().to_vec();
+                        packet.extend_from_slice(data);
+                        self.send_packet(b'U', &packet);
+                    } else {
+                        self.usb_flush_deadline = Some(Instant::now() + USB_READ_TIMEOUT);
+                    }
+                }
+                return None;
+            }
+            b'X' => {
+                if self.loopback {
+                    self.send_packet(b'X', &args[0].to_be_bytes());
+                }
+                (false, vec![])
+            }
+            b'i' => {
+                let error = self.sd_card_op(args[0], args[1]);
+                (
+                    error != SD_OK,
+                    words_to_bytes(&[error, self.sd_card_status()]),
+                )
+            }
+            b's' | b'S' => {
+                let start = Instant::now();
+                let error = self.sd_card_transfer(id == b'S', args[0], get_u32(data), args[1]);
+                if error == SD_OK {
+                    self.telemetry_op_done(TELEMETRY_OP_SD, start);
+                }
+                (error != SD_OK, words_to_bytes(&[error]))
+            }
+            b'D' => {
+                if self.dd_pending {
+                    self.telemetry_op_done(TELEMETRY_OP_DD, self.dd_request_time);
+                }
+                self.dd_pending = false;
+                (false, vec![])
+            }
+            b'W' => {
+                self.writeback_enabled = true;
+                (false, vec![])
+            }
+            b'p' => (false, words_to_bytes(&[FLASH_ERASE_BLOCK_SIZE as u32])),
+            b'P' => {
+                let address = args[0] as usize;
+                let error = validate_address_length(args[0], FLASH_ERASE_BLOCK_SIZE as u32, true)
+                    || (address % FLASH_ERASE_BLOCK_SIZE) != 0
+                    || address < FLASH_ADDRESS
+                    || address >= (FLASH_ADDRESS + FLASH_LENGTH);
+                if !error {
+                    self.memory[address..(address + FLASH_ERASE_BLOCK_SIZE)].fill(0xFF);
+                }
+                (error, vec![])
+            }
+            b'E' => {
+                let address = args[0] as usize;
+                let length = args[1] as usize;
+                let error = validate_address_length(args[0], args[1], true)
+                    || (address % FLASH_ERASE_BLOCK_SIZE) != 0
+                    || length == 0
+                    || address < FLASH_ADDRESS
+                    || (address + length) > (FLASH_ADDRESS + FLASH_LENGTH);
+                if !error {
+                    let length = length.div_ceil(FLASH_ERASE_BLOCK_SIZE) * FLASH_ERASE_BLOCK_SIZE;
+                    self.memory[address..(address + length)].fill(0xFF);
+                }
+                (error, vec![])
+            }
+            b'e' => (false, words_to_bytes(&[0, 0])),
+            b'f' | b'F' => (true, vec![]),
+            b'b' => {
+                let control = args[0];
+                if (control & BIST_CONTROL_STOP) == 0
+                    && (control & (BIST_CONTROL_WRITE_PASS | BIST_CONTROL_VERIFY_PASS)) != 0
+                {
+                    self.memory_test(control, args[1]);
+                }
+                let index = ((control >> BIST_CONTROL_ERROR_BIT) & 0xFF) as usize;
+                let (address, data) = self.bist_errors.get(index).copied().unwrap_or((0, 0));
+                (
+                    false,
+                    words_to_bytes(&[0, self.bist_error_count, address, data]),
+                )
+            }
+            b'?' => (false, words_to_bytes(&[0, 0])),
+            b'%' => (false, words_to_bytes(&[(1 << 31) | 1, 3300, 250, 0])),
+            b'Q' => {
+                let period_ms = args[0];
+                if period_ms != 0
+                    && !(TELEMETRY_PERIOD_MIN_MS..=TELEMETRY_PERIOD_MAX_MS).contains(&period_ms)
+                {
+                    (true, vec![])
+                } else {
+                    self.telemetry_period =
+                        (period_ms != 0).then(|| Duration::from_millis(period_ms as u64));
+                    self.telemetry_deadline = Instant::now();
+                    (false, vec![])
+                }
+            }
+            _ => (true, words_to_bytes(&[0xFFFFFFFF])),
+        })
+    }
+
+    fn memory_test(&mut self, control: u32, data: u32) {
+        let pattern = (control >> BIST_CONTROL_PATTERN_BIT) & 0x3;
+        let invert = (control & BIST_CONTROL_INVERT) != 0;
+        let seed = if (data as u16) == 0 { 1 } else { data as u16 };
+        let expected = |address: usize, lfsr: u16| -> u16 {
+            let value = match pattern {
+                BIST_PATTERN_CONSTANT => {
+                    if (address & 2) != 0 {
+                        data as u16
+                    } else {
+                        (data >> 16) as u16
+                    }
+                }
+                BIST_PATTERN_OWN_ADDRESS => {
+                    if (address & 2) != 0 {
+                        (address & 0xFFFC) as u16
+                    } else {
+                        ((address >> 16) & 0x7FF) as u16
+                    }
+                }
+                BIST_PATTERN_WALKING => 1 << ((address >> 1) & 0xF),
+                _ => lfsr,
+            };
+            if invert {
+                !value
+            } else {
+                value
+            }
+        };
+        let lfsr_step =
+            |lfsr: u16| (lfsr >> 1) ^ (if (lfsr & 1) != 0 { BIST_LFSR_TAPS } else { 0 });
+
+        self.bist_error_count = 0;
+        let sdram = &mut self.memory[SDRAM_ADDRESS..(SDRAM_ADDRESS + SDRAM_LENGTH)];
+
+        if (control & BIST_CONTROL_WRITE_PASS) != 0 {
+            let mut lfsr = seed;
+            for (i, word) in sdram.chunks_exact_mut(2).enumerate() {
+                word.copy_from_slice(&expected(SDRAM_ADDRESS + (i * 2), lfsr).to_be_bytes());
+                lfsr = lfsr_step(lfsr);
+            }
+        }
+
+        if (control & BIST_CONTROL_VERIFY_PASS) != 0 {
+            let mut lfsr = seed;
+            for (i, word) in sdram.chunks_exact(2).enumerate() {
+                let address = SDRAM_ADDRESS + (i * 2);
+                let written = expected(address, lfsr);
+                let read = u16::from_be_bytes([word[0], word[1]]);
+                if read != written {
+                    if let Some(error) = self.bist_errors.get_mut(self.bist_error_count as usize) {
+                        *error = (address as u32, ((written as u32) << 16) | (read as u32));
+                    }
+                    if self.bist_error_count < BIST_ERROR_COUNT_MAX {
+                        self.bist_error_count += 1;
+                    }
+                }
+                lfsr = lfsr_step(lfsr);
+            }
+        }
+    }
+
+    fn memory_write(&mut self, address: usize, data: &[u8]) {
+        let end = address + data.len();
+        let flash_start = address.clamp(FLASH_ADDRESS, FLASH_ADDRESS + FLASH_LENGTH);
+        let flash_end = end.clamp(FLASH_ADDRESS, FLASH_ADDRESS + FLASH_LENGTH);
+        if flash_start < flash_end {
+            self.memory[address..flash_start].copy_from_slice(&data[..(flash_start - address)]);
+            let flash_data = &data[(flash_start - address)..(flash_end - address)];
+            for (location, byte) in self.memory[flash_start..flash_end]
+                .iter_mut()
+                .zip(flash_data)
+            {
+                *location &= byte;
+            }
+            self.memory[flash_end..end].copy_from_slice(&data[(flash_end - address)..]);
+        } else {
+            self.memory[address..end].copy_from_slice(data);
+        }
+        if self.writeback_enabled {
+            if let Some((save_address, save_length)) = self.save_area() {
+                if (address < (save_address + save_length))
+                    && ((address + data.len()) > save_address)
+                {
+                    self.writeback_deadline = Some(Instant::now() + WRITEBACK_DELAY);
+                }
+            }
+        }
+    }
+
+    fn get_memory_u32(&self, address: usize) -> u32 {
+        get_u32(&self.memory[address..(address + 4)])
+    }
+
+    fn set_memory_u32(&mut self, address: usize, value: u32) {
+        self.memory[address..(address + 4)].copy_from_slice(&value.to_be_bytes());
+    }
+
+    fn save_area(&self) -> Option<(usize, usize)> {
+        match self.config[CFG_ID_SAVE_TYPE] {
+            1 => Some((EEPROM_ADDRESS, 512)),
+            2 => Some((EEPROM_ADDRESS, 2 * 1024)),
+            3 => Some((SAVE_ADDRESS, 32 * 1024)),
+            4 => Some((SAVE_ADDRESS, 128 * 1024)),
+            5 => Some((SAVE_ADDRESS, 3 * 32 * 1024)),
+            6 => Some((SAVE_ADDRESS, 128 * 1024)),
+            _ => None,
+        }
+    }
+
+    fn reset_state(&mut self) {
+        let bootloader_switch = self.config[CFG_ID_BOOTLOADER_SWITCH];
+        self.config = [0; CFG_ID_COUNT];
+        self.config[CFG_ID_BOOTLOADER_SWITCH] = bootloader_switch;
+        self.config[CFG_ID_CIC_SEED] = 0xFFFF;
+        self.config[CFG_ID_TV_TYPE] = 3;
+        self.writeback_enabled = false;
+        self.writeback_deadline = None;
+        self.dd_pending = false;
+        self.telemetry_period = None;
+    }
+
+    fn config_query(&self, id: u32) -> Option<u32> {
+        let id = id as usize;
+        if id >= CFG_ID_COUNT {
+            return None;
+        }
+        Some(self.config[id])
+    }
+
+    fn config_update(&mut self, id: u32, value: u32) -> bool {
+        let id = id as usize;
+        let valid = match id {
+            CFG_ID_BOOTLOADER_SWITCH
+            | CFG_ID_ROM_WRITE_ENABLE
+            | CFG_ID_ROM_SHADOW_ENABLE
+            | CFG_ID_DD_SD_ENABLE
+            | CFG_ID_ROM_EXTENDED_ENABLE => {
+                self.config[id] = (value != 0) as u32;
+                return false;
+            }
+            CFG_ID_DD_MODE => value <= 3,
+            CFG_ID_ISV_ADDRESS => value < 0x0400_0000 && (value % 4) == 0,
+            CFG_ID_BOOT_MODE => value <= 4,
+            CFG_ID_SAVE_TYPE => value <= 6,
+            CFG_ID_CIC_SEED => value == 0xFFFF || value <= 0xFF,
+            CFG_ID_TV_TYPE => value <= 3,
+            CFG_ID_DD_DRIVE_TYPE => value <= 1,
+            CFG_ID_DD_DISK_STATE => value <= 2,
+            CFG_ID_BUTTON_STATE => false,
+            CFG_ID_BUTTON_MODE => value <= 3,
+            _ => false,
+        };
+        if valid {
+            self.config[id] = value;
+            if id == CFG_ID_DD_DISK_STATE && value != DD_DISK_STATE_INSERTED {
+                self.dd_pending = false;
+            }
+        }
+        !valid
+    }
+
+    fn sd_card_status(&self) -> u32 {
+        match &self.sd_card {
+            Some(sd_card) => {
+                ((sd_card.byte_swap as u32) << 4)
+                    | (1 << 3)
+                    | (1 << 2)
+                    | ((sd_card.initialized as u32) << 1)
+                    | (1 << 0)
+            }
+            None => 0,
+        }
+    }
+
+    fn sd_card_op(&mut self, address: u32, operation: u32) -> u32 {
+        let Some(sd_card) = &mut self.sd_card else {
+            return match operation {
+                0 | 2 | 6 => SD_OK,
+                1 => SD_ERROR_NO_CARD_IN_SLOT,
+                3..=5 => SD_ERROR_NOT_INITIALIZED,
+                _ => SD_ERROR_INVALID_OPERATION,
+            };
+        };
+        match operation {
+            0 => {
+                sd_card.initialized = false;
+                sd_card.byte_swap = false;
+                SD_OK
+            }
+            1 => {
+                sd_card.initialized = true;
+                SD_OK
+            }
+            2 => SD_OK,
+            3 => {
+                if validate_address_length(address, 32, true) {
+                    return SD_ERROR_INVALID_ADDRESS;
+                }
+                if !sd_card.initialized {
+                    return SD_ERROR_NOT_INITIALIZED;
+                }
+                let c_size = ((sd_card.sectors / 1024) - 1) as u128 & 0x3F_FFFF;
+                let csd = (1u128 << 126) | (c_size << 48);
+                let cid = u128::from_be_bytes(*b"\x00SCEMU64\x10\x00\x00\x00\x00\x01\x00\x01");
+                let mut info = csd.to_be_bytes().to_vec();
+                info.extend(cid.to_be_bytes());
+                self.memory_write(address as usize, &info);
+                SD_OK
+            }
+            4 | 5 => {
+                if !sd_card.initialized {
+                    return SD_ERROR_NOT_INITIALIZED;
+                }
+                sd_card.byte_swap = operation == 4;
+                SD_OK
+            }
+            6 => {
+                if validate_address_length(address, 16, true) {
+                    return SD_ERROR_INVALID_ADDRESS;
+                }
+                self.memory_write(address as usize, &[0; 16]);
+                SD_OK
+            }
+            _ => SD_ERROR_INVALID_OPERATION,
+        }
+    }
+
+    fn sd_card_transfer(&mut self, write: bool, address: u32, sector: u32, count: u32) -> u32 {
+        if count >= SD_MAX_SECTOR_COUNT {
+            return SD_ERROR_INVALID_ARGUMENT;
+        }
+        let length = count as usize * SD_SECTOR_SIZE;
+        if validate_address_length(address, length as u32, true) {
+            return SD_ERROR_INVALID_ADDRESS;
+        }
+        let Some(sd_card) = &mut self.sd_card else {
+            return SD_ERROR_NOT_INITIALIZED;
+        };
+        if !sd_card.initialized {
+            return SD_ERROR_NOT_INITIALIZED;
+        }
+        if count == 0 {
+            return SD_ERROR_INVALID_ARGUMENT;
+        }
+        let io_error = if write {
+            SD_ERROR_CMD25_IO
+        } else {
+            SD_ERROR_CMD18_IO
+        };
+        if (sector as u64 + count as u64) > sd_card.sectors {
+            return io_error;
+        }
+        let address = address as usize;
+        let offset = SeekFrom::Start(sector as u64 * SD_SECTOR_SIZE as u64);
+        let byte_swap = sd_card.byte_swap;
+        if write {
+            let mut buffer = self.memory[address..(address + length)].to_vec();
+            if byte_swap {
+                swap_bytes(&mut buffer);
+            }
+            if sd_card.file.seek(offset).is_err() || sd_card.file.write_all(&buffer).is_err() {
+                return io_error;
+            }
+        } else {
+            let mut buffer = vec![0u8; length];
+            if sd_card.file.seek(offset).is_err() || sd_card.file.read_exact(&mut buffer).is_err() {
+                return io_error;
+            }
+            if byte_swap {
+                swap_bytes(&mut buffer);
+            }
+            self.memory_write(address, &buffer);
+        }
+        SD_OK
+    }
+
+    fn process_events(&mut self) {
+        let now = Instant::now();
+
+        if self
+            .usb_flush_deadline
+            .is_some_and(|deadline| now >= deadline)
+        {
+            self.usb_flush_deadline = None;
+            self.send_packet(b'G', &[]);
+        }
+
+        if self
+            .writeback_deadline
+            .is_some_and(|deadline| now >= deadline)
+        {
+            self.writeback_deadline = None;
+            if let Some((address, length)) = self.save_area() {
+                let mut packet = self.config[CFG_ID_SAVE_TYPE].to_be_bytes().to_vec();
+                packet.extend_from_slice(&self.memory[address..(address + length)]);
+                self.send_packet(b'S', &packet);
+            }
+        }
+
+        self.process_isv();
+        self.process_dd();
+        self.process_telemetry(now);
+    }
+
+    fn telemetry_op_done(&mut self, op: usize, start: Instant) {
+        let latency_us = start.elapsed().as_micros().min(u32::MAX as u128) as u32;
+        let [count, latency_total_us, latency_max_us] = &mut self.telemetry_ops[op];
+        *count = count.wrapping_add(1);
+        *latency_total_us = latency_total_us.wrapping_add(latency_us);
+        *latency_max_us = (*latency_max_us).max(latency_us);
+    }
+
+    fn process_telemetry(&mut self, now: Instant) {
+        self.loop_count = self.loop_count.wrapping_add(1);
+        let period = match self.telemetry_period {
+            Some(period) if now >= self.telemetry_deadline => period,
+            _ => return,
+        };
+        self.telemetry_deadline = now + period;
+        let mut words = vec![
+            TELEMETRY_VERSION,
+            (now - self.started).as_micros() as u32,
+            self.loop_count,
+            POLL_TIMEOUT.as_micros() as u32,
+            3300,
+            250,
+            self.input.len().min(0x7FF) as u32,
+            self.output.len().min(0x7FF) as u32,
+            if self.writeback_deadline.is_some() {
+                1
+            } else {
+                0
+            },
+        ];
+        for op in self.telemetry_ops.iter_mut() {
+            words.extend_from_slice(op);
+            op[2] = 0;
+        }
+        self.send_packet(b'Q', &words_to_bytes(&words));
+    }
+
+    fn process_isv(&mut self) {
+        let address = self.config[CFG_ID_ISV_ADDRESS] as usize;
+        if address == 0 {
+            return;
+        }
+
+        if self.get_memory_u32(ISV_SETUP_TOKEN_ADDRESS) == ISV_TOKEN {
+            self.set_memory_u32(ISV_SETUP_TOKEN_ADDRESS, 0);
+            self.set_memory_u32(ISV_SETUP_OFFSET_ADDRESS, (address as u32) | 0x1000_0000);
+            self.set_memory_u32(ISV_SETUP_READY_ADDRESS, ISV_TOKEN);
+            return;
+        }
+
+        if self.get_memory_u32(address + ISV_TOKEN_OFFSET) != ISV_TOKEN {
+            return;
+        }
+
+        let read_pointer = self.get_memory_u32(address + ISV_READ_POINTER_OFFSET);
+        let write_pointer = self.get_memory_u32(address + ISV_WRITE_POINTER_OFFSET);
+        if read_pointer >= ISV_BUFFER_SIZE
+            || write_pointer >= ISV_BUFFER_SIZE
+            || read_pointer == write_pointer
+        {
+            return;
+        }
+
+        let wrap = write_pointer < read_pointer;
+        let end = if wrap { ISV_BUFFER_SIZE } else { write_pointer };
+        let start = address + ISV_BUFFER_OFFSET;
+        let text = self.memory[(start + read_pointer as usize)..(start + end as usize)].to_vec();
+        self.send_packet(b'I', &text);
+        self.set_memory_u32(
+            address + ISV_READ_POINTER_OFFSET,
+            if wrap { 0 } else { write_pointer },
+        );
+    }
+
+    fn process_dd(&mut self) {
+        let usb_mode = (self.config[CFG_ID_DD_MODE] & DD_MODE_REGS) != 0
+            && self.config[CFG_ID_DD_SD_ENABLE] == 0
+            && self.config[CFG_ID_DD_DISK_STATE] == DD_DISK_STATE_INSERTED;
+        if !usb_mode || self.dd_pending || self.dd_reads == 0 {
+            return;
+        }
+        let block = self.dd_next_block;
+        let track_head_block = ((block >> 1) << 2) | (block & 1);
+        self.send_packet(
+            b'D',
+            &words_to_bytes(&[DD_COMMAND_READ, DD_BLOCK_BUFFER_ADDRESS, track_head_block]),
+        );
+        self.dd_pending = true;
+        self.dd_request_time = Instant::now();
+        self.dd_next_block += 1;
+        self.dd_reads -= 1;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::super::{
+        types::{
+            DataPacket, DdDiskState, DdDriveType, DdMode, DebugPacket, DiskPacketKind,
+            FlashBlockAction, MemoryTestOp, MemoryTestPattern, SaveType,
+        },
+        SC64,
+    };
+    use std::time::{Duration, Instant};
+
+    const PACKET_TIMEOUT: Duration = Duration::from_secs(5);
+
+    fn open(options: &str) -> SC64 {
+        SC64::open_local(Some(format!("emu://{options}"))).unwrap()
+    }
+
+    fn receive_packet(sc64: &mut SC64) -> DataPacket {
+        let timeout = Instant::now();
+        loop {
+            if let Some(packet) = sc64.receive_data_packet().unwrap() {
+                return packet;
+            }
+            assert!(
+                timeout.elapsed() < PACKET_TIMEOUT,
+                "No data packet received"
+            );
+        }
+    }
+
+    #[test]
+    fn identifier_and_version() {
+        let mut sc64 = open("");
+        sc64.check_device().unwrap();
+        assert_eq!(sc64.check_firmware_version().unwrap(), (2, 20, 0));
+    }
+
+    #[test]
+    fn memory_read_write() {
+        let mut sc64 = open("");
+        let data: Vec<u8> = (0..4096).map(|i| (i * 7) as u8).collect();
+        sc64.command_memory_write(0x0010_0000, &data).unwrap();
+        assert_eq!(
+            sc64.command_memory_read(0x0010_0000, data.len()).unwrap(),
+            data
+        );
+        assert!(sc64
+            .command_memory_read(super::MEMORY_LENGTH as u32, 4)
+            .is_err());
+        assert!(sc64
+            .command_memory_write(super::BOOTLOADER_ADDRESS as u32, &[0; 4])
+            .is_err());
+    }
+
+    #[test]
+    fn debug_packet_loopback() {
+        let mut sc64 = open("");
+        let data = b"loopback".to_vec();
+        sc64.send_debug_packet(DebugPacket {
+            datatype: 0x01,
+            data: data.clone().into(),
+        })
+        .unwrap();
+        match receive_packet(&mut sc64) {
+            DataPacket::DebugData(packet) => {
+                assert_eq!(packet.datatype, 0x01);
+                assert_eq!(*packet.data, data);
+            }
+            _ => panic!("Unexpected data packet"),
+        }
+    }
+
+    #[test]
+    fn dd_block_request() {
+        let mut sc64 = open("dd_reads=2");
+        sc64.configure_64dd(DdMode::Full, Some(DdDriveType::Retail))
+            .unwrap();
+        sc64.set_64dd_disk_state(DdDiskState::Inserted).unwrap();
+        for block in 0..2 {
+            let mut packet = match receive_packet(&mut sc64) {
+                DataPacket::DiskRequest(packet) => packet,
+                _ => panic!("Unexpected data packet"),
+            };
+            assert!(matches!(packet.kind, DiskPacketKind::Read));
+            assert_eq!(packet.info.address, super::DD_BLOCK_BUFFER_ADDRESS);
+            assert_eq!(
+                (packet.info.track, packet.info.head, packet.info.block),
+                (0, 0, block)
+            );
+            let data = vec![0xA0 | block as u8; 256];
+            packet.info.set_data(&data);
+            sc64.reply_disk_packet(Some(packet)).unwrap();
+            assert_eq!(
+                sc64.command_memory_read(super::DD_BLOCK_BUFFER_ADDRESS, data.len())
+                    .unwrap(),
+                data
+            );
+        }
+    }
+
+    #[test]
+    fn flash_background_erase_skips_unchanged_blocks() {
+        let mut sc64 = open("");
+        let block_size = super::FLASH_ERASE_BLOCK_SIZE;
+        let address = super::FLASH_ADDRESS as u32;
+        let current: Vec<u8> = [0x00, 0x22, 0x33, 0xFF, 0x00]
+            .iter()
+            .flat_map(|value| vec![*value; block_size])
+            .collect();
+        let new: Vec<u8> = [0x11, 0x22, 0x44, 0x0F, 0x55]
+            .iter()
+            .flat_map(|value| vec![*value; block_size])
+            .collect();
+        sc64.command_memory_write(address, &current).unwrap();
+
+        let mut plans = vec![sc64
+            .flash_prepare(&mut new.as_slice(), address, new.len(), None)
+            .unwrap()];
+        sc64.flash_erase_in_background(&mut plans).unwrap();
+        assert!(matches!(
+            plans[0].actions[..],
+            [
+                FlashBlockAction::ErasedInBackground,
+                FlashBlockAction::Unchanged,
+                FlashBlockAction::ErasedInBackground,
+                FlashBlockAction::Program,
+                FlashBlockAction::ErasedInBackground,
+            ]
+        ));
+        assert_eq!(
+            sc64.command_memory_read(address + block_size as u32, block_size)
+                .unwrap(),
+            vec![0x22; block_size]
+        );
+
+        let stats = sc64.flash_write(plans.remove(0)).unwrap();
+        assert_eq!(
+            (
+                stats.unchanged,
+                stats.programmed,
+                stats.erased_in_background
+            ),
+            (1, 1, 3)
+        );
+        assert_eq!(sc64.command_memory_read(address, new.len()).unwrap(), new);
+    }
+
+    #[test]
+    fn memory_test_reports_mismatches() {
+        let mut sc64 = open("");
+        let start = |pattern, write, verify| MemoryTestOp::Start {
+            pattern,
+            seed: 0x1234,
+            write,
+            verify,
+        };
+
+        sc64.command_memory_test(start(MemoryTestPattern::Custom(0x12345678), true, false))
+            .unwrap();
+        assert_eq!(
+            sc64.command_memory_read(0x0010_0000, 4).unwrap(),
+            vec![0x12, 0x34, 0x56, 0x78]
+        );
+        sc64.command_memory_write(0x0010_0000, &[0x12, 0x34, 0x00, 0x00])
+            .unwrap();
+
+        let status = sc64
+            .command_memory_test(start(MemoryTestPattern::Custom(0x12345678), false, true))
+            .unwrap();
+        assert_eq!(status.error_count, 1);
+        assert_eq!(status.error, (0x0010_0002, (0x5678, 0x0000)));
+    }
+
+    #[test]
+    fn save_writeback() {
+        let mut sc64 = open("");
+        sc64.set_save_type(SaveType::Eeprom4k).unwrap();
+        sc64.set_save_writeback(true).unwrap();
+        let data: Vec<u8> = (0..512).map(|i| i as u8).collect();
+        sc64.command_memory_write(super::EEPROM_ADDRESS as u32, &data)
+            .unwrap();
+        match receive_packet(&mut sc64) {
+            DataPacket::SaveWriteback(writeback) => {
+                assert!(matches!(writeback.save, SaveType::Eeprom4k));
+                assert_eq!(*writeback.data, data);
+            }
+            _ => panic!("Unexpected data packet"),
+        }
+    }
+}
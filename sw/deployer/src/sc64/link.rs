@@ -1,4 +1,4 @@
-use super::{error::Error, ftdi::FtdiDevice, serial::SerialDevice};
+use super::{emulator::EmulatedDevice, error::Error, ftdi::FtdiDevice, serial::SerialDevice};
 use std::{
     collections::VecDeque,
     fmt::Display,
@@ -54,13 +54,97 @@ pub enum UsbPacket {
     AsynchronousPacket(AsynchronousPacket),
 }
 
+#[derive(Clone, Copy, Default)]
+pub struct PacketBufferStats {
+    pub packets: u64,
+    pub reused: u64,
+    pub recycled: u64,
+    pub allocations: u64,
+    pub allocated_bytes: u64,
+}
+
+impl Display for PacketBufferStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_fmt(format_args!(
+            "{} packets received, {} buffers reused, {} buffers returned, {} allocations ({:.1} kiB)",
+            self.packets,
+            self.reused,
+            self.recycled,
+            self.allocations,
+            self.allocated_bytes as f64 / 1024.0
+        ))
+    }
+}
+
+#[derive(Default)]
+pub struct PacketBufferPool {
+    buffers: Vec<Vec<u8>>,
+    stats: PacketBufferStats,
+}
+
+impl PacketBufferPool {
+    pub fn take(&mut self, length: usize) -> Vec<u8> {
+        self.stats.packets += 1;
+        if length == 0 {
+            return Vec::new();
+        }
+        let fitting = self
+            .buffers
+            .iter()
+            .enumerate()
+            .filter(|(_, buffer)| buffer.capacity() >= length)
+            .min_by_key(|(_, buffer)| buffer.capacity())
+            .map(|(index, _)| index);
+        let largest = self
+            .buffers
+            .iter()
+            .enumerate()
+            .max_by_key(|(_, buffer)| buffer.capacity())
+            .map(|(index, _)| index);
+        let mut buffer = match fitting.or(largest) {
+            Some(index) => self.buffers.swap_remove(index),
+            None => Vec::new(),
+        };
+        if buffer.capacity() >= length {
+            self.stats.reused += 1;
+        } else {
+            self.stats.allocations += 1;
+            self.stats.allocated_bytes += length as u64;
+        }
+        buffer.clear();
+        buffer.resize(length, 0);
+        buffer
+    }
+
+    pub fn recycle(&mut self, buffer: Vec<u8>) {
+        let capacity = buffer.capacity();
+        if capacity == 0 {
+            return;
+        }
+        self.stats.recycled += 1;
+        if capacity <= PACKET_BUFFER_MAX_RETAINED_LENGTH
+            && self.buffers.len() < PACKET_BUFFER_POOL_SIZE
+        {
+            self.buffers.push(buffer);
+        }
+    }
+
+    pub fn stats(&self) -> PacketBufferStats {
+        self.stats
+    }
+}
+
 const SERIAL_PREFIX: &str = "serial://";
 const FTDI_PREFIX: &str = "ftdi://";
+const EMULATOR_PREFIX: &str = "emu://";
 
 const RESET_TIMEOUT: Duration = Duration::from_secs(1);
 const POLL_TIMEOUT: Duration = Duration::from_millis(5);
 const IO_TIMEOUT: Duration = Duration::from_secs(10);
 
+const PACKET_BUFFER_POOL_SIZE: usize = 8;
+const PACKET_BUFFER_MAX_RETAINED_LENGTH: usize = 2 * 1024 * 1024;
+
 pub trait Backend {
     fn read(&mut self, buffer: &mut [u8]) -> std::io::Result<usize>;
 
@@ -178,6 +262,7 @@ pub trait Backend {
         &mut self,
         data_type: DataType,
         packets: &mut VecDeque<AsynchronousPacket>,
+        pool: &mut PacketBufferPool,
     ) -> std::io::Result<Option<Response>> {
         let block = matches!(data_type, DataType::Response);
 
@@ -195,7 +280,7 @@ pub trait Backend {
             self.read_exact(&mut buffer)?;
             let length = u32::from_be_bytes(buffer) as usize;
 
-            let mut data = vec![0u8; length];
+            let mut data = pool.take(length);
             self.read_exact(&mut data)?;
 
             if packet_token {
@@ -292,6 +377,46 @@ fn new_ftdi_backend(port: &str) -> std::io::Result<FtdiBackend> {
     })
 }
 
+struct EmulatorBackend {
+    device: EmulatedDevice,
+}
+
+impl Backend for EmulatorBackend {
+    fn read(&mut self, buffer: &mut [u8]) -> std::io::Result<usize> {
+        self.device.read(buffer)
+    }
+
+    fn write_all(&mut self, buffer: &[u8]) -> std::io::Result<()> {
+        self.device.write_all(buffer)
+    }
+
+    fn flush(&mut self) -> std::io::Result<()> {
+        self.device.flush()
+    }
+
+    fn discard_input(&mut self) -> std::io::Result<()> {
+        self.device.discard_input()
+    }
+
+    fn discard_output(&mut self) -> std::io::Result<()> {
+        self.device.discard_output()
+    }
+
+    fn set_dtr(&mut self, value: bool) -> std::io::Result<()> {
+        self.device.set_dtr(value)
+    }
+
+    fn read_dsr(&mut self) -> std::io::Result<bool> {
+        self.device.read_dsr()
+    }
+}
+
+fn new_emulator_backend(options: &str) -> Result<EmulatorBackend, Error> {
+    Ok(EmulatorBackend {
+        device: EmulatedDevice::new(options)?,
+    })
+}
+
 struct TcpBackend {
     stream: TcpStream,
     reader: BufReader<TcpStream>,
@@ -336,6 +461,7 @@ impl Backend for TcpBackend {
         &mut self,
         data_type: DataType,
         packets: &mut VecDeque<AsynchronousPacket>,
+        pool: &mut PacketBufferPool,
     ) -> std::io::Result<Option<Response>> {
         let block = matches!(data_type, DataType::Response);
         while let Some(header) = self.try_read_header(block)? {
@@ -345,13 +471,13 @@ impl Backend for TcpBackend {
             let mut buffer = [0u8; 4];
             match payload_data_type {
                 DataType::Response => {
-                    let mut response_info = vec![0u8; 2];
+                    let mut response_info = [0u8; 2];
                     self.read_exact(&mut response_info)?;
 
                     self.read_exact(&mut buffer)?;
                     let response_data_length = u32::from_be_bytes(buffer) as usize;
 
-                    let mut data = vec![0u8; response_data_length];
+                    let mut data = pool.take(response_data_length);
                     self.read_exact(&mut data)?;
 
                     return Ok(Some(Response {
@@ -361,13 +487,13 @@ impl Backend for TcpBackend {
                     }));
                 }
                 DataType::Packet => {
-                    let mut packet_info = vec![0u8; 1];
+                    let mut packet_info = [0u8; 1];
                     self.read_exact(&mut packet_info)?;
 
                     self.read_exact(&mut buffer)?;
                     let packet_data_length = u32::from_be_bytes(buffer) as usize;
 
-                    let mut data = vec![0u8; packet_data_length];
+                    let mut data = pool.take(packet_data_length);
                     self.read_exact(&mut data)?;
 
                     packets.push_back(AsynchronousPacket {
@@ -411,6 +537,10 @@ fn new_local_backend(port: &str) -> Result<Box<dyn Backend>, Error> {
         Box::new(new_ftdi_backend(
             port.strip_prefix(FTDI_PREFIX).unwrap_or_default(),
         )?)
+    } else if port.starts_with(EMULATOR_PREFIX) {
+        Box::new(new_emulator_backend(
+            port.strip_prefix(EMULATOR_PREFIX).unwrap_or_default(),
+        )?)
     } else {
         return Err(Error::new("Invalid port prefix provided"));
     };
@@ -425,6 +555,7 @@ fn new_remote_backend(address: &str) -> Result<Box<dyn Backend>, Error> {
 pub struct Link {
     backend: Box<dyn Backend>,
     packets: VecDeque<AsynchronousPacket>,
+    pool: PacketBufferPool,
 }
 
 impl Link {
@@ -460,10 +591,11 @@ impl Link {
     }
 
     pub fn receive_response(&mut self) -> Result<Response, Error> {
-        match self
-            .backend
-            .process_incoming_data(DataType::Response, &mut self.packets)
-        {
+        match self.backend.process_incoming_data(
+            DataType::Response,
+            &mut self.packets,
+            &mut self.pool,
+        ) {
             Ok(response) => match response {
                 Some(response) => Ok(response),
                 None => Err(Error::new("No response was received")),
@@ -476,9 +608,11 @@ impl Link {
 
     pub fn receive_packet(&mut self) -> Result<Option<AsynchronousPacket>, Error> {
         if self.packets.len() == 0 {
-            let response = self
-                .backend
-                .process_incoming_data(DataType::Packet, &mut self.packets)?;
+            let response = self.backend.process_incoming_data(
+                DataType::Packet,
+                &mut self.packets,
+                &mut self.pool,
+            )?;
             if response.is_some() {
                 return Err(Error::new("Unexpected command response in data stream"));
             }
@@ -487,9 +621,11 @@ impl Link {
     }
 
     pub fn receive_response_or_packet(&mut self) -> Result<Option<UsbPacket>, Error> {
-        let response = self
-            .backend
-            .process_incoming_data(DataType::Packet, &mut self.packets)?;
+        let response = self.backend.process_incoming_data(
+            DataType::Packet,
+            &mut self.packets,
+            &mut self.pool,
+        )?;
         if let Some(response) = response {
             return Ok(Some(UsbPacket::Response(response)));
         }
@@ -498,6 +634,14 @@ impl Link {
         }
         Ok(None)
     }
+
+    pub fn recycle_buffer(&mut self, buffer: Vec<u8>) {
+        self.pool.recycle(buffer);
+    }
+
+    pub fn packet_buffer_stats(&self) -> PacketBufferStats {
+        self.pool.stats()
+    }
 }
 
 impl Drop for Link {
@@ -510,6 +654,7 @@ pub fn new_local(port: &str) -> Result<Link, Error> {
     Ok(Link {
         backend: new_local_backend(port)?,
         packets: VecDeque::new(),
+        pool: PacketBufferPool::default(),
     })
 }
 
@@ -517,6 +662,7 @@ pub fn new_remote(address: &str) -> Result<Link, Error> {
     Ok(Link {
         backend: new_remote_backend(address)?,
         packets: VecDeque::new(),
+        pool: PacketBufferPool::default(),
     })
 }
 
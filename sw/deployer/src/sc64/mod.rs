@@ -1,4 +1,5 @@
 mod cic;
+mod emulator;
 mod error;
 pub mod ff;
 pub mod firmware;
@@ -11,14 +12,15 @@ mod types;
 
 pub use self::{
     error::Error,
-    link::list_local_devices,
+    link::{list_local_devices, PacketBufferStats},
     server::ServerEvent,
     types::{
         AuxMessage, BootMode, ButtonMode, ButtonState, CicSeed, CicStep, DataPacket, DdDiskState,
         DdDriveType, DdMode, DebugPacket, DiagnosticData, DiskPacket, DiskPacketKind,
-        FpgaDebugData, ISViewer, MemoryTestPattern, MemoryTestPatternResult, SaveType,
-        SaveWriteback, SdCardInfo, SdCardOpPacket, SdCardResult, SdCardStatus, SpeedTestDirection,
-        Switch, TvType,
+        FirmwareUpdateStats, FlashProgramStats, FpgaDebugData, ISViewer, MemoryTestPattern,
+        MemoryTestPatternResult, PacketData, SaveType, SaveWriteback, SdCardInfo, SdCardOpPacket,
+        SdCardResult, SdCardStats, SdCardStatus, SpeedTestDirection, Switch, Telemetry,
+        TelemetryOp, TvType,
     },
 };
 
@@ -27,15 +29,17 @@ use self::{
     link::Link,
     time::{convert_from_datetime, convert_to_datetime},
     types::{
-        get_config, get_setting, Config, ConfigId, FirmwareStatus, SdCardOp, Setting, SettingId,
-        UpdateStatus,
+        get_config, get_setting, Config, ConfigId, FirmwareStatus, FlashBlockAction,
+        FlashProgramPlan, MemoryTestOp, MemoryTestStatus, SdCardOp, Setting, SettingId,
+        UpdateStatus, MEMORY_TEST_ERROR_LOG_LENGTH,
     },
 };
 use chrono::NaiveDateTime;
 use rand::Rng;
 use std::{
     cmp::min,
-    io::{Read, Seek, Write},
+    collections::VecDeque,
+    io::{Read, Seek, SeekFrom, Write},
     thread::sleep,
     time::{Duration, Instant},
 };
@@ -113,6 +117,14 @@ pub const MEMORY_LENGTH: usize = 0x0500_2C80;
 
 const MEMORY_CHUNK_LENGTH: usize = 1 * 1024 * 1024;
 
+const MEMORY_DUMP_CHUNK_LENGTH: usize = 4 * 1024 * 1024;
+const MEMORY_DUMP_PIPELINE_DEPTH: usize = 2;
+
+const MEMORY_TEST_TIMEOUT: Duration = Duration::from_secs(60);
+
+const FLASH_ERASE_TIMEOUT: Duration = Duration::from_secs(300);
+const FLASH_ERASE_RANGES: usize = 8; // Controller background erase queue depth
+
 impl SC64 {
     fn command_identifier_get(&mut self) -> Result<[u8; 4], Error> {
         let data = self.link.execute_command(b'v', [0, 0], &[])?;
@@ -317,6 +329,24 @@ impl SC64 {
         Ok(())
     }
 
+    fn command_flash_erase_range(&mut self, address: u32, length: usize) -> Result<(), Error> {
+        self.link
+            .execute_command(b'E', [address, length as u32], &[])?;
+        Ok(())
+    }
+
+    fn command_flash_erase_status(&mut self) -> Result<(bool, u32), Error> {
+        let data = self.link.execute_command(b'e', [0, 0], &[])?;
+        if data.len() != 8 {
+            return Err(Error::new(
+                "Invalid data length received for flash erase status command",
+            ));
+        }
+        let busy = u32::from_be_bytes(data[0..4].try_into().unwrap()) != 0;
+        let remaining = u32::from_be_bytes(data[4..8].try_into().unwrap());
+        Ok((busy, remaining))
+    }
+
     fn command_firmware_backup(&mut self, address: u32) -> Result<(FirmwareStatus, u32), Error> {
         let data = self
             .link
@@ -347,6 +377,11 @@ impl SC64 {
         Ok(u32::from_be_bytes(data[0..4].try_into().unwrap()).try_into()?)
     }
 
+    fn command_memory_test(&mut self, op: MemoryTestOp) -> Result<MemoryTestStatus, Error> {
+        let data = self.link.execute_command(b'b', op.into(), &[])?;
+        Ok(data.try_into()?)
+    }
+
     fn command_fpga_debug_data_get(&mut self) -> Result<FpgaDebugData, Error> {
         let data = self.link.execute_command(b'?', [0, 0], &[])?;
         Ok(data.try_into()?)
@@ -356,6 +391,11 @@ impl SC64 {
         let data = self.link.execute_command(b'%', [0, 0], &[])?;
         Ok(data.try_into()?)
     }
+
+    fn command_telemetry_set(&mut self, period_ms: u32) -> Result<(), Error> {
+        self.link.execute_command(b'Q', [period_ms, 0], &[])?;
+        Ok(())
+    }
 }
 
 impl SC64 {
@@ -364,7 +404,7 @@ impl SC64 {
         reader: &mut T,
         length: usize,
         no_shadow: bool,
-    ) -> Result<(), Error> {
+    ) -> Result<FlashProgramStats, Error> {
         if length > MAX_ROM_LENGTH {
             return Err(Error::new("ROM length too big"));
         }
@@ -397,31 +437,44 @@ impl SC64 {
             min(length, SDRAM_LENGTH)
         };
 
-        self.memory_write_chunked(reader, SDRAM_ADDRESS, sdram_length, Some(endian_swapper))?;
+        let mut flash_plans = vec![];
 
-        self.command_config_set(Config::RomShadowEnable(rom_shadow_enabled.into()))?;
         if rom_shadow_enabled {
             let rom_shadow_length = min(length - sdram_length, ROM_SHADOW_LENGTH);
-            self.flash_program(
+            reader.seek(SeekFrom::Start(sdram_length as u64))?;
+            flash_plans.push(self.flash_prepare(
                 reader,
                 ROM_SHADOW_ADDRESS,
                 rom_shadow_length,
                 Some(endian_swapper),
-            )?;
+            )?);
         }
 
-        self.command_config_set(Config::RomExtendedEnable(rom_extended_enabled.into()))?;
         if rom_extended_enabled {
             let rom_extended_length = min(length - SDRAM_LENGTH, ROM_EXTENDED_LENGTH);
-            self.flash_program(
+            reader.seek(SeekFrom::Start(SDRAM_LENGTH as u64))?;
+            flash_plans.push(self.flash_prepare(
                 reader,
                 ROM_EXTENDED_ADDRESS,
                 rom_extended_length,
                 Some(endian_swapper),
-            )?;
+            )?);
         }
 
-        Ok(())
+        self.flash_erase_in_background(&mut flash_plans)?;
+
+        reader.rewind()?;
+        self.memory_write_chunked(reader, SDRAM_ADDRESS, sdram_length, Some(endian_swapper))?;
+
+        self.command_config_set(Config::RomShadowEnable(rom_shadow_enabled.into()))?;
+        self.command_config_set(Config::RomExtendedEnable(rom_extended_enabled.into()))?;
+
+        let mut flash_stats = FlashProgramStats::default();
+        for plan in flash_plans {
+            flash_stats += self.flash_write(plan)?;
+        }
+
+        Ok(flash_stats)
     }
 
     pub fn upload_ddipl<T: Read>(&mut self, reader: &mut T, length: usize) -> Result<(), Error> {
@@ -474,16 +527,47 @@ impl SC64 {
         self.memory_read_chunked(writer, address, save_length)
     }
 
-    pub fn dump_memory<T: Write>(
+    pub fn dump_memory(
         &mut self,
-        writer: &mut T,
         address: u32,
         length: usize,
+        consumer: &mut dyn FnMut(Vec<u8>) -> Result<(), Error>,
     ) -> Result<(), Error> {
-        if address + length as u32 > MEMORY_LENGTH as u32 {
+        if address as usize + length > MEMORY_LENGTH {
             return Err(Error::new("Invalid dump address or length"));
         }
-        self.memory_read_chunked(writer, address, length)
+        let end = address as usize + length;
+        let mut next_address = address as usize;
+        let mut pending: VecDeque<usize> = VecDeque::new();
+        loop {
+            while pending.len() < MEMORY_DUMP_PIPELINE_DEPTH && next_address < end {
+                let bytes = min(MEMORY_DUMP_CHUNK_LENGTH, end - next_address);
+                self.link.execute_command_raw(
+                    b'm',
+                    [next_address as u32, bytes as u32],
+                    &[],
+                    true,
+                    false,
+                )?;
+                pending.push_back(bytes);
+                next_address += bytes;
+            }
+            let bytes = match pending.pop_front() {
+                Some(bytes) => bytes,
+                None => break,
+            };
+            let response = self.link.receive_response()?;
+            if response.id != b'm' || response.error {
+                return Err(Error::new("Memory read command response error"));
+            }
+            if response.data.len() != bytes {
+                return Err(Error::new(
+                    "Invalid data length received for memory read command",
+                ));
+            }
+            consumer(response.data)?;
+        }
+        Ok(())
     }
 
     pub fn calculate_cic_parameters(&mut self, custom_seed: Option<u8>) -> Result<(), Error> {
@@ -602,13 +686,31 @@ impl SC64 {
         Ok(())
     }
 
+    pub fn set_telemetry_period(&mut self, period: Option<Duration>) -> Result<(), Error> {
+        let period_ms = match period {
+            Some(period) => period.as_millis().clamp(1, u32::MAX as u128) as u32,
+            None => 0,
+        };
+        self.command_telemetry_set(period_ms)
+    }
+
     pub fn receive_data_packet(&mut self) -> Result<Option<DataPacket>, Error> {
-        if let Some(packet) = self.link.receive_packet()? {
-            return Ok(Some(packet.try_into()?));
+        if let Some(mut packet) = self.link.receive_packet()? {
+            let data_packet = (&mut packet).try_into();
+            self.link.recycle_buffer(packet.data);
+            return Ok(Some(data_packet?));
         }
         Ok(None)
     }
 
+    pub fn recycle_buffer(&mut self, buffer: Vec<u8>) {
+        self.link.recycle_buffer(buffer);
+    }
+
+    pub fn packet_buffer_stats(&self) -> PacketBufferStats {
+        self.link.packet_buffer_stats()
+    }
+
     pub fn reply_disk_packet(&mut self, disk_packet: Option<DiskPacket>) -> Result<(), Error> {
         if let Some(packet) = disk_packet {
             match packet.kind {
@@ -617,6 +719,7 @@ impl SC64 {
                 }
                 DiskPacketKind::Write => {}
             }
+            self.link.recycle_buffer(packet.info.data.into_buffer());
             self.command_dd_set_block_ready(false)?;
         } else {
             self.command_dd_set_block_ready(true)?;
@@ -695,6 +798,24 @@ impl SC64 {
         Ok(info.try_into()?)
     }
 
+    pub fn get_sd_card_stats(&mut self) -> Result<SdCardStats, Error> {
+        const SD_CARD_STATS_BUFFER_ADDRESS: u32 = 0x0500_2BE0;
+        let stats = match self
+            .command_sd_card_operation(SdCardOp::GetStats(SD_CARD_STATS_BUFFER_ADDRESS))?
+        {
+            SdCardOpPacket {
+                result: SdCardResult::OK,
+                status: _,
+            } => self.command_memory_read(SD_CARD_STATS_BUFFER_ADDRESS, 16)?,
+            packet => {
+                return Err(Error::new(
+                    format!("Couldn't get SD card statistics: {}", packet.result).as_str(),
+                ))
+            }
+        };
+        Ok(stats.try_into()?)
+    }
+
     pub fn read_sd_card(&mut self, data: &mut [u8], sector: u32) -> Result<SdCardResult, Error> {
         if data.len() % SD_CARD_SECTOR_SIZE != 0 {
             return Err(Error::new(
@@ -787,8 +908,13 @@ impl SC64 {
         self.command_memory_read(FIRMWARE_ADDRESS_SDRAM, length as usize)
     }
 
-    pub fn update_firmware(&mut self, data: &[u8], use_flash_memory: bool) -> Result<(), Error> {
+    pub fn update_firmware(
+        &mut self,
+        data: &[u8],
+        use_flash_memory: bool,
+    ) -> Result<FirmwareUpdateStats, Error> {
         const FLASH_UPDATE_SUPPORTED_MINOR_VERSION: u16 = 19;
+        let mut update_stats = FirmwareUpdateStats::default();
         let status = if use_flash_memory {
             let unsupported_version_error = Error::new(format!(
                 "Your firmware doesn't support updating from Flash memory, minimum required version: {}.{}.x",
@@ -806,9 +932,8 @@ impl SC64 {
                 })
                 .map_err(|_| unsupported_version_error.clone())?;
             self.command_state_reset()?;
-            self.flash_erase(FIRMWARE_ADDRESS_FLASH, data.len())?;
-            self.command_memory_write(FIRMWARE_ADDRESS_FLASH, data)?;
-            self.command_flash_wait_busy(true)?;
+            update_stats.flash =
+                self.flash_program(&mut &data[..], FIRMWARE_ADDRESS_FLASH, data.len(), None)?;
             self.command_firmware_update(FIRMWARE_ADDRESS_FLASH, data.len())?
         } else {
             self.command_state_reset()?;
@@ -824,11 +949,16 @@ impl SC64 {
         let mut last_update_status = UpdateStatus::Err;
         loop {
             if let Some(packet) = self.receive_data_packet()? {
-                if let DataPacket::UpdateStatus(status) = packet {
-                    match status {
+                if let DataPacket::UpdateStatus(progress) = packet {
+                    if let Some(elapsed) = progress.elapsed {
+                        if !matches!(last_update_status, UpdateStatus::Err) {
+                            update_stats.steps.push((last_update_status, elapsed));
+                        }
+                    }
+                    match progress.status {
                         UpdateStatus::Done => {
                             std::thread::sleep(Duration::from_secs(2));
-                            return Ok(());
+                            return Ok(update_stats);
                         }
                         UpdateStatus::Err => {
                             return Err(Error::new(
@@ -925,58 +1055,153 @@ impl SC64 {
         pattern: MemoryTestPattern,
         fade: Option<u64>,
     ) -> Result<MemoryTestPatternResult, Error> {
-        let item_size = std::mem::size_of::<u32>();
-        let mut test_data = vec![0u32; SDRAM_LENGTH / item_size];
-
-        match pattern {
-            MemoryTestPattern::OwnAddress(inverted) => {
-                for (index, item) in test_data.iter_mut().enumerate() {
-                    let mut value = (index * item_size) as u32;
-                    if inverted {
-                        value ^= 0xFFFFFFFFu32;
-                    }
-                    *item = value;
-                }
-            }
-            MemoryTestPattern::AllZeros => test_data.fill(0x00000000u32),
-            MemoryTestPattern::AllOnes => test_data.fill(0xFFFFFFFFu32),
-            MemoryTestPattern::Custom(pattern) => test_data.fill(pattern),
-            MemoryTestPattern::Random => rand::thread_rng().fill(&mut test_data[..]),
-        };
+        let seed = rand::thread_rng().gen_range(1..=u16::MAX);
 
-        let raw_test_data: Vec<u8> = test_data.iter().flat_map(|v| v.to_be_bytes()).collect();
-        let mut writer: &[u8] = &raw_test_data;
-        self.memory_write_chunked(&mut writer, SDRAM_ADDRESS, SDRAM_LENGTH, None)?;
+        self.command_memory_test(MemoryTestOp::Start {
+            pattern,
+            seed,
+            write: true,
+            verify: fade.is_none(),
+        })?;
+        self.memory_test_wait()?;
 
         if let Some(fade) = fade {
             sleep(Duration::from_secs(fade));
+            self.command_memory_test(MemoryTestOp::Start {
+                pattern,
+                seed,
+                write: false,
+                verify: true,
+            })?;
+            self.memory_test_wait()?;
         }
 
-        let mut raw_check_data = vec![0u8; SDRAM_LENGTH];
-        let mut reader: &mut [u8] = &mut raw_check_data;
-        self.memory_read_chunked(&mut reader, SDRAM_ADDRESS, SDRAM_LENGTH)?;
-        let check_data = raw_check_data
-            .chunks(4)
-            .map(|a| u32::from_be_bytes(a[0..4].try_into().unwrap()));
-
-        let all_errors: Vec<(usize, (u32, u32))> = test_data
-            .into_iter()
-            .zip(check_data)
-            .enumerate()
-            .filter(|(_, (a, b))| a != b)
-            .map(|(i, (a, b))| (i * item_size, (a, b)))
-            .collect();
-
-        let first_error = if all_errors.len() > 0 {
-            Some(all_errors.get(0).copied().unwrap())
-        } else {
-            None
-        };
+        let error_count = self
+            .command_memory_test(MemoryTestOp::GetStatus(0))?
+            .error_count;
+
+        let mut logged_errors = vec![];
+        for index in 0..min(error_count, MEMORY_TEST_ERROR_LOG_LENGTH) {
+            logged_errors.push(
+                self.command_memory_test(MemoryTestOp::GetStatus(index))?
+                    .error,
+            );
+        }
+
+        Ok(MemoryTestPatternResult {
+            first_error: logged_errors.first().copied(),
+            logged_errors,
+            error_count,
+        })
+    }
 
-        return Ok(MemoryTestPatternResult {
-            first_error,
-            all_errors,
-        });
+    fn memory_test_wait(&mut self) -> Result<(), Error> {
+        let timeout = Instant::now();
+        while self.command_memory_test(MemoryTestOp::GetStatus(0))?.busy {
+            if timeout.elapsed() > MEMORY_TEST_TIMEOUT {
+                self.command_memory_test(MemoryTestOp::Stop)?;
+                return Err(Error::new("SDRAM self test took too long"));
+            }
+            sleep(Duration::from_millis(10));
+        }
+        Ok(())
+    }
+
+    pub fn bench_usb_transfer(
+        &mut self,
+        direction: SpeedTestDirection,
+        chunk_length: usize,
+        total_length: usize,
+    ) -> Result<Duration, Error> {
+        if chunk_length == 0 || total_length > SDRAM_LENGTH {
+            return Err(Error::new("Invalid USB benchmark transfer length"));
+        }
+
+        let data = vec![0x00; chunk_length];
+
+        let time = Instant::now();
+
+        for offset in (0..total_length).step_by(chunk_length) {
+            let address = SDRAM_ADDRESS + offset as u32;
+            let length = min(chunk_length, total_length - offset);
+            match direction {
+                SpeedTestDirection::Read => {
+                    self.command_memory_read(address, length)?;
+                }
+                SpeedTestDirection::Write => {
+                    self.command_memory_write(address, &data[0..length])?;
+                }
+            }
+        }
+
+        Ok(time.elapsed())
+    }
+
+    pub fn bench_command_latency(&mut self) -> Result<Duration, Error> {
+        let time = Instant::now();
+        self.command_identifier_get()?;
+        Ok(time.elapsed())
+    }
+
+    pub fn bench_sd_card_read(&mut self, sector: u32, count: u32) -> Result<Duration, Error> {
+        if (count as usize * SD_CARD_SECTOR_SIZE) > SD_CARD_BUFFER_LENGTH {
+            return Err(Error::new("SD card benchmark request too big"));
+        }
+        let time = Instant::now();
+        match self.command_sd_card_read(SD_CARD_BUFFER_ADDRESS, sector, count)? {
+            SdCardResult::OK => Ok(time.elapsed()),
+            result => Err(Error::new(
+                format!("Read SD card failed: {result}").as_str(),
+            )),
+        }
+    }
+
+    pub fn bench_sd_card_rewrite(&mut self, sector: u32, count: u32) -> Result<Duration, Error> {
+        self.bench_sd_card_read(sector, count)?;
+        let time = Instant::now();
+        match self.command_sd_card_write(SD_CARD_BUFFER_ADDRESS, sector, count)? {
+            SdCardResult::OK => Ok(time.elapsed()),
+            result => Err(Error::new(
+                format!("Write SD card failed: {result}").as_str(),
+            )),
+        }
+    }
+
+    pub fn bench_flash(&mut self) -> Result<(usize, Duration, Duration), Error> {
+        let erase_block_size = self.command_flash_wait_busy(false)? as usize;
+        let address = ROM_EXTENDED_ADDRESS + (ROM_EXTENDED_LENGTH - erase_block_size) as u32;
+
+        let mut data = vec![0u8; erase_block_size];
+        rand::thread_rng().fill(&mut data[..]);
+
+        let time = Instant::now();
+        self.flash_erase(address, erase_block_size)?;
+        self.command_flash_wait_busy(true)?;
+        let erase_time = time.elapsed();
+
+        let time = Instant::now();
+        self.command_memory_write(address, &data)?;
+        self.command_flash_wait_busy(true)?;
+        let program_time = time.elapsed();
+
+        Ok((erase_block_size, erase_time, program_time))
+    }
+
+    /// Host side of a 64DD block transfer (block upload and ready flag), there is no pending
+    /// request from the console so this is only a proxy for the real block service latency
+    pub fn bench_dd_block_upload(&mut self, length: usize) -> Result<Duration, Error> {
+        let data = vec![0x00; length];
+        let time = Instant::now();
+        self.command_memory_write(SD_CARD_BUFFER_ADDRESS, &data)?;
+        self.command_dd_set_block_ready(false)?;
+        Ok(time.elapsed())
+    }
+
+    /// Plain read of the save area, a proxy for the transfer part of a save writeback
+    pub fn bench_save_read(&mut self, length: usize) -> Result<Duration, Error> {
+        let time = Instant::now();
+        self.command_memory_read(SAVE_ADDRESS, length)?;
+        Ok(time.elapsed())
     }
 
     fn memory_read_chunked(
@@ -1035,18 +1260,133 @@ impl SC64 {
         address: u32,
         length: usize,
         transform: Option<fn(&mut [u8])>,
-    ) -> Result<(), Error> {
-        self.flash_erase(address, length)?;
-        self.memory_write_chunked(reader, address, length, transform)?;
-        self.command_flash_wait_busy(true)?;
+    ) -> Result<FlashProgramStats, Error> {
+        let plan = self.flash_prepare(reader, address, length, transform)?;
+        self.flash_write(plan)
+    }
+
+    fn flash_prepare(
+        &mut self,
+        reader: &mut dyn Read,
+        address: u32,
+        length: usize,
+        transform: Option<fn(&mut [u8])>,
+    ) -> Result<FlashProgramPlan, Error> {
+        let erase_block_size = self.command_flash_wait_busy(false)? as usize;
+        let mut data: Vec<u8> = Vec::with_capacity(length);
+        reader.take(length as u64).read_to_end(&mut data)?;
+        if let Some(transform) = transform {
+            transform(&mut data);
+        }
+        let mut actions = vec![];
+        for (index, block) in data.chunks(erase_block_size).enumerate() {
+            let block_address = address + (index * erase_block_size) as u32;
+            let current = self.command_memory_read(block_address, block.len())?;
+            let only_clears_bits = current
+                .iter()
+                .zip(block.iter())
+                .all(|(current, new)| (current & new) == *new);
+            actions.push(if current == block {
+                FlashBlockAction::Unchanged
+            } else if only_clears_bits {
+                FlashBlockAction::Program
+            } else {
+                FlashBlockAction::Erase
+            });
+        }
+        Ok(FlashProgramPlan {
+            address,
+            erase_block_size,
+            data,
+            actions,
+        })
+    }
+
+    fn flash_erase_in_background(&mut self, plans: &mut [FlashProgramPlan]) -> Result<(), Error> {
+        // Only contiguous runs of blocks that need erasing are queued, unchanged and program-only
+        // blocks are never erased. Runs beyond the controller queue depth are erased in the foreground.
+        let is_erase = |action: &FlashBlockAction| matches!(action, FlashBlockAction::Erase);
+        let mut ranges = 0;
+        for plan in plans.iter_mut() {
+            let mut index = 0;
+            while ranges < FLASH_ERASE_RANGES {
+                let Some(first) = plan.actions[index..].iter().position(is_erase) else {
+                    break;
+                };
+                let first = index + first;
+                let end = plan.actions[first..]
+                    .iter()
+                    .position(|action| !is_erase(action))
+                    .map_or(plan.actions.len(), |end| first + end);
+                let address = plan.address + (first * plan.erase_block_size) as u32;
+                let length = (end - first) * plan.erase_block_size;
+                self.command_flash_erase_range(address, length)?;
+                for action in plan.actions[first..end].iter_mut() {
+                    *action = FlashBlockAction::ErasedInBackground;
+                }
+                ranges += 1;
+                index = end;
+            }
+        }
         Ok(())
     }
+
+    fn flash_wait_erase(&mut self) -> Result<Duration, Error> {
+        let wait_start = Instant::now();
+        loop {
+            let (busy, _) = self.command_flash_erase_status()?;
+            if !busy {
+                break;
+            }
+            if wait_start.elapsed() > FLASH_ERASE_TIMEOUT {
+                return Err(Error::new("Flash erase timeout"));
+            }
+            sleep(Duration::from_millis(10));
+        }
+        Ok(wait_start.elapsed())
+    }
+
+    fn flash_write(&mut self, plan: FlashProgramPlan) -> Result<FlashProgramStats, Error> {
+        let mut stats = FlashProgramStats::default();
+        let erasing_in_background = plan
+            .actions
+            .iter()
+            .any(|action| matches!(action, FlashBlockAction::ErasedInBackground));
+        if erasing_in_background {
+            stats.erase_wait = self.flash_wait_erase()?;
+        }
+        let blocks = plan.data.chunks(plan.erase_block_size);
+        for (index, (action, block)) in plan.actions.iter().zip(blocks).enumerate() {
+            let block_address = plan.address + (index * plan.erase_block_size) as u32;
+            stats.blocks += 1;
+            match action {
+                FlashBlockAction::Unchanged => {
+                    stats.unchanged += 1;
+                    continue;
+                }
+                FlashBlockAction::Program => stats.programmed += 1,
+                FlashBlockAction::Erase => {
+                    let erase_start = Instant::now();
+                    self.command_flash_erase_block(block_address)?;
+                    stats.erase_time += erase_start.elapsed();
+                    stats.erased += 1;
+                }
+                FlashBlockAction::ErasedInBackground => stats.erased_in_background += 1,
+            }
+            self.command_memory_write(block_address, block)?;
+        }
+        self.command_flash_wait_busy(true)?;
+        Ok(stats)
+    }
 }
 
 impl SC64 {
     pub fn open_local(port: Option<String>) -> Result<Self, Error> {
         let mut sc64 = SC64 {
-            link: link::new_local(&port.unwrap_or(list_local_devices()?[0].port.clone()))?,
+            link: link::new_local(&match port {
+                Some(port) => port,
+                None => list_local_devices()?[0].port.clone(),
+            })?,
         };
         sc64.check_device()?;
         Ok(sc64)
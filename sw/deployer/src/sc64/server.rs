@@ -81,7 +81,7 @@ impl StreamHandler {
         }
     }
 
-    fn send_response(&mut self, response: Response) -> std::io::Result<()> {
+    fn send_response(&mut self, response: &Response) -> std::io::Result<()> {
         self.writer
             .write_all(&u32::to_be_bytes(DataType::Response.into()))?;
         self.writer.write_all(&[response.id])?;
@@ -93,7 +93,7 @@ impl StreamHandler {
         Ok(())
     }
 
-    fn send_packet(&mut self, packet: AsynchronousPacket) -> std::io::Result<()> {
+    fn send_packet(&mut self, packet: &AsynchronousPacket) -> std::io::Result<()> {
         self.writer
             .write_all(&u32::to_be_bytes(DataType::Packet.into()))?;
         self.writer.write_all(&[packet.id])?;
@@ -131,8 +131,14 @@ fn server_accept_connection(port: String, connection: &mut StreamHandler) -> Res
 
         if let Some(usb_packet) = link.receive_response_or_packet()? {
             match usb_packet {
-                UsbPacket::Response(response) => connection.send_response(response)?,
-                UsbPacket::AsynchronousPacket(packet) => connection.send_packet(packet)?,
+                UsbPacket::Response(response) => {
+                    connection.send_response(&response)?;
+                    link.recycle_buffer(response.data);
+                }
+                UsbPacket::AsynchronousPacket(packet) => {
+                    connection.send_packet(&packet)?;
+                    link.recycle_buffer(packet.data);
+                }
             }
         }
 
@@ -1,5 +1,10 @@
 use super::{link::AsynchronousPacket, Error};
-use std::fmt::Display;
+use std::{
+    fmt::Display,
+    mem::take,
+    ops::{Deref, DerefMut},
+    time::Duration,
+};
 
 #[derive(Clone, Copy)]
 pub enum ConfigId {
@@ -621,21 +626,23 @@ pub enum DataPacket {
     DiskRequest(DiskPacket),
     IsViewer64(Vec<u8>),
     SaveWriteback(SaveWriteback),
-    UpdateStatus(UpdateStatus),
+    Telemetry(Telemetry),
+    UpdateStatus(UpdateProgress),
 }
 
-impl TryFrom<AsynchronousPacket> for DataPacket {
+impl TryFrom<&mut AsynchronousPacket> for DataPacket {
     type Error = Error;
-    fn try_from(value: AsynchronousPacket) -> Result<Self, Self::Error> {
+    fn try_from(value: &mut AsynchronousPacket) -> Result<Self, Self::Error> {
         Ok(match value.id {
-            b'X' => Self::AuxData(value.data.try_into()?),
+            b'X' => Self::AuxData(value.data.as_slice().try_into()?),
             b'B' => Self::Button,
             b'G' => Self::DataFlushed,
-            b'U' => Self::DebugData(value.data.try_into()?),
-            b'D' => Self::DiskRequest(value.data.try_into()?),
-            b'I' => Self::IsViewer64(value.data),
-            b'S' => Self::SaveWriteback(value.data.try_into()?),
-            b'F' => Self::UpdateStatus(value.data.try_into()?),
+            b'U' => Self::DebugData(take(&mut value.data).try_into()?),
+            b'D' => Self::DiskRequest(take(&mut value.data).try_into()?),
+            b'I' => Self::IsViewer64(take(&mut value.data)),
+            b'S' => Self::SaveWriteback(take(&mut value.data).try_into()?),
+            b'F' => Self::UpdateStatus(value.data.as_slice().try_into()?),
+            b'Q' => Self::Telemetry(value.data.as_slice().try_into()?),
             _ => return Err(Error::new("Unknown data packet code")),
         })
     }
@@ -660,9 +667,9 @@ impl From<AuxMessage> for u32 {
     }
 }
 
-impl TryFrom<Vec<u8>> for AuxMessage {
+impl TryFrom<&[u8]> for AuxMessage {
     type Error = Error;
-    fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
+    fn try_from(value: &[u8]) -> Result<Self, Self::Error> {
         if value.len() != 4 {
             return Err(Error::new("Invalid data length for AUX data packet"));
         }
@@ -675,9 +682,54 @@ impl TryFrom<Vec<u8>> for AuxMessage {
     }
 }
 
+/// Payload of a received packet, decoded header stays at the front of the buffer and is skipped
+/// with an offset so the payload is never moved
+#[derive(Clone, Default)]
+pub struct PacketData {
+    buffer: Vec<u8>,
+    offset: usize,
+}
+
+impl PacketData {
+    fn with_header(buffer: Vec<u8>, header_length: usize) -> Self {
+        Self {
+            buffer,
+            offset: header_length,
+        }
+    }
+
+    pub fn set(&mut self, data: &[u8]) {
+        self.buffer.truncate(self.offset);
+        self.buffer.extend_from_slice(data);
+    }
+
+    pub fn into_buffer(self) -> Vec<u8> {
+        self.buffer
+    }
+}
+
+impl From<Vec<u8>> for PacketData {
+    fn from(value: Vec<u8>) -> Self {
+        Self::with_header(value, 0)
+    }
+}
+
+impl Deref for PacketData {
+    type Target = [u8];
+    fn deref(&self) -> &Self::Target {
+        &self.buffer[self.offset..]
+    }
+}
+
+impl DerefMut for PacketData {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        &mut self.buffer[self.offset..]
+    }
+}
+
 pub struct DebugPacket {
     pub datatype: u8,
-    pub data: Vec<u8>,
+    pub data: PacketData,
 }
 
 impl TryFrom<Vec<u8>> for DebugPacket {
@@ -689,7 +741,7 @@ impl TryFrom<Vec<u8>> for DebugPacket {
         let header = u32::from_be_bytes(value[0..4].try_into().unwrap());
         let datatype = ((header >> 24) & 0xFF) as u8;
         let length = (header & 0x00FFFFFF) as usize;
-        let data = value[4..].to_vec();
+        let data = PacketData::with_header(value, 4);
         if data.len() != length {
             return Err(Error::new("Debug packet length did not match"));
         }
@@ -721,7 +773,7 @@ impl TryFrom<Vec<u8>> for DiskPacket {
             track: (track_head_block >> 2) & 0xFFF,
             head: (track_head_block >> 1) & 0x01,
             block: track_head_block & 0x01,
-            data: value[12..].to_vec(),
+            data: PacketData::with_header(value, 12),
         };
         Ok(match command {
             1 => DiskPacket {
@@ -744,6 +796,7 @@ pub enum SdCardOp {
     GetInfo(u32),
     ByteSwapOn,
     ByteSwapOff,
+    GetStats(u32),
 }
 
 impl From<SdCardOp> for [u32; 2] {
@@ -755,6 +808,7 @@ impl From<SdCardOp> for [u32; 2] {
             SdCardOp::GetInfo(address) => [address, 3],
             SdCardOp::ByteSwapOn => [0, 4],
             SdCardOp::ByteSwapOff => [0, 5],
+            SdCardOp::GetStats(address) => [address, 6],
         }
     }
 }
@@ -877,6 +931,9 @@ impl TryFrom<Vec<u8>> for SdCardResult {
 }
 
 pub struct SdCardStatus {
+    pub clock_khz: u16,
+    pub sample_delay: u8,
+    pub clock_tuned: bool,
     pub byte_swap: bool,
     pub clock_mode_50mhz: bool,
     pub card_type_block: bool,
@@ -888,11 +945,18 @@ impl Display for SdCardStatus {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         if self.card_initialized {
             f.write_str("Initialized, ")?;
-            f.write_str(if self.clock_mode_50mhz {
-                "50 MHz"
+            if self.clock_khz > 0 {
+                f.write_fmt(format_args!("{:.1} MHz", self.clock_khz as f32 / 1000.0))?;
             } else {
-                "25 MHz"
-            })?;
+                f.write_str(if self.clock_mode_50mhz {
+                    "50 MHz"
+                } else {
+                    "25 MHz"
+                })?;
+            }
+            if self.clock_tuned {
+                f.write_fmt(format_args!(" (tuned, sample delay {})", self.sample_delay))?;
+            }
             if !self.card_type_block {
                 f.write_str(", byte addressed")?;
             }
@@ -923,6 +987,9 @@ impl TryFrom<Vec<u8>> for SdCardStatus {
         }
         let status = u32::from_be_bytes(value[4..8].try_into().unwrap());
         return Ok(Self {
+            clock_khz: (status >> 16) as u16,
+            sample_delay: ((status >> 6) & 0x03) as u8,
+            clock_tuned: status & (1 << 5) != 0,
             byte_swap: status & (1 << 4) != 0,
             clock_mode_50mhz: status & (1 << 3) != 0,
             card_type_block: status & (1 << 2) != 0,
@@ -972,23 +1039,56 @@ impl TryFrom<Vec<u8>> for SdCardInfo {
     }
 }
 
+pub struct SdCardStats {
+    pub crc_errors: u32,
+    pub retries: u32,
+    pub fallbacks: u32,
+    pub failures: u32,
+}
+
+impl TryFrom<Vec<u8>> for SdCardStats {
+    type Error = Error;
+    fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
+        if value.len() != 16 {
+            return Err(Error::new(
+                "Incorrect data length for SD card statistics data packet",
+            ));
+        }
+        Ok(SdCardStats {
+            crc_errors: u32::from_be_bytes(value[0..4].try_into().unwrap()),
+            retries: u32::from_be_bytes(value[4..8].try_into().unwrap()),
+            fallbacks: u32::from_be_bytes(value[8..12].try_into().unwrap()),
+            failures: u32::from_be_bytes(value[12..16].try_into().unwrap()),
+        })
+    }
+}
+
+impl Display for SdCardStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_fmt(format_args!(
+            "{} CRC errors, {} retries, {} clock fallbacks, {} failed transfers",
+            self.crc_errors, self.retries, self.fallbacks, self.failures
+        ))
+    }
+}
+
 pub struct DiskBlock {
     pub address: u32,
     pub track: u32,
     pub head: u32,
     pub block: u32,
-    pub data: Vec<u8>,
+    pub data: PacketData,
 }
 
 impl DiskBlock {
     pub fn set_data(&mut self, data: &[u8]) {
-        self.data = data.to_vec();
+        self.data.set(data);
     }
 }
 
 pub struct SaveWriteback {
     pub save: SaveType,
-    pub data: Vec<u8>,
+    pub data: PacketData,
 }
 
 impl TryFrom<Vec<u8>> for SaveWriteback {
@@ -1000,8 +1100,10 @@ impl TryFrom<Vec<u8>> for SaveWriteback {
             ));
         }
         let save: SaveType = u32::from_be_bytes(value[0..4].try_into().unwrap()).try_into()?;
-        let data = value[4..].to_vec();
-        Ok(SaveWriteback { save, data })
+        Ok(SaveWriteback {
+            save,
+            data: PacketData::with_header(value, 4),
+        })
     }
 }
 
@@ -1045,6 +1147,7 @@ impl TryFrom<u32> for FirmwareStatus {
     }
 }
 
+#[derive(Clone, Copy)]
 pub enum UpdateStatus {
     MCU,
     FPGA,
@@ -1065,9 +1168,9 @@ impl Display for UpdateStatus {
     }
 }
 
-impl TryFrom<Vec<u8>> for UpdateStatus {
+impl TryFrom<&[u8]> for UpdateStatus {
     type Error = Error;
-    fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
+    fn try_from(value: &[u8]) -> Result<Self, Self::Error> {
         if value.len() != 4 {
             return Err(Error::new(
                 "Incorrect data length for update status data packet",
@@ -1084,6 +1187,133 @@ impl TryFrom<Vec<u8>> for UpdateStatus {
     }
 }
 
+pub struct UpdateProgress {
+    pub status: UpdateStatus,
+    pub elapsed: Option<Duration>,
+}
+
+impl TryFrom<&[u8]> for UpdateProgress {
+    type Error = Error;
+    fn try_from(value: &[u8]) -> Result<Self, Self::Error> {
+        if value.len() != 4 && value.len() != 8 {
+            return Err(Error::new(
+                "Incorrect data length for update status data packet",
+            ));
+        }
+        Ok(UpdateProgress {
+            status: value[0..4].try_into()?,
+            elapsed: value.get(4..8).map(|elapsed| {
+                Duration::from_millis(u32::from_be_bytes(elapsed.try_into().unwrap()) as u64)
+            }),
+        })
+    }
+}
+
+#[derive(Default)]
+pub struct FirmwareUpdateStats {
+    pub flash: FlashProgramStats,
+    pub steps: Vec<(UpdateStatus, Duration)>,
+}
+
+impl Display for FirmwareUpdateStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let mut total = Duration::ZERO;
+        for (status, elapsed) in self.steps.iter() {
+            f.write_fmt(format_args!("{status} {:.2} s, ", elapsed.as_secs_f64()))?;
+            total += *elapsed;
+        }
+        f.write_fmt(format_args!("total {:.2} s", total.as_secs_f64()))
+    }
+}
+
+#[derive(Clone, Copy)]
+pub enum TelemetryOp {
+    SdCard,
+    Usb,
+    Dd,
+    Writeback,
+    FlashRam,
+}
+
+impl TelemetryOp {
+    pub const ALL: [TelemetryOp; 5] = [
+        TelemetryOp::SdCard,
+        TelemetryOp::Usb,
+        TelemetryOp::Dd,
+        TelemetryOp::Writeback,
+        TelemetryOp::FlashRam,
+    ];
+
+    pub fn name(&self) -> &'static str {
+        match self {
+            TelemetryOp::SdCard => "sd",
+            TelemetryOp::Usb => "usb",
+            TelemetryOp::Dd => "dd",
+            TelemetryOp::Writeback => "writeback",
+            TelemetryOp::FlashRam => "flashram",
+        }
+    }
+}
+
+#[derive(Clone, Copy, Default)]
+pub struct TelemetryOpStats {
+    pub count: u32,
+    pub latency_total_us: u32,
+    pub latency_max_us: u32,
+}
+
+pub struct Telemetry {
+    pub timestamp_us: u32,
+    pub loop_count: u32,
+    pub loop_period_max_us: u32,
+    pub voltage: f32,
+    pub temperature: f32,
+    pub usb_rx_fifo_count: u32,
+    pub usb_tx_fifo_count: u32,
+    pub writeback_pending: bool,
+    pub flashram_pending: bool,
+    pub ops: [TelemetryOpStats; 5],
+}
+
+impl TryFrom<&[u8]> for Telemetry {
+    type Error = Error;
+    fn try_from(value: &[u8]) -> Result<Self, Self::Error> {
+        if value.len() < 96 {
+            return Err(Error::new(
+                "Incorrect data length for telemetry data packet",
+            ));
+        }
+        let words: Vec<u32> = value
+            .chunks_exact(4)
+            .map(|word| u32::from_be_bytes(word.try_into().unwrap()))
+            .collect();
+        if words[0] != 1 {
+            return Err(Error::new("Unknown telemetry data packet version"));
+        }
+        let mut ops = [TelemetryOpStats::default(); 5];
+        for (index, op) in ops.iter_mut().enumerate() {
+            let offset = 9 + (index * 3);
+            *op = TelemetryOpStats {
+                count: words[offset],
+                latency_total_us: words[offset + 1],
+                latency_max_us: words[offset + 2],
+            };
+        }
+        Ok(Telemetry {
+            timestamp_us: words[1],
+            loop_count: words[2],
+            loop_period_max_us: words[3],
+            voltage: words[4] as f32 / 1000.0,
+            temperature: words[5] as i32 as f32 / 10.0,
+            usb_rx_fifo_count: words[6],
+            usb_tx_fifo_count: words[7],
+            writeback_pending: (words[8] & (1 << 0)) != 0,
+            flashram_pending: (words[8] & (1 << 1)) != 0,
+            ops,
+        })
+    }
+}
+
 pub enum PiIODirection {
     Read,
     Write,
@@ -1210,10 +1440,9 @@ impl Display for CicStep {
     }
 }
 
-impl From<&[u8; 8]> for CicStep {
-    fn from(value: &[u8; 8]) -> Self {
-        let cic_step = (value[7] >> 4) & 0x0F;
-        match cic_step {
+impl From<u8> for CicStep {
+    fn from(value: u8) -> Self {
+        match value {
             0 => Self::Unavailable,
             1 => Self::PowerOff,
             2 => Self::ConfigLoad,
@@ -1234,23 +1463,75 @@ impl From<&[u8; 8]> for CicStep {
     }
 }
 
+impl From<&[u8; 8]> for CicStep {
+    fn from(value: &[u8; 8]) -> Self {
+        ((value[7] >> 4) & 0x0F).into()
+    }
+}
+
+const CIC_MARGIN_FIRST_STEP: u8 = 3;
+const CIC_MARGIN_UNIT_US: f32 = 0.16;
+
+pub struct CicTimingMargins {
+    margins: [u8; 8],
+}
+
+impl From<&[u8; 8]> for CicTimingMargins {
+    fn from(value: &[u8; 8]) -> Self {
+        CicTimingMargins { margins: *value }
+    }
+}
+
+impl Display for CicTimingMargins {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let mut first = true;
+        for (step, margin) in (CIC_MARGIN_FIRST_STEP..).zip(self.margins.iter()) {
+            if *margin == 0xFF {
+                continue;
+            }
+            if !first {
+                f.write_str(", ")?;
+            }
+            first = false;
+            let limit = if *margin == 0xFE { ">" } else { "" };
+            f.write_fmt(format_args!(
+                "{}: {limit}{:.2} us",
+                CicStep::from(step),
+                *margin as f32 * CIC_MARGIN_UNIT_US
+            ))?;
+        }
+        if first {
+            f.write_str("Not measured")?;
+        }
+        Ok(())
+    }
+}
+
 pub struct FpgaDebugData {
     pub pi_io_access: PiIOAccess,
     pub pi_fifo_flags: PiFifoFlags,
     pub cic_step: CicStep,
+    pub cic_margins: Option<CicTimingMargins>,
 }
 
 impl TryFrom<Vec<u8>> for FpgaDebugData {
     type Error = Error;
     fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
-        if value.len() != 8 {
+        if value.len() != 8 && value.len() != 16 {
             return Err(Error::new("Invalid data length for FPGA debug data"));
         }
         let data: &[u8; 8] = &value[0..8].try_into().unwrap();
+        let cic_margins = if value.len() == 16 {
+            let margins: &[u8; 8] = &value[8..16].try_into().unwrap();
+            Some(margins.into())
+        } else {
+            None
+        };
         Ok(FpgaDebugData {
             pi_io_access: data.into(),
             pi_fifo_flags: data.into(),
             cic_step: data.into(),
+            cic_margins,
         })
     }
 }
@@ -1338,17 +1619,105 @@ pub enum SpeedTestDirection {
     Write,
 }
 
+#[derive(Clone, Copy)]
 pub enum MemoryTestPattern {
     OwnAddress(bool),
     AllZeros,
     AllOnes,
+    Walking(bool),
     Random,
     Custom(u32),
 }
 
 pub struct MemoryTestPatternResult {
-    pub first_error: Option<(usize, (u32, u32))>,
-    pub all_errors: Vec<(usize, (u32, u32))>,
+    pub first_error: Option<(usize, (u16, u16))>,
+    pub logged_errors: Vec<(usize, (u16, u16))>,
+    pub error_count: u32,
+}
+
+pub const MEMORY_TEST_ERROR_LOG_LENGTH: u32 = 4;
+
+pub enum MemoryTestOp {
+    Start {
+        pattern: MemoryTestPattern,
+        seed: u16,
+        write: bool,
+        verify: bool,
+    },
+    Stop,
+    GetStatus(u32),
+}
+
+impl From<MemoryTestOp> for [u32; 2] {
+    fn from(value: MemoryTestOp) -> Self {
+        const WRITE_PASS: u32 = 1 << 0;
+        const VERIFY_PASS: u32 = 1 << 1;
+        const INVERT: u32 = 1 << 2;
+        const STOP: u32 = 1 << 3;
+        const PATTERN_BIT: u32 = 4;
+        const ERROR_BIT: u32 = 8;
+
+        const PATTERN_CONSTANT: u32 = 0;
+        const PATTERN_OWN_ADDRESS: u32 = 1;
+        const PATTERN_WALKING: u32 = 2;
+        const PATTERN_LFSR: u32 = 3;
+
+        match value {
+            MemoryTestOp::Start {
+                pattern,
+                seed,
+                write,
+                verify,
+            } => {
+                let passes =
+                    (if write { WRITE_PASS } else { 0 }) | (if verify { VERIFY_PASS } else { 0 });
+                let (control, data) = match pattern {
+                    MemoryTestPattern::OwnAddress(inverted) => (
+                        (PATTERN_OWN_ADDRESS << PATTERN_BIT) | (if inverted { INVERT } else { 0 }),
+                        0,
+                    ),
+                    MemoryTestPattern::AllZeros => (PATTERN_CONSTANT << PATTERN_BIT, 0x00000000),
+                    MemoryTestPattern::AllOnes => (PATTERN_CONSTANT << PATTERN_BIT, 0xFFFFFFFF),
+                    MemoryTestPattern::Walking(inverted) => (
+                        (PATTERN_WALKING << PATTERN_BIT) | (if inverted { INVERT } else { 0 }),
+                        0,
+                    ),
+                    MemoryTestPattern::Random => (PATTERN_LFSR << PATTERN_BIT, seed as u32),
+                    MemoryTestPattern::Custom(pattern) => {
+                        (PATTERN_CONSTANT << PATTERN_BIT, pattern)
+                    }
+                };
+                [passes | control, data]
+            }
+            MemoryTestOp::Stop => [STOP, 0],
+            MemoryTestOp::GetStatus(error_index) => [error_index << ERROR_BIT, 0],
+        }
+    }
+}
+
+pub struct MemoryTestStatus {
+    pub busy: bool,
+    pub error_count: u32,
+    pub error: (usize, (u16, u16)),
+}
+
+impl TryFrom<Vec<u8>> for MemoryTestStatus {
+    type Error = Error;
+    fn try_from(value: Vec<u8>) -> Result<Self, Self::Error> {
+        if value.len() != 16 {
+            return Err(Error::new("Invalid data length for memory test status"));
+        }
+        let busy = u32::from_be_bytes(value[0..4].try_into().unwrap()) != 0;
+        let error_count = u32::from_be_bytes(value[4..8].try_into().unwrap());
+        let address = u32::from_be_bytes(value[8..12].try_into().unwrap()) as usize;
+        let written = u16::from_be_bytes(value[12..14].try_into().unwrap());
+        let read = u16::from_be_bytes(value[14..16].try_into().unwrap());
+        Ok(MemoryTestStatus {
+            busy,
+            error_count,
+            error: (address, (written, read)),
+        })
+    }
 }
 
 impl Display for MemoryTestPattern {
@@ -1360,6 +1729,11 @@ impl Display for MemoryTestPattern {
             )),
             MemoryTestPattern::AllZeros => f.write_str("All zeros"),
             MemoryTestPattern::AllOnes => f.write_str("All ones"),
+            MemoryTestPattern::Walking(inverted) => f.write_str(if *inverted {
+                "Walking zeros"
+            } else {
+                "Walking ones"
+            }),
             MemoryTestPattern::Random => f.write_str("Random"),
             MemoryTestPattern::Custom(pattern) => {
                 f.write_fmt(format_args!("Pattern 0x{pattern:08X}"))
@@ -1368,6 +1742,76 @@ impl Display for MemoryTestPattern {
     }
 }
 
+pub enum FlashBlockAction {
+    Unchanged,
+    Program,
+    Erase,
+    ErasedInBackground,
+}
+
+pub struct FlashProgramPlan {
+    pub address: u32,
+    pub erase_block_size: usize,
+    pub data: Vec<u8>,
+    pub actions: Vec<FlashBlockAction>,
+}
+
+#[derive(Default)]
+pub struct FlashProgramStats {
+    pub blocks: usize,
+    pub unchanged: usize,
+    pub programmed: usize,
+    pub erased: usize,
+    pub erased_in_background: usize,
+    pub erase_time: Duration,
+    pub erase_wait: Duration,
+}
+
+impl FlashProgramStats {
+    pub fn erase_time_saved(&self) -> Option<Duration> {
+        if self.erased == 0 {
+            return None;
+        }
+        let erases_skipped = (self.unchanged + self.programmed) as u32;
+        Some((self.erase_time / self.erased as u32) * erases_skipped)
+    }
+}
+
+impl std::ops::AddAssign for FlashProgramStats {
+    fn add_assign(&mut self, rhs: Self) {
+        self.blocks += rhs.blocks;
+        self.unchanged += rhs.unchanged;
+        self.programmed += rhs.programmed;
+        self.erased += rhs.erased;
+        self.erased_in_background += rhs.erased_in_background;
+        self.erase_time += rhs.erase_time;
+        self.erase_wait += rhs.erase_wait;
+    }
+}
+
+impl Display for FlashProgramStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_fmt(format_args!(
+            "{} blocks, {} unchanged, {} programmed without erase, {} erased",
+            self.blocks, self.unchanged, self.programmed, self.erased
+        ))?;
+        if self.erased_in_background > 0 {
+            f.write_fmt(format_args!(
+                ", {} erased in background (waited {:.1} s)",
+                self.erased_in_background,
+                self.erase_wait.as_secs_f64()
+            ))?;
+        }
+        if let Some(saved) = self.erase_time_saved() {
+            f.write_fmt(format_args!(
+                ", ~{:.1} s of erase time saved",
+                saved.as_secs_f64()
+            ))?;
+        }
+        Ok(())
+    }
+}
+
 macro_rules! get_config {
     ($sc64:ident, $config:ident) => {{
         if let Config::$config(value) = $sc64.command_config_get(ConfigId::$config)? {